@@ -0,0 +1,142 @@
+#shader vertex
+#version 400 core
+
+// Control points of bicubic patches, 16 per GL_PATCHES patch, row major with u as the row
+layout(location = 0) in vec3 position;
+
+out vec3 tc_Position;
+
+void main()
+{
+    tc_Position = position;
+}
+
+#shader tess_control
+#version 400 core
+
+layout(vertices = 16) out;
+
+in vec3 tc_Position[];
+out vec3 te_Position[];
+
+uniform mat4 u_Model;
+uniform vec3 u_CameraPosition;
+uniform float u_PixelsPerUnit;  // viewportHeight / (2 tan(fov / 2))
+uniform float u_SegmentPixels;  // Wanted on screen length of one segment
+
+// Segments for the edge through control points a, b, c, d. Only the edge's own points are used,
+// added up the same way in both directions, so patches sharing the edge pick the same level
+float EdgeLevel(int a, int b, int c, int d)
+{
+    vec3 p0 = vec3(u_Model * vec4(tc_Position[a], 1.0));
+    vec3 p1 = vec3(u_Model * vec4(tc_Position[b], 1.0));
+    vec3 p2 = vec3(u_Model * vec4(tc_Position[c], 1.0));
+    vec3 p3 = vec3(u_Model * vec4(tc_Position[d], 1.0));
+
+    // The control polygon is at least as long as the curve
+    float edgeLength = (distance(p0, p1) + distance(p3, p2)) + distance(p1, p2);
+    vec3 center = ((p0 + p3) + (p1 + p2)) * 0.25;
+    float cameraDistance = max(distance(center, u_CameraPosition) - 0.5 * edgeLength, 0.01);
+    return clamp(edgeLength * u_PixelsPerUnit / (cameraDistance * u_SegmentPixels), 1.0, 64.0);
+}
+
+void main()
+{
+    te_Position[gl_InvocationID] = tc_Position[gl_InvocationID];
+
+    if (gl_InvocationID == 0)
+    {
+        // Outer levels: u = 0, v = 0, u = 1, v = 1
+        gl_TessLevelOuter[0] = EdgeLevel(0, 1, 2, 3);
+        gl_TessLevelOuter[1] = EdgeLevel(0, 4, 8, 12);
+        gl_TessLevelOuter[2] = EdgeLevel(12, 13, 14, 15);
+        gl_TessLevelOuter[3] = EdgeLevel(3, 7, 11, 15);
+
+        // Inner levels along u, then along v
+        gl_TessLevelInner[0] = max(gl_TessLevelOuter[1], gl_TessLevelOuter[3]);
+        gl_TessLevelInner[1] = max(gl_TessLevelOuter[0], gl_TessLevelOuter[2]);
+    }
+}
+
+#shader tess_evaluation
+#version 400 core
+
+layout(quads, equal_spacing, ccw) in;
+
+in vec3 te_Position[];
+
+out vec3 v_Normal;
+out vec3 v_FragPos;
+out vec3 v_Position;
+
+uniform mat4 u_Model;
+uniform mat4 u_View;
+uniform mat4 u_Projection;
+
+// Cubic Bernstein weights at t and their derivatives
+void Basis(float t, out vec4 weights, out vec4 derivatives)
+{
+    float s = 1.0 - t;
+    weights = vec4(s * s * s, 3.0 * s * s * t, 3.0 * s * t * t, t * t * t);
+    derivatives = vec4(-3.0 * s * s, 3.0 * s * (s - 2.0 * t), 3.0 * t * (2.0 * s - t), 3.0 * t * t);
+}
+
+// Point and both first derivatives in one pass over the 16 control points
+void EvaluatePatch(vec2 uv, out vec3 point, out vec3 tangentU, out vec3 tangentV)
+{
+    vec4 weightsU, derivativesU, weightsV, derivativesV;
+    Basis(uv.x, weightsU, derivativesU);
+    Basis(uv.y, weightsV, derivativesV);
+
+    point = vec3(0.0);
+    tangentU = vec3(0.0);
+    tangentV = vec3(0.0);
+    for (int i = 0; i < 4; i++)
+    {
+        // Row i reduced at v, and its v derivative
+        vec3 row = weightsV.x * te_Position[i * 4] + weightsV.y * te_Position[i * 4 + 1] +
+            weightsV.z * te_Position[i * 4 + 2] + weightsV.w * te_Position[i * 4 + 3];
+        vec3 rowDerivative = derivativesV.x * te_Position[i * 4] + derivativesV.y * te_Position[i * 4 + 1] +
+            derivativesV.z * te_Position[i * 4 + 2] + derivativesV.w * te_Position[i * 4 + 3];
+
+        point += weightsU[i] * row;
+        tangentU += derivativesU[i] * row;
+        tangentV += weightsU[i] * rowDerivative;
+    }
+}
+
+void main()
+{
+    vec3 point, tangentU, tangentV;
+    EvaluatePatch(gl_TessCoord.xy, point, tangentU, tangentV);
+
+    // Collapsed edges have no cross product, take the normal a little inside the patch instead
+    vec3 normal = cross(tangentU, tangentV);
+    if (dot(normal, normal) < 1e-12)
+    {
+        vec3 insidePoint;
+        EvaluatePatch(mix(gl_TessCoord.xy, vec2(0.5), 1e-3), insidePoint, tangentU, tangentV);
+        normal = cross(tangentU, tangentV);
+    }
+
+    v_FragPos = vec3(u_Model * vec4(point, 1.0));
+    v_Normal = mat3(transpose(inverse(u_Model))) * normal;
+    v_Position = point;
+    gl_Position = u_Projection * u_View * vec4(v_FragPos, 1.0);
+}
+
+#shader fragment
+#version 400 core
+
+layout(location = 0) out vec4 color;
+
+in vec3 v_Normal;
+in vec3 v_FragPos;
+in vec3 v_Position;
+
+#include "BezierShading.glsl"
+
+void main()
+{
+    color = ShadeBezierSurface(v_Normal, v_FragPos, v_Position);
+}
@@ -0,0 +1,47 @@
+// Fragment shading shared by BezierSurface.shader and BezierPatch.shader, pulled in with #include
+
+uniform vec3 u_LightPosition;
+uniform vec3 u_LightColor;
+uniform vec3 u_ViewPosition;
+uniform vec4 u_Color;
+
+// Programs built with USE_GRADIENT defined (Shader::GetVariant) have the color choice compiled in,
+// the others pick it per draw with u_UseGradient
+#ifdef USE_GRADIENT
+const bool c_UseGradient = USE_GRADIENT != 0;
+#else
+uniform bool u_UseGradient;
+#define c_UseGradient u_UseGradient
+#endif
+
+vec4 ShadeBezierSurface(vec3 normal, vec3 fragPos, vec3 position)
+{
+    vec4 baseColor;
+    if (c_UseGradient) {
+        vec3 normalizedPos = (position + 1.0) * 0.5; // Map from [-1,1] to [0,1]
+        baseColor = vec4(normalizedPos.x, normalizedPos.y, 0.8, 1.0);
+    } else {
+        baseColor = u_Color;
+    }
+
+    // Ambient
+    float ambientStrength = 0.25;
+    vec3 ambient = ambientStrength * u_LightColor;
+
+    // Diffuse
+    vec3 norm = normalize(normal);
+    vec3 lightDir = normalize(u_LightPosition - fragPos);
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 diffuse = diff * u_LightColor;
+
+    // Specular
+    float specularStrength = 0.7;
+    vec3 viewDir = normalize(u_ViewPosition - fragPos);
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
+    vec3 specular = specularStrength * spec * u_LightColor;
+
+    // Apply lighting
+    vec3 result = (ambient + diffuse + specular) * vec3(baseColor);
+    return vec4(result, 1.0);
+}
@@ -29,40 +29,9 @@ in vec3 v_Normal;
 in vec3 v_FragPos;
 in vec3 v_Position;
 
-uniform vec3 u_LightPosition;
-uniform vec3 u_LightColor;
-uniform vec3 u_ViewPosition;
-uniform vec4 u_Color;
-uniform bool u_UseGradient;
+#include "BezierShading.glsl"
 
 void main()
 {
-    vec4 baseColor;
-    if (u_UseGradient) {
-        vec3 normalizedPos = (v_Position + 1.0) * 0.5; // Map from [-1,1] to [0,1]
-        baseColor = vec4(normalizedPos.x, normalizedPos.y, 0.8, 1.0);
-    } else {
-        baseColor = u_Color;
-    }
-    
-    // Ambient
-    float ambientStrength = 0.25;
-    vec3 ambient = ambientStrength * u_LightColor;
-    
-    // Diffuse
-    vec3 norm = normalize(v_Normal);
-    vec3 lightDir = normalize(u_LightPosition - v_FragPos);
-    float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = diff * u_LightColor;
-    
-    // Specular
-    float specularStrength = 0.7;
-    vec3 viewDir = normalize(u_ViewPosition - v_FragPos);
-    vec3 reflectDir = reflect(-lightDir, norm);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
-    vec3 specular = specularStrength * spec * u_LightColor;
-    
-    // Apply lighting
-    vec3 result = (ambient + diffuse + specular) * vec3(baseColor);
-    color = vec4(result, 1.0);
-}
\ No newline at end of file
+    color = ShadeBezierSurface(v_Normal, v_FragPos, v_Position);
+}
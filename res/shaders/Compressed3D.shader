@@ -0,0 +1,71 @@
+#shader vertex
+#version 330 core
+
+// Quantized position (unorm16 or snorm 2_10_10_10) and octahedral normal (snorm16)
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec2 normal;
+
+out vec3 v_Normal;
+out vec3 v_FragPos;
+
+uniform mat4 u_Model;
+uniform mat4 u_View;
+uniform mat4 u_Projection;
+
+// Mesh bounds the positions were quantized to
+uniform vec3 u_PositionOffset;
+uniform vec3 u_PositionScale;
+
+vec3 OctahedralDecode(vec2 e)
+{
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+
+void main()
+{
+    vec3 localPosition = u_PositionOffset + position.xyz * u_PositionScale;
+    v_FragPos = vec3(u_Model * vec4(localPosition, 1.0));
+    v_Normal = mat3(transpose(inverse(u_Model))) * OctahedralDecode(normal);
+    
+    gl_Position = u_Projection * u_View * vec4(v_FragPos, 1.0);
+}
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 fragColor;
+
+in vec3 v_Normal;
+in vec3 v_FragPos;
+
+uniform vec4 u_Color;
+uniform vec3 u_LightPosition;
+uniform vec3 u_LightColor;
+uniform vec3 u_ViewPosition;
+
+void main()
+{
+    // Ambient lighting
+    float ambientStrength = 0.2;
+    vec3 ambient = ambientStrength * u_LightColor;
+    
+    // Diffuse lighting
+    vec3 norm = normalize(v_Normal);
+    vec3 lightDir = normalize(u_LightPosition - v_FragPos);
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 diffuse = diff * u_LightColor;
+    
+    // Specular lighting
+    float specularStrength = 0.5;
+    vec3 viewDir = normalize(u_ViewPosition - v_FragPos);
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
+    vec3 specular = specularStrength * spec * u_LightColor;
+    
+    // Combine lighting components
+    vec3 result = (ambient + diffuse + specular) * vec3(u_Color);
+    fragColor = vec4(result, u_Color.a);
+}
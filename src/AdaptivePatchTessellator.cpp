@@ -0,0 +1,422 @@
+#include "AdaptivePatchTessellator.h"
+#include "PatchEvaluator.h"
+#include "BezierEvaluation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <thread>
+
+// Below this many vertices the threads cost more than they save
+static const unsigned int s_ParallelThreshold = 16384;
+
+// Tiles a worker takes from the shared counter at a time
+static const unsigned int s_TileBlock = 4;
+
+const unsigned int AdaptivePatchTessellator::s_MaxLevel;
+
+// Part [t0, t1] of a curve, scratch holds count points
+static void ExtractSegment(const glm::vec3* points, unsigned int count, float t0, float t1, glm::vec3* segment, glm::vec3* scratch)
+{
+    // [0, t1] first, then the part of it from t0 on, the ends of the domain are copied exactly
+    if (t1 < 1.0f)
+        SplitBezier(points, count, t1, segment, scratch);
+    else
+        std::copy_n(points, count, segment);
+
+    if (t0 > 0.0f)
+        SplitBezier(segment, count, t0 / t1, scratch, segment);
+}
+
+static void WriteSample(const SurfaceSample& sample, float* vertex)
+{
+    vertex[0] = sample.Point.x;
+    vertex[1] = sample.Point.y;
+    vertex[2] = sample.Point.z;
+    vertex[3] = sample.Normal.x;
+    vertex[4] = sample.Normal.y;
+    vertex[5] = sample.Normal.z;
+}
+
+// Triangles between a tile side (outerLevel segments, parameters k / outerLevel) and the row of the
+// inner grid next to it (innerLevel - 1 samples, parameters (m + 1) / innerLevel). Both chains go
+// along the side, whichever has the nearer next sample advances
+static void StitchStrip(const unsigned int* outer, unsigned int outerLevel, const unsigned int* inner, unsigned int innerLevel, bool flip, unsigned int*& index)
+{
+    unsigned int innerCount = innerLevel - 1;
+    unsigned int a = 0, b = 0;
+    while (a < outerLevel || b + 1 < innerCount)
+    {
+        bool advanceOuter = b + 1 == innerCount || (a < outerLevel && (a + 1) * innerLevel <= (b + 2) * outerLevel);
+        unsigned int first = outer[a];
+        unsigned int second = advanceOuter ? outer[a + 1] : inner[b + 1];
+        unsigned int third = inner[b];
+        if (advanceOuter)
+            a++;
+        else
+            b++;
+
+        // Counter clockwise in (u, v) for the v = 0 and u = 1 sides, the others are mirrored
+        *index++ = first;
+        *index++ = flip ? third : second;
+        *index++ = flip ? second : third;
+    }
+}
+
+AdaptivePatchTessellator::AdaptivePatchTessellator(unsigned int tileCount)
+    : m_CountU(0), m_CountV(0), m_TileCount(std::max(1u, tileCount)), m_VertexCount(0), m_IndexCount(0)
+{
+}
+
+AdaptivePatchTessellator::~AdaptivePatchTessellator()
+{
+}
+
+void AdaptivePatchTessellator::ExtractTileNet(unsigned int a, unsigned int b, glm::vec3* tileNet, glm::vec3* scratch) const
+{
+    float u0 = (float)a / m_TileCount, u1 = (float)(a + 1) / m_TileCount;
+    float v0 = (float)b / m_TileCount, v1 = (float)(b + 1) / m_TileCount;
+
+    // Rows cut down to [v0, v1], then the columns of the result to [u0, u1]
+    for (unsigned int i = 0; i < m_CountU; i++)
+        ExtractSegment(&m_Net[i * m_CountV], m_CountV, v0, v1, tileNet + i * m_CountV, scratch);
+
+    glm::vec3* column = scratch + m_CountU;
+    glm::vec3* segment = column + m_CountU;
+    for (unsigned int j = 0; j < m_CountV; j++)
+    {
+        for (unsigned int i = 0; i < m_CountU; i++)
+            column[i] = tileNet[i * m_CountV + j];
+        ExtractSegment(column, m_CountU, u0, u1, segment, scratch);
+        for (unsigned int i = 0; i < m_CountU; i++)
+            tileNet[i * m_CountV + j] = segment[i];
+    }
+}
+
+bool AdaptivePatchTessellator::ChooseLevels(const glm::vec3* net, unsigned int countU, unsigned int countV, float tolerance, const TessellationView* view)
+{
+    unsigned int tileCount = m_TileCount;
+    unsigned int netSize = countU * countV;
+    bool changed = countU != m_CountU || countV != m_CountV || m_Tiles.size() != tileCount * tileCount;
+
+    m_Net.assign(net, net + netSize);
+    m_CountU = countU;
+    m_CountV = countV;
+    m_TileNets.resize(tileCount * tileCount * netSize);
+    m_Tiles.resize(tileCount * tileCount);
+
+    // Control point units to world units through the largest scale axis
+    float worldScale = 1.0f;
+    if (view)
+    {
+        glm::vec3 scale(glm::length(glm::vec3(view->Model[0])), glm::length(glm::vec3(view->Model[1])), glm::length(glm::vec3(view->Model[2])));
+        worldScale = std::max(scale.x, std::max(scale.y, scale.z));
+    }
+
+    std::vector<glm::vec3> scratch(std::max(countU, countV) * 3);
+    for (unsigned int a = 0; a < tileCount; a++)
+    {
+        for (unsigned int b = 0; b < tileCount; b++)
+        {
+            glm::vec3* tileNet = &m_TileNets[(a * tileCount + b) * netSize];
+            ExtractTileNet(a, b, tileNet, scratch.data());
+
+            float tileTolerance = tolerance > 0.0f ? tolerance : FLT_MAX;
+            if (view)
+            {
+                // The tile lies inside the hull of its net, its closest point bounds the projected size
+                glm::vec3 boundsMin = tileNet[0], boundsMax = tileNet[0];
+                for (unsigned int k = 1; k < netSize; k++)
+                {
+                    boundsMin = glm::min(boundsMin, tileNet[k]);
+                    boundsMax = glm::max(boundsMax, tileNet[k]);
+                }
+                glm::vec3 center = glm::vec3(view->Model * glm::vec4((boundsMin + boundsMax) * 0.5f, 1.0f));
+                float radius = glm::length(boundsMax - boundsMin) * 0.5f * worldScale;
+                float distance = std::max(glm::length(center - view->CameraPosition) - radius, 0.01f);
+                tileTolerance = std::min(tileTolerance, view->MaxPixelError * distance / (view->PixelsPerUnit * worldScale));
+            }
+
+            // Flatness of the tile net along each direction
+            unsigned int levelU = 1, levelV = 1;
+            if (tileTolerance < FLT_MAX)
+            {
+                glm::vec3* column = scratch.data();
+                for (unsigned int j = 0; j < countV; j++)
+                {
+                    for (unsigned int i = 0; i < countU; i++)
+                        column[i] = tileNet[i * countV + j];
+                    levelU = std::max(levelU, EstimateSegmentCount(column, countU, tileTolerance));
+                }
+                for (unsigned int i = 0; i < countU; i++)
+                    levelV = std::max(levelV, EstimateSegmentCount(tileNet + i * countV, countV, tileTolerance));
+            }
+            levelU = std::min(levelU, s_MaxLevel);
+            levelV = std::min(levelV, s_MaxLevel);
+
+            Tile& tile = m_Tiles[a * tileCount + b];
+            changed = changed || tile.LevelU != levelU || tile.LevelV != levelV;
+            tile.LevelU = levelU;
+            tile.LevelV = levelV;
+        }
+    }
+    return changed;
+}
+
+void AdaptivePatchTessellator::AssignVertices()
+{
+    unsigned int tileCount = m_TileCount;
+    auto tileAt = [&](unsigned int a, unsigned int b) -> const Tile& { return m_Tiles[a * tileCount + b]; };
+
+    // A side shared by two tiles takes the finer of their levels
+    m_LevelsAlongV.resize((tileCount + 1) * tileCount);
+    m_LevelsAlongU.resize((tileCount + 1) * tileCount);
+    for (unsigned int line = 0; line <= tileCount; line++)
+    {
+        for (unsigned int k = 0; k < tileCount; k++)
+        {
+            m_LevelsAlongV[line * tileCount + k] = std::max(line > 0 ? tileAt(line - 1, k).LevelV : 0u, line < tileCount ? tileAt(line, k).LevelV : 0u);
+            m_LevelsAlongU[line * tileCount + k] = std::max(line > 0 ? tileAt(k, line - 1).LevelU : 0u, line < tileCount ? tileAt(k, line).LevelU : 0u);
+        }
+    }
+
+    // Tile corners first, then the inner samples of every side, then the inside of every tile
+    unsigned int vertexCount = (tileCount + 1) * (tileCount + 1);
+    m_FirstAlongV.resize(m_LevelsAlongV.size());
+    m_FirstAlongU.resize(m_LevelsAlongU.size());
+    for (unsigned int s = 0; s < m_LevelsAlongV.size(); s++)
+    {
+        m_FirstAlongV[s] = vertexCount;
+        vertexCount += m_LevelsAlongV[s] - 1;
+    }
+    for (unsigned int s = 0; s < m_LevelsAlongU.size(); s++)
+    {
+        m_FirstAlongU[s] = vertexCount;
+        vertexCount += m_LevelsAlongU[s] - 1;
+    }
+
+    unsigned int evaluatorCount = 0;
+    unsigned int indexCount = 0;
+    for (unsigned int a = 0; a < tileCount; a++)
+    {
+        for (unsigned int b = 0; b < tileCount; b++)
+        {
+            Tile& tile = m_Tiles[a * tileCount + b];
+            unsigned int bottom = m_LevelsAlongU[b * tileCount + a], top = m_LevelsAlongU[(b + 1) * tileCount + a];
+            unsigned int left = m_LevelsAlongV[a * tileCount + b], right = m_LevelsAlongV[(a + 1) * tileCount + b];
+
+            // Stitching needs a sample inside the tile in both directions
+            tile.Stitched = bottom != tile.LevelU || top != tile.LevelU || left != tile.LevelV || right != tile.LevelV;
+            tile.InnerU = tile.Stitched ? std::max(tile.LevelU, 2u) : tile.LevelU;
+            tile.InnerV = tile.Stitched ? std::max(tile.LevelV, 2u) : tile.LevelV;
+
+            // Tables for each level pair, kept between calls
+            tile.Evaluator = 0;
+            while (tile.Evaluator < evaluatorCount && (m_Evaluators[tile.Evaluator].GetResolutionU() != tile.InnerU ||
+                m_Evaluators[tile.Evaluator].GetResolutionV() != tile.InnerV))
+                tile.Evaluator++;
+            if (tile.Evaluator == evaluatorCount)
+            {
+                if (evaluatorCount == m_Evaluators.size())
+                    m_Evaluators.emplace_back();
+                m_Evaluators[evaluatorCount++].Build(m_CountU - 1, m_CountV - 1, tile.InnerU, tile.InnerV);
+            }
+
+            tile.FirstInterior = vertexCount;
+            tile.FirstIndex = indexCount;
+            vertexCount += (tile.InnerU - 1) * (tile.InnerV - 1);
+            if (tile.Stitched)
+                indexCount += ((bottom + top + 2 * tile.InnerU - 4) + (left + right + 2 * tile.InnerV - 4) + 2 * (tile.InnerU - 2) * (tile.InnerV - 2)) * 3;
+            else
+                indexCount += tile.InnerU * tile.InnerV * 6;
+        }
+    }
+
+    m_VertexCount = vertexCount;
+    m_IndexCount = indexCount;
+}
+
+unsigned int AdaptivePatchTessellator::GetAlongVId(unsigned int a, unsigned int b, unsigned int k) const
+{
+    unsigned int side = a * m_TileCount + b;
+    if (k == 0)
+        return GetCornerId(a, b);
+    if (k == m_LevelsAlongV[side])
+        return GetCornerId(a, b + 1);
+    return m_FirstAlongV[side] + k - 1;
+}
+
+unsigned int AdaptivePatchTessellator::GetAlongUId(unsigned int b, unsigned int a, unsigned int k) const
+{
+    unsigned int side = b * m_TileCount + a;
+    if (k == 0)
+        return GetCornerId(a, b);
+    if (k == m_LevelsAlongU[side])
+        return GetCornerId(a + 1, b);
+    return m_FirstAlongU[side] + k - 1;
+}
+
+void AdaptivePatchTessellator::Tessellate(std::vector<float>& vertices, std::vector<unsigned int>& indices, bool parallel)
+{
+    if (m_Tiles.empty() || m_CountU < 2 || m_CountV < 2)
+    {
+        vertices.clear();
+        indices.clear();
+        return;
+    }
+
+    AssignVertices();
+    vertices.resize(m_VertexCount * PatchEvaluator::s_VertexStride);
+    indices.resize(m_IndexCount);
+    EvaluateBorders(vertices.data());
+
+    unsigned int tileTotal = m_Tiles.size();
+    unsigned int threadCount = std::max(1u, std::thread::hardware_concurrency());
+    if (!parallel || m_VertexCount < s_ParallelThreshold || threadCount == 1)
+    {
+        TessellateTiles(0, tileTotal, vertices.data(), indices.data());
+        return;
+    }
+
+    // Tile levels vary, so workers keep pulling small blocks until none are left
+    std::atomic<unsigned int> nextTile(0);
+    float* vertexData = vertices.data();
+    unsigned int* indexData = indices.data();
+    auto worker = [&]()
+    {
+        for (;;)
+        {
+            unsigned int first = nextTile.fetch_add(s_TileBlock);
+            if (first >= tileTotal)
+                return;
+            TessellateTiles(first, std::min(first + s_TileBlock, tileTotal), vertexData, indexData);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < threadCount; t++)
+        threads.emplace_back(worker);
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+void AdaptivePatchTessellator::EvaluateBorders(float* vertices) const
+{
+    // Shared samples come from the whole net so both tiles of a side see the same vertex
+    unsigned int tileCount = m_TileCount;
+    const glm::vec3* net = m_Net.data();
+    for (unsigned int a = 0; a <= tileCount; a++)
+    {
+        for (unsigned int b = 0; b <= tileCount; b++)
+        {
+            SurfaceSample sample = PatchEvaluator::EvaluatePoint(net, m_CountU, m_CountV, (float)a / tileCount, (float)b / tileCount);
+            WriteSample(sample, vertices + GetCornerId(a, b) * PatchEvaluator::s_VertexStride);
+        }
+    }
+
+    for (unsigned int line = 0; line <= tileCount; line++)
+    {
+        float across = (float)line / tileCount;
+        for (unsigned int k = 0; k < tileCount; k++)
+        {
+            unsigned int side = line * tileCount + k;
+            for (unsigned int s = 1; s < m_LevelsAlongV[side]; s++)
+            {
+                float along = (k + (float)s / m_LevelsAlongV[side]) / tileCount;
+                SurfaceSample sample = PatchEvaluator::EvaluatePoint(net, m_CountU, m_CountV, across, along);
+                WriteSample(sample, vertices + (m_FirstAlongV[side] + s - 1) * PatchEvaluator::s_VertexStride);
+            }
+            for (unsigned int s = 1; s < m_LevelsAlongU[side]; s++)
+            {
+                float along = (k + (float)s / m_LevelsAlongU[side]) / tileCount;
+                SurfaceSample sample = PatchEvaluator::EvaluatePoint(net, m_CountU, m_CountV, along, across);
+                WriteSample(sample, vertices + (m_FirstAlongU[side] + s - 1) * PatchEvaluator::s_VertexStride);
+            }
+        }
+    }
+}
+
+void AdaptivePatchTessellator::TessellateTiles(unsigned int first, unsigned int last, float* vertices, unsigned int* indices) const
+{
+    std::vector<float> grid;
+    std::vector<unsigned int> outer, inner;
+    unsigned int netSize = m_CountU * m_CountV;
+    const unsigned int stride = PatchEvaluator::s_VertexStride;
+
+    for (unsigned int t = first; t < last; t++)
+    {
+        const Tile& tile = m_Tiles[t];
+        unsigned int a = t / m_TileCount, b = t % m_TileCount;
+        unsigned int samplesV = tile.InnerV + 1;
+
+        // Inner samples from the tile's own net on the tile's grid
+        const PatchEvaluator& evaluator = m_Evaluators[tile.Evaluator];
+        grid.resize(evaluator.GetVertexCount() * stride);
+        evaluator.Evaluate(&m_TileNets[t * netSize], grid.data(), false);
+        for (unsigned int i = 1; i < tile.InnerU; i++)
+        {
+            for (unsigned int j = 1; j < tile.InnerV; j++)
+            {
+                unsigned int id = tile.FirstInterior + (i - 1) * (tile.InnerV - 1) + (j - 1);
+                std::copy_n(&grid[(i * samplesV + j) * stride], stride, vertices + id * stride);
+            }
+        }
+
+        // Sides only line up with the grid when the tile isn't stitched
+        auto vertexId = [&](unsigned int i, unsigned int j)
+        {
+            if (i == 0 || i == tile.InnerU)
+                return GetAlongVId(i == 0 ? a : a + 1, b, j);
+            if (j == 0 || j == tile.InnerV)
+                return GetAlongUId(j == 0 ? b : b + 1, a, i);
+            return tile.FirstInterior + (i - 1) * (tile.InnerV - 1) + (j - 1);
+        };
+
+        // Same triangle order and winding as BezierSurface::Generate
+        unsigned int* index = indices + tile.FirstIndex;
+        unsigned int gridFirst = tile.Stitched ? 1 : 0;
+        unsigned int gridLastU = tile.Stitched ? tile.InnerU - 1 : tile.InnerU;
+        unsigned int gridLastV = tile.Stitched ? tile.InnerV - 1 : tile.InnerV;
+        for (unsigned int i = gridFirst; i < gridLastU; i++)
+        {
+            for (unsigned int j = gridFirst; j < gridLastV; j++)
+            {
+                unsigned int p0 = vertexId(i, j);
+                unsigned int p1 = vertexId(i, j + 1);
+                unsigned int p2 = vertexId(i + 1, j);
+                unsigned int p3 = vertexId(i + 1, j + 1);
+                *index++ = p0; *index++ = p2; *index++ = p1;
+                *index++ = p1; *index++ = p2; *index++ = p3;
+            }
+        }
+        if (!tile.Stitched)
+            continue;
+
+        // The ring between the sides and the inner grid, one strip per side
+        for (unsigned int side = 0; side < 4; side++)
+        {
+            bool alongU = side < 2;
+            unsigned int line = alongU ? b + side : a + side - 2;
+            unsigned int level = alongU ? m_LevelsAlongU[line * m_TileCount + a] : m_LevelsAlongV[line * m_TileCount + b];
+            unsigned int innerLevel = alongU ? tile.InnerU : tile.InnerV;
+
+            outer.resize(level + 1);
+            for (unsigned int k = 0; k <= level; k++)
+                outer[k] = alongU ? GetAlongUId(line, a, k) : GetAlongVId(line, b, k);
+
+            inner.resize(innerLevel - 1);
+            for (unsigned int m = 1; m < innerLevel; m++)
+            {
+                if (alongU)
+                    inner[m - 1] = vertexId(m, side == 0 ? 1 : tile.InnerV - 1);
+                else
+                    inner[m - 1] = vertexId(side == 2 ? 1 : tile.InnerU - 1, m);
+            }
+
+            // v = 0, v = 1, u = 0, u = 1
+            StitchStrip(outer.data(), level, inner.data(), innerLevel, side == 1 || side == 2, index);
+        }
+    }
+}
+
@@ -1,138 +1,447 @@
 #include "BezierCurve.h"
 
-BezierCurve::BezierCurve(unsigned int resolution)
-    : m_Resolution(resolution)
+#include <algorithm>
+#include <cmath>
+
+// 5 point Gauss-Legendre nodes and weights on [-1, 1]
+static const float s_GaussNodes[5] = { 0.0f, -0.5384693101f, 0.5384693101f, -0.9061798459f, 0.9061798459f };
+static const float s_GaussWeights[5] = { 0.5688888889f, 0.4786286705f, 0.4786286705f, 0.2369268851f, 0.2369268851f };
+
+// Arc length table spans per degree, each span is integrated with the 5 point rule
+static const unsigned int s_ArcLengthSpansPerDegree = 16;
+
+template<typename Point>
+BezierCurveT<Point>::BezierCurveT(unsigned int resolution)
+    : m_Mode(CurveMode::Bezier), m_Resolution(resolution), m_DirtyBegin(0), m_DirtyEnd(0), m_SegmentLayout(false),
+    m_FlatteningTolerance(0.0f), m_ArcLengthDirty(true)
 {
 }
 
-BezierCurve::~BezierCurve()
+template<typename Point>
+BezierCurveT<Point>::~BezierCurveT()
 {
 }
 
-void BezierCurve::AddControlPoint(const glm::vec2& point)
+template<typename Point>
+void BezierCurveT<Point>::AddControlPoint(const Point& point)
 {
     m_ControlPoints.push_back(point);
+    m_ArcLengthDirty = true;
+
+    // A new point only adds the last segment of a B-spline
+    if (m_Mode == CurveMode::BSpline && m_ControlPoints.size() > 4)
+    {
+        unsigned int segment = GetSegmentCount() - 1;
+        UpdateSegments(segment, segment);
+        return;
+    }
     UpdateCurve();
 }
 
-void BezierCurve::ClearControlPoints()
+template<typename Point>
+void BezierCurveT<Point>::SetControlPoint(unsigned int index, const Point& point)
+{
+    if (index >= m_ControlPoints.size())
+        return;
+
+    m_ControlPoints[index] = point;
+    m_ArcLengthDirty = true;
+
+    // Point i is used by segments i - 3 to i
+    if (m_Mode == CurveMode::BSpline && GetSegmentCount() > 0)
+    {
+        unsigned int first = index >= 3 ? index - 3 : 0;
+        unsigned int last = std::min(index, GetSegmentCount() - 1);
+        if (first <= last)
+            UpdateSegments(first, last);
+        return;
+    }
+    UpdateCurve();
+}
+
+template<typename Point>
+void BezierCurveT<Point>::ClearControlPoints()
 {
     m_ControlPoints.clear();
     m_CurvePoints.clear();
+    m_ArcLengthDirty = true;
+    m_DirtyBegin = m_DirtyEnd = 0;
 }
 
-void BezierCurve::UpdateCurve()
+template<typename Point>
+void BezierCurveT<Point>::UpdateCurve()
 {
+    if (m_Mode == CurveMode::BSpline)
+    {
+        m_CurvePoints.clear();
+        m_SegmentLayout = false;
+        if (GetSegmentCount() > 0)
+            UpdateSegments(0, GetSegmentCount() - 1);
+        MarkDirty(0, GetPointCount());
+        return;
+    }
+
     if (m_ControlPoints.size() < 2)
         return;
 
-    m_CurvePoints.clear();
+    if (m_FlatteningTolerance > 0.0f)
+    {
+        UpdateCurveAdaptive(m_FlatteningTolerance);
+        return;
+    }
 
-    
-    for (unsigned int i = 0; i <= m_Resolution; i++)
+    // Every sample is a weighted sum of the control points, no allocation once the buffers are sized
+    m_BasisTable.Build(m_ControlPoints.size() - 1, m_Resolution);
+    m_CurvePoints.resize((m_Resolution + 1) * s_Dimensions);
+    EvaluateBezierBatch(m_ControlPoints.data(), m_BasisTable, reinterpret_cast<Point*>(m_CurvePoints.data()));
+    MarkDirty(0, GetPointCount());
+}
+
+template<typename Point>
+void BezierCurveT<Point>::SetMode(CurveMode mode)
+{
+    m_Mode = mode;
+    m_ArcLengthDirty = true;
+    UpdateCurve();
+}
+
+template<typename Point>
+unsigned int BezierCurveT<Point>::GetSegmentCount() const
+{
+    if (m_Mode == CurveMode::Bezier)
+        return m_ControlPoints.size() >= 2 ? 1 : 0;
+    return m_ControlPoints.size() >= 4 ? m_ControlPoints.size() - 3 : 0;
+}
+
+template<typename Point>
+void BezierCurveT<Point>::GetSegmentPoints(unsigned int segment, Point* points) const
+{
+    // Uniform cubic B-spline to Bezier basis change
+    const Point& p0 = m_ControlPoints[segment];
+    const Point& p1 = m_ControlPoints[segment + 1];
+    const Point& p2 = m_ControlPoints[segment + 2];
+    const Point& p3 = m_ControlPoints[segment + 3];
+
+    points[0] = (p0 + 4.0f * p1 + p2) / 6.0f;
+    points[1] = (2.0f * p1 + p2) / 3.0f;
+    points[2] = (p1 + 2.0f * p2) / 3.0f;
+    points[3] = (p1 + 4.0f * p2 + p3) / 6.0f;
+}
+
+template<typename Point>
+void BezierCurveT<Point>::UpdateSegments(unsigned int first, unsigned int last)
+{
+    // Segment i owns samples [i * resolution, (i + 1) * resolution], neighbours share their end sample
+    m_SegmentTable.Build(3, m_Resolution);
+    if (!m_SegmentLayout)
     {
-        float t = static_cast<float>(i) / static_cast<float>(m_Resolution);
-        glm::vec2 point = CalculatePoint(t);
+        m_SegmentLayout = true;
+        m_CurvePoints.clear();
+        first = 0;
+        last = GetSegmentCount() - 1;
+    }
+
+    unsigned int pointCount = GetSegmentCount() * m_Resolution + 1;
+    if (m_CurvePoints.size() != pointCount * s_Dimensions)
+    {
+        unsigned int oldCount = GetPointCount();
+        m_CurvePoints.resize(pointCount * s_Dimensions);
+        MarkDirty(std::min(oldCount, pointCount), pointCount);
+    }
+
+    Point* samples = reinterpret_cast<Point*>(m_CurvePoints.data());
+    for (unsigned int segment = first; segment <= last; segment++)
+    {
+        Point points[4];
+        GetSegmentPoints(segment, points);
+        EvaluateBezierBatch(points, m_SegmentTable, samples + segment * m_Resolution);
+    }
+    MarkDirty(first * m_Resolution, (last + 1) * m_Resolution + 1);
+}
+
+template<typename Point>
+void BezierCurveT<Point>::MarkDirty(unsigned int begin, unsigned int end)
+{
+    if (begin >= end)
+        return;
 
-        // Add point to flattened array
-        m_CurvePoints.push_back(point.x);
-        m_CurvePoints.push_back(point.y);
+    if (m_DirtyBegin >= m_DirtyEnd)
+    {
+        m_DirtyBegin = begin;
+        m_DirtyEnd = end;
+        return;
     }
+    m_DirtyBegin = std::min(m_DirtyBegin, begin);
+    m_DirtyEnd = std::max(m_DirtyEnd, end);
 }
 
+template<typename Point>
+void BezierCurveT<Point>::AppendCurvePoint(const Point& point)
+{
+    for (unsigned int i = 0; i < s_Dimensions; i++)
+        m_CurvePoints.push_back(point[i]);
+}
 
+template<typename Point>
+void BezierCurveT<Point>::GetDirtyRange(unsigned int& firstPoint, unsigned int& pointCount) const
+{
+    firstPoint = m_DirtyBegin;
+    pointCount = m_DirtyEnd > m_DirtyBegin ? m_DirtyEnd - m_DirtyBegin : 0;
+}
 
+template<typename Point>
+void BezierCurveT<Point>::ClearDirtyRange()
+{
+    m_DirtyBegin = m_DirtyEnd = 0;
+}
 
+template<typename Point>
+void BezierCurveT<Point>::SetFlatteningTolerance(float tolerance)
+{
+    m_FlatteningTolerance = std::max(tolerance, 0.0f);
+    UpdateCurve();
+}
 
-void BezierCurve::UpdateCurveUniformLength(float segmentLength)
+template<typename Point>
+void BezierCurveT<Point>::UpdateCurveAdaptive(float tolerance)
 {
-    if (m_ControlPoints.size() < 2)
+    if (m_ControlPoints.size() < 2 || m_Mode != CurveMode::Bezier)
         return;
 
-    m_CurvePoints.clear();
+    const unsigned int count = m_ControlPoints.size();
+    const unsigned int maxDepth = 16;
 
-    // Premier point (t = 0)
-    float t = 0.0f;
-    glm::vec2 currentPoint = CalculatePoint(t);
-    m_CurvePoints.push_back(currentPoint.x);
-    m_CurvePoints.push_back(currentPoint.y);
+    m_CurvePoints.clear();
+    AppendCurvePoint(m_ControlPoints[0]);
 
-    while (t < 1.0f)
-    {
-        float nextT = FindNextT(t, currentPoint, segmentLength);
+    // Depth first on an explicit stack of control polygons, the right half is pushed first so
+    // the left one is flattened first and points come out in order
+    m_SubdivisionStack.resize((maxDepth + 2) * count);
+    std::vector<unsigned int>& depths = m_SubdivisionDepths;
+    depths.clear();
 
-        if (nextT <= t)
-            break;
+    std::copy(m_ControlPoints.begin(), m_ControlPoints.end(), m_SubdivisionStack.begin());
+    depths.push_back(0);
 
-        t = nextT;
+    Point left[s_MaxStackControlPoints];
+    std::vector<Point> leftHeap;
+    Point* leftPoints = left;
+    if (count > s_MaxStackControlPoints)
+    {
+        leftHeap.resize(count);
+        leftPoints = leftHeap.data();
+    }
 
-        currentPoint = CalculatePoint(t);
-        m_CurvePoints.push_back(currentPoint.x);
-        m_CurvePoints.push_back(currentPoint.y);
+    while (!depths.empty())
+    {
+        unsigned int depth = depths.back();
+        Point* piece = &m_SubdivisionStack[(depths.size() - 1) * count];
+
+        if (depth >= maxDepth || ControlPolygonFlatness(piece, count) <= tolerance)
+        {
+            AppendCurvePoint(piece[count - 1]);
+            depths.pop_back();
+            continue;
+        }
+
+        // Right half stays in this slot, left half goes on top
+        SplitBezier(piece, count, 0.5f, leftPoints, piece + count);
+        std::copy(piece + count, piece + 2 * count, piece);
+        std::copy(leftPoints, leftPoints + count, piece + count);
+        depths.back() = depth + 1;
+        depths.push_back(depth + 1);
     }
+    MarkDirty(0, GetPointCount());
+}
 
-    if (t < 1.0f)
+template<typename Point>
+float BezierCurveT<Point>::ControlPolygonFlatness(const Point* points, unsigned int count)
+{
+    // Two bounds on the distance to the chord, the tighter one is used:
+    // the piece lies in the hull of its control points, so their distance to the chord segment bounds it,
+    // and B(t) - L(t) = sum of B_i(t) * (P_i - L(i / n)) with the interior weights summing to at most 1 - 2^(1 - n)
+    Point start = points[0];
+    Point chord = points[count - 1] - start;
+    float chordLengthSq = glm::dot(chord, chord);
+    float degree = static_cast<float>(count - 1);
+
+    float hullDistanceSq = 0.0f;
+    float parametricDistanceSq = 0.0f;
+    for (unsigned int i = 1; i + 1 < count; i++)
     {
-        glm::vec2 lastPoint = CalculatePoint(1.0f);
-        m_CurvePoints.push_back(lastPoint.x);
-        m_CurvePoints.push_back(lastPoint.y);
+        Point offset = points[i] - start;
+        float u = chordLengthSq > 0.0f ? glm::clamp(glm::dot(offset, chord) / chordLengthSq, 0.0f, 1.0f) : 0.0f;
+        Point hullDistance = offset - u * chord;
+        Point parametricDistance = offset - (static_cast<float>(i) / degree) * chord;
+        hullDistanceSq = std::max(hullDistanceSq, glm::dot(hullDistance, hullDistance));
+        parametricDistanceSq = std::max(parametricDistanceSq, glm::dot(parametricDistance, parametricDistance));
     }
+
+    float interiorWeight = 1.0f - std::pow(2.0f, 1.0f - degree);
+    return std::min(std::sqrt(hullDistanceSq), interiorWeight * std::sqrt(parametricDistanceSq));
 }
 
-float BezierCurve::FindNextT(float currentT, const glm::vec2& currentPoint, float targetLength)
+template<typename Point>
+void BezierCurveT<Point>::UpdateCurveUniformLength(float segmentLength)
 {
-    const float epsilon = 0.001f;
-    const float maxStep = 0.1f;
-    float t = currentT + epsilon;
+    if (GetSegmentCount() == 0 || segmentLength <= 0.0f)
+        return;
 
-    while (t <= 1.0f)
-    {
-        glm::vec2 testPoint = CalculatePoint(t);
-        float distance = glm::length(testPoint - currentPoint);
+    m_CurvePoints.clear();
+    m_SegmentLayout = false;
 
-        if (std::abs(distance - targetLength) < epsilon || distance > targetLength)
-            return t;
+    // Premier point (t = 0)
+    Point firstPoint = CalculatePoint(0.0f);
+    AppendCurvePoint(firstPoint);
 
-        t += std::min(maxStep, epsilon * targetLength / distance);
+    // One table lookup per point
+    float length = GetLength();
+    for (float s = segmentLength; s < length; s += segmentLength)
+    {
+        Point point = CalculatePoint(GetParameterAtLength(s));
+        AppendCurvePoint(point);
     }
 
-    return 1.0f;
+    Point lastPoint = CalculatePoint(1.0f);
+    AppendCurvePoint(lastPoint);
+    MarkDirty(0, GetPointCount());
 }
 
+template<typename Point>
+float BezierCurveT<Point>::GetLength()
+{
+    if (m_ArcLengthDirty)
+        BuildArcLengthTable();
+    return m_ArcLengths.empty() ? 0.0f : m_ArcLengths.back();
+}
 
+template<typename Point>
+float BezierCurveT<Point>::GetLengthAtParameter(float t)
+{
+    if (m_ArcLengthDirty)
+        BuildArcLengthTable();
+    if (m_ArcLengths.size() < 2)
+        return 0.0f;
+
+    t = glm::clamp(t, 0.0f, 1.0f);
+    unsigned int spans = m_ArcLengths.size() - 1;
+    unsigned int span = std::min(static_cast<unsigned int>(t * spans), spans - 1);
+    return m_ArcLengths[span] + IntegrateSpeed(static_cast<float>(span) / spans, t);
+}
 
+template<typename Point>
+float BezierCurveT<Point>::GetParameterAtLength(float length)
+{
+    if (m_ArcLengthDirty)
+        BuildArcLengthTable();
+    if (m_ArcLengths.size() < 2 || length <= 0.0f)
+        return 0.0f;
+    if (length >= m_ArcLengths.back())
+        return 1.0f;
+
+    // Binary search for the span, the table is monotonic
+    unsigned int spans = m_ArcLengths.size() - 1;
+    unsigned int span = std::upper_bound(m_ArcLengths.begin(), m_ArcLengths.end(), length) - m_ArcLengths.begin() - 1;
+    span = std::min(span, spans - 1);
+
+    // Linear guess inside the span, then one Newton step on s(t) - length
+    float t0 = static_cast<float>(span) / spans;
+    float spanLength = m_ArcLengths[span + 1] - m_ArcLengths[span];
+    float fraction = spanLength > 0.0f ? (length - m_ArcLengths[span]) / spanLength : 0.0f;
+    float t = t0 + fraction / spans;
+
+    float speed = GetSpeed(t);
+    if (speed > 0.0f)
+        t -= (m_ArcLengths[span] + IntegrateSpeed(t0, t) - length) / speed;
+
+    return glm::clamp(t, t0, static_cast<float>(span + 1) / spans);
+}
 
-const std::vector<float>& BezierCurve::GetCurvePoints() const
+template<typename Point>
+void BezierCurveT<Point>::BuildArcLengthTable()
 {
-    return m_CurvePoints;
+    m_ArcLengthDirty = false;
+    m_ArcLengths.clear();
+    m_Hodograph.clear();
+    if (GetSegmentCount() == 0)
+        return;
+
+    // Derivative of a degree n curve is the degree n - 1 curve on n * (P_i+1 - P_i),
+    // B-spline segments are cubics whose hodographs are built on the fly
+    unsigned int degree = 3 * GetSegmentCount();
+    if (m_Mode == CurveMode::Bezier)
+    {
+        degree = m_ControlPoints.size() - 1;
+        for (unsigned int i = 0; i < degree; i++)
+            m_Hodograph.push_back(static_cast<float>(degree) * (m_ControlPoints[i + 1] - m_ControlPoints[i]));
+    }
+
+    unsigned int spans = s_ArcLengthSpansPerDegree * degree;
+    m_ArcLengths.resize(spans + 1);
+    m_ArcLengths[0] = 0.0f;
+    for (unsigned int i = 0; i < spans; i++)
+        m_ArcLengths[i + 1] = m_ArcLengths[i] + IntegrateSpeed(static_cast<float>(i) / spans, static_cast<float>(i + 1) / spans);
 }
 
-unsigned int BezierCurve::GetPointCount() const
+template<typename Point>
+float BezierCurveT<Point>::GetSpeed(float t) const
 {
-    return (m_CurvePoints.size() / 2);
+    if (m_Mode == CurveMode::Bezier)
+        return glm::length(EvaluateBezier(m_Hodograph.data(), m_Hodograph.size(), t));
+
+    // The global parameter runs over all segments, d/dt picks up the segment count
+    unsigned int segments = GetSegmentCount();
+    unsigned int segment = std::min(static_cast<unsigned int>(t * segments), segments - 1);
+    Point points[4];
+    GetSegmentPoints(segment, points);
+
+    Point hodograph[3] = { 3.0f * (points[1] - points[0]), 3.0f * (points[2] - points[1]), 3.0f * (points[3] - points[2]) };
+    float local = t * segments - static_cast<float>(segment);
+    return glm::length(FixedDeCasteljau<2, Point>::Evaluate(hodograph, local)) * static_cast<float>(segments);
 }
 
-const std::vector<glm::vec2>& BezierCurve::GetControlPoints() const
+template<typename Point>
+float BezierCurveT<Point>::IntegrateSpeed(float t0, float t1) const
 {
-    return m_ControlPoints;
+    float halfWidth = 0.5f * (t1 - t0);
+    float middle = 0.5f * (t0 + t1);
+
+    float sum = 0.0f;
+    for (int i = 0; i < 5; i++)
+        sum += s_GaussWeights[i] * GetSpeed(middle + halfWidth * s_GaussNodes[i]);
+    return sum * halfWidth;
 }
 
-glm::vec2 BezierCurve::CalculatePoint(float t)
+template<typename Point>
+const std::vector<float>& BezierCurveT<Point>::GetCurvePoints() const
 {
-    return DeCasteljau(m_ControlPoints, t);
+    return m_CurvePoints;
 }
 
-glm::vec2 BezierCurve::DeCasteljau(const std::vector<glm::vec2>& points, float t)
+template<typename Point>
+unsigned int BezierCurveT<Point>::GetPointCount() const
 {
-    if (points.size() == 1)
-        return points[0];
+    return (m_CurvePoints.size() / s_Dimensions);
+}
 
-    std::vector<glm::vec2> newPoints;
-    for (size_t i = 0; i < points.size() - 1; i++)
-    {
-        glm::vec2 newPoint = (1.0f - t) * points[i] + t * points[i + 1];
-        newPoints.push_back(newPoint);
-    }
+template<typename Point>
+const std::vector<Point>& BezierCurveT<Point>::GetControlPoints() const
+{
+    return m_ControlPoints;
+}
+
+template<typename Point>
+Point BezierCurveT<Point>::CalculatePoint(float t) const
+{
+    if (m_Mode == CurveMode::Bezier)
+        return EvaluateBezier(m_ControlPoints.data(), m_ControlPoints.size(), t);
+
+    unsigned int segments = GetSegmentCount();
+    unsigned int segment = std::min(static_cast<unsigned int>(glm::max(t, 0.0f) * segments), segments - 1);
+    Point points[4];
+    GetSegmentPoints(segment, points);
+    return FixedDeCasteljau<3, Point>::Evaluate(points, t * segments - static_cast<float>(segment));
+}
 
-    return DeCasteljau(newPoints, t);
-}
\ No newline at end of file
+template class BezierCurveT<glm::vec2>;
+template class BezierCurveT<glm::vec3>;
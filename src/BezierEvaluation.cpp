@@ -0,0 +1,43 @@
+#include "BezierEvaluation.h"
+
+BernsteinTable::BernsteinTable()
+    : m_Degree(0), m_Resolution(0)
+{
+}
+
+void BernsteinTable::Build(unsigned int degree, unsigned int resolution)
+{
+    if (!m_Weights.empty() && degree == m_Degree && resolution == m_Resolution)
+        return;
+
+    m_Degree = degree;
+    m_Resolution = resolution;
+    m_Weights.assign((resolution + 1) * (degree + 1), 0.0f);
+    m_Derivatives.assign((resolution + 1) * (degree + 1), 0.0f);
+
+    for (unsigned int s = 0; s <= resolution; s++)
+    {
+        float t = resolution > 0 ? static_cast<float>(s) / static_cast<float>(resolution) : 0.0f;
+        float* weights = &m_Weights[s * (degree + 1)];
+        float* derivatives = &m_Derivatives[s * (degree + 1)];
+
+        // Raise the degree one step at a time, same convex combinations as De Casteljau
+        // so the weights stay positive and sum to one for any degree
+        weights[0] = 1.0f;
+        for (unsigned int k = 1; k <= degree; k++)
+        {
+            // B'_i,n = n (B_i-1,n-1 - B_i,n-1), taken from the weights one degree below
+            if (k == degree)
+            {
+                float n = static_cast<float>(degree);
+                for (unsigned int i = 0; i <= degree; i++)
+                    derivatives[i] = n * ((i > 0 ? weights[i - 1] : 0.0f) - (i < degree ? weights[i] : 0.0f));
+            }
+
+            weights[k] = t * weights[k - 1];
+            for (unsigned int j = k - 1; j > 0; j--)
+                weights[j] = (1.0f - t) * weights[j] + t * weights[j - 1];
+            weights[0] = (1.0f - t) * weights[0];
+        }
+    }
+}
@@ -0,0 +1,151 @@
+#include "BezierPatchMesh.h"
+#include "Renderer.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+BezierPatchMesh::BezierPatchMesh(float tolerance, unsigned int maxResolution)
+    : m_Tolerance(tolerance), m_MaxResolution(maxResolution)
+{
+    // Empty until patches are set or loaded
+}
+
+BezierPatchMesh::~BezierPatchMesh()
+{
+}
+
+void BezierPatchMesh::Generate()
+{
+    if (m_ControlPoints.empty())
+        return;
+
+    m_Tessellator.Tessellate(m_ControlPoints.data(), GetPatchCount(), m_Tolerance, m_MaxResolution, m_Vertices, m_Indices);
+
+    // Setup OpenGL buffers
+    SetupMesh();
+}
+
+void BezierPatchMesh::Update()
+{
+    // Re-generate the mesh with current parameters
+    Generate();
+    if (m_LODLevelCount > 0)
+        GenerateLODs(m_LODLevelCount);
+}
+
+void BezierPatchMesh::GenerateLODs(unsigned int levelCount)
+{
+    m_LODMeshes.clear();
+    m_LODErrors.clear();
+    m_LODLevelCount = levelCount;
+    if (m_ControlPoints.empty())
+        return;
+
+    // Wang's formula goes with the square root of the tolerance, Generate always uses m_Tolerance
+    float baseTolerance = m_Tolerance;
+    for (unsigned int level = 0; level < levelCount; level++)
+    {
+        Generate();
+        if (!m_Mesh)
+            break;
+
+        m_LODMeshes.push_back(m_Mesh);
+        m_LODErrors.push_back(m_Tolerance);
+
+        // Every edge is down to a single segment
+        if (m_Mesh->GetIndexCount() == GetPatchCount() * 6)
+            break;
+        m_Tolerance *= 4.0f;
+    }
+
+    m_Tolerance = baseTolerance;
+    m_CurrentLOD = 0;
+    if (!m_LODMeshes.empty())
+        m_Mesh = m_LODMeshes[0];
+}
+
+void BezierPatchMesh::SetPatches(const std::vector<glm::vec3>& controlPoints)
+{
+    ASSERT(controlPoints.size() % 16 == 0);
+    m_ControlPoints = controlPoints;
+    Update();
+}
+
+// Upper bound on the numbers left after the read position, each needs a digit and a separator
+static unsigned long long RemainingNumbers(std::istringstream& numbers, const std::string& text)
+{
+    // tellg fails once the last number ran into the end of the text
+    std::streamoff position = numbers.tellg();
+    if (position < 0)
+        return 0;
+    return (text.size() - position + 1) / 2;
+}
+
+bool BezierPatchMesh::LoadPatches(const std::string& filePath)
+{
+    std::ifstream stream(filePath);
+    if (!stream)
+    {
+        std::cout << "Failed to open patch file " << filePath << std::endl;
+        return false;
+    }
+
+    // Commas are only separators
+    std::stringstream contents;
+    contents << stream.rdbuf();
+    std::string text = contents.str();
+    std::replace(text.begin(), text.end(), ',', ' ');
+    std::istringstream numbers(text);
+
+    // Every number takes at least a digit and a separator, counts that cannot fit in the rest of
+    // the file are garbage and must not size an allocation
+    unsigned int patchCount = 0;
+    numbers >> patchCount;
+    if (!numbers || patchCount == 0 || (unsigned long long)patchCount * 16 + 1 > RemainingNumbers(numbers, text))
+    {
+        std::cout << "Failed to read patch file " << filePath << std::endl;
+        return false;
+    }
+    std::vector<unsigned int> indices(patchCount * 16);
+    for (unsigned int& index : indices)
+        numbers >> index;
+
+    unsigned int vertexCount = 0;
+    numbers >> vertexCount;
+    if (!numbers || (unsigned long long)vertexCount * 3 > RemainingNumbers(numbers, text))
+    {
+        std::cout << "Failed to read patch file " << filePath << std::endl;
+        return false;
+    }
+    std::vector<glm::vec3> points(vertexCount);
+    for (glm::vec3& point : points)
+        numbers >> point.x >> point.y >> point.z;
+
+    if (!numbers)
+    {
+        std::cout << "Failed to read patch file " << filePath << std::endl;
+        return false;
+    }
+
+    // Indexed control points become one contiguous block, equal points keep shared edges intact
+    std::vector<glm::vec3> controlPoints(indices.size());
+    for (unsigned int i = 0; i < indices.size(); i++)
+    {
+        if (indices[i] == 0 || indices[i] > vertexCount)
+        {
+            std::cout << "Patch file " << filePath << " has an invalid vertex index " << indices[i] << std::endl;
+            return false;
+        }
+        controlPoints[i] = points[indices[i] - 1];
+    }
+
+    SetPatches(controlPoints);
+    return true;
+}
+
+void BezierPatchMesh::SetTolerance(float tolerance)
+{
+    m_Tolerance = tolerance;
+    Update();
+}
@@ -1,10 +1,23 @@
 #include "BezierSurface.h"
 #include "Renderer.h"
+#include "VertexBufferLayout.h"
+#include "Frustum.h"
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+
+// GetControlPointData hands the net to GL as packed floats
+static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "glm::vec3 must be tightly packed");
+
+// Control point moves applied as rank one updates before the frame is evaluated again in full
+static const unsigned int s_MaxIncrementalUpdates = 256;
 
 BezierSurface::BezierSurface(unsigned int resolutionU, unsigned int resolutionV)
     : m_ResolutionU(resolutionU), m_ResolutionV(resolutionV),
-    m_NumControlPointsU(0), m_NumControlPointsV(0)
+    m_NumControlPointsU(0), m_NumControlPointsV(0), m_IncrementalUpdates(0),
+    m_AdaptiveTessellation(false), m_AdaptiveTolerance(0.001f), m_View(), m_HasView(false),
+    m_GPUTessellation(false), m_GridLinesDirty(true), m_ControlNetDirty(true),
+    m_ControlPointIndexDirty(true)
 {
     // Create a default surface when initialized
     CreateDefaultSurface();
@@ -20,14 +33,15 @@ void BezierSurface::CreateDefaultSurface()
     m_NumControlPointsU = 4;
     m_NumControlPointsV = 4;
 
-    // Clear existing control points
-    m_ControlPoints.clear();
-    m_ControlPoints.resize(m_NumControlPointsU);
+    // Replace existing control points
+    m_ControlPoints.resize(m_NumControlPointsU * m_NumControlPointsV);
+    m_GridLineIBO.reset();
+    MarkControlNetDirty();
+    m_ControlPointIndexDirty = true;
 
     // Initialize control points
     for (unsigned int i = 0; i < m_NumControlPointsU; i++)
     {
-        m_ControlPoints[i].resize(m_NumControlPointsV);
         float u = (float)i / (m_NumControlPointsU - 1);
 
         for (unsigned int j = 0; j < m_NumControlPointsV; j++)
@@ -50,7 +64,7 @@ void BezierSurface::CreateDefaultSurface()
                 z = 0.8f;
             }
 
-            m_ControlPoints[i][j] = glm::vec3(x, y, z);
+            m_ControlPoints[i * m_NumControlPointsV + j] = glm::vec3(x, y, z);
         }
     }
 
@@ -66,27 +80,47 @@ void BezierSurface::Generate()
     m_Vertices.clear();
     m_Indices.clear();
 
-    for (unsigned int i = 0; i <= m_ResolutionU; i++)
+    if (IsGPUTessellation())
     {
-        float u = (float)i / m_ResolutionU;
-
-        for (unsigned int j = 0; j <= m_ResolutionV; j++)
+        // The GPU evaluates the surface, the control points themselves stand in as the mesh. The
+        // surface lies inside their hull, so bounds and culling still hold
+        for (unsigned int i = 0; i < m_NumControlPointsU; i++)
         {
-            float v = (float)j / m_ResolutionV;
-
-            glm::vec3 point = CalculatePoint(u, v);
-            glm::vec3 normal = CalculateNormal(u, v);
-
-            m_Vertices.push_back(point.x);
-            m_Vertices.push_back(point.y);
-            m_Vertices.push_back(point.z);
-
-            m_Vertices.push_back(normal.x);
-            m_Vertices.push_back(normal.y);
-            m_Vertices.push_back(normal.z);
+            for (unsigned int j = 0; j < m_NumControlPointsV; j++)
+            {
+                glm::vec3 point = GetControlPoint(i, j);
+                glm::vec3 normal = CalculateNormal((float)i / (m_NumControlPointsU - 1), (float)j / (m_NumControlPointsV - 1));
+                m_Vertices.insert(m_Vertices.end(), { point.x, point.y, point.z, normal.x, normal.y, normal.z });
+            }
         }
+        for (unsigned int i = 0; i + 1 < m_NumControlPointsU; i++)
+        {
+            for (unsigned int j = 0; j + 1 < m_NumControlPointsV; j++)
+            {
+                unsigned int p0 = i * m_NumControlPointsV + j;
+                unsigned int p2 = p0 + m_NumControlPointsV;
+                m_Indices.insert(m_Indices.end(), { p0, p2, p0 + 1, p0 + 1, p2, p2 + 1 });
+            }
+        }
+        SetupMesh();
+        return;
+    }
+
+    if (m_AdaptiveTessellation)
+    {
+        m_AdaptiveTessellator.ChooseLevels(m_ControlPoints.data(), m_NumControlPointsU, m_NumControlPointsV, m_AdaptiveTolerance, m_HasView ? &m_View : nullptr);
+        m_AdaptiveTessellator.Tessellate(m_Vertices, m_Indices);
+        SetupMesh();
+        return;
     }
 
+    // All vertices in one pass over the basis tables, normals from the derivative tables
+    m_Evaluator.Build(m_NumControlPointsU - 1, m_NumControlPointsV - 1, m_ResolutionU, m_ResolutionV);
+    m_Vertices.resize(m_Evaluator.GetVertexCount() * PatchEvaluator::s_VertexStride);
+    m_Frame.resize(m_Evaluator.GetFrameSize());
+    m_Evaluator.Evaluate(m_ControlPoints.data(), m_Vertices.data(), true, m_Frame.data());
+    m_IncrementalUpdates = 0;
+
     // For better visualization, each area in our surface we define the two triangles defining the surface
     for (unsigned int i = 0; i < m_ResolutionU; i++)
     {
@@ -117,120 +151,355 @@ void BezierSurface::Update()
 {
     // Re-generate the mesh with current parameters
     Generate();
+    if (m_LODLevelCount > 0)
+        GenerateLODs(m_LODLevelCount);
 }
 
-std::vector<float> BezierSurface::GetFlattenedControlPoints() const
+void BezierSurface::GenerateLODs(unsigned int levelCount)
 {
-    std::vector<float> flattenedPoints;
+    // The adaptive and GPU tessellated meshes already follow the view
+    if (m_AdaptiveTessellation || IsGPUTessellation())
+    {
+        ClearLODs();
+        Generate();
+        return;
+    }
 
-    for (const auto& row : m_ControlPoints)
+    m_LODMeshes.clear();
+    m_LODErrors.clear();
+    m_LODLevelCount = levelCount;
+
+    // Halve the U/V resolution at every level, Generate always works on m_ResolutionU/V
+    unsigned int baseResolutionU = m_ResolutionU;
+    unsigned int baseResolutionV = m_ResolutionV;
+    for (unsigned int level = 0; level < levelCount; level++)
     {
-        for (const auto& point : row)
-        {
-            flattenedPoints.push_back(point.x);
-            flattenedPoints.push_back(point.y);
-            flattenedPoints.push_back(point.z);
-        }
+        Generate();
+        if (!m_Mesh)
+            break;
+
+        m_LODMeshes.push_back(m_Mesh);
+        m_LODErrors.push_back(EstimateTessellationError(m_ResolutionU, m_ResolutionV));
+
+        if (m_ResolutionU <= 2 && m_ResolutionV <= 2)
+            break;
+        m_ResolutionU = std::max(m_ResolutionU / 2, 2u);
+        m_ResolutionV = std::max(m_ResolutionV / 2, 2u);
     }
 
-    return flattenedPoints;
+    m_ResolutionU = baseResolutionU;
+    m_ResolutionV = baseResolutionV;
+    m_CurrentLOD = 0;
+    if (!m_LODMeshes.empty())
+        m_Mesh = m_LODMeshes[0];
 }
 
-std::vector<float> BezierSurface::GetControlPointGridLines() const
+void BezierSurface::SetAdaptiveTessellation(bool enabled, float tolerance)
 {
-    std::vector<float> gridLines;
+    m_AdaptiveTessellation = enabled;
+    m_AdaptiveTolerance = tolerance;
+    Update();
+}
 
-    // Horizontal grid lines
-    for (unsigned int i = 0; i < m_NumControlPointsU; i++)
+bool BezierSurface::UpdateTessellation(const Camera& camera, float viewportHeight, float maxPixelError)
+{
+    if (!m_AdaptiveTessellation || IsGPUTessellation() || m_NumControlPointsU < 2 || m_NumControlPointsV < 2)
+        return false;
+
+    m_View.Model = GetModelMatrix();
+    m_View.CameraPosition = camera.GetPosition();
+    m_View.PixelsPerUnit = viewportHeight / (2.0f * std::tan(glm::radians(camera.GetZoom()) * 0.5f));
+    m_View.MaxPixelError = maxPixelError;
+    m_HasView = true;
+
+    // Moving the camera mostly leaves the levels alone, the mesh stays as it is then
+    if (!m_AdaptiveTessellator.ChooseLevels(m_ControlPoints.data(), m_NumControlPointsU, m_NumControlPointsV, m_AdaptiveTolerance, &m_View))
+        return false;
+
+    m_Vertices.clear();
+    m_Indices.clear();
+    m_AdaptiveTessellator.Tessellate(m_Vertices, m_Indices);
+    SetupMesh();
+    return true;
+}
+
+void BezierSurface::SetGPUTessellation(bool enabled)
+{
+    m_GPUTessellation = enabled;
+    Update();
+}
+
+bool BezierSurface::SupportsGPUTessellation() const
+{
+    // Tessellation shaders are core since GL 4.0, the patch shader takes bicubic patches
+    return GLAD_GL_VERSION_4_0 && m_NumControlPointsU == 4 && m_NumControlPointsV == 4;
+}
+
+void BezierSurface::DrawTessellated(Shader& shader, const glm::mat4& view, const glm::mat4& projection, const Camera& camera,
+    float viewportHeight, float segmentPixels) const
+{
+    if (!SupportsGPUTessellation())
+        return;
+
+    // Same buffer as the control net drawing, moved points are already patched in place
+    UpdateControlNetBuffers();
+
+    shader.Bind();
+    shader.SetUniformMat4f("u_Model", GetModelMatrix());
+    shader.SetUniformMat4f("u_View", view);
+    shader.SetUniformMat4f("u_Projection", projection);
+    glm::vec3 cameraPosition = camera.GetPosition();
+    shader.SetUniform3f("u_CameraPosition", cameraPosition.x, cameraPosition.y, cameraPosition.z);
+    shader.SetUniform1f("u_PixelsPerUnit", viewportHeight / (2.0f * std::tan(glm::radians(camera.GetZoom()) * 0.5f)));
+    shader.SetUniform1f("u_SegmentPixels", segmentPixels);
+
+    m_ControlNetVAO->Bind();
+    if (m_WireframeMode)
     {
-        for (unsigned int j = 0; j < m_NumControlPointsV - 1; j++)
-        {
-            gridLines.push_back(m_ControlPoints[i][j].x);
-            gridLines.push_back(m_ControlPoints[i][j].y);
-            gridLines.push_back(m_ControlPoints[i][j].z);
+        GLCall(glPolygonMode(GL_FRONT_AND_BACK, GL_LINE));
+    }
 
-            gridLines.push_back(m_ControlPoints[i][j + 1].x);
-            gridLines.push_back(m_ControlPoints[i][j + 1].y);
-            gridLines.push_back(m_ControlPoints[i][j + 1].z);
-        }
+    GLCall(glPatchParameteri(GL_PATCH_VERTICES, 16));
+    GLCall(glDrawArrays(GL_PATCHES, 0, m_ControlPoints.size()));
+
+    if (m_WireframeMode)
+    {
+        GLCall(glPolygonMode(GL_FRONT_AND_BACK, GL_FILL));
     }
+    m_ControlNetVAO->Unbind();
+    shader.Unbind();
+}
 
-    // Vertical grid lines
-    for (unsigned int j = 0; j < m_NumControlPointsV; j++)
+float BezierSurface::EstimateTessellationError(unsigned int resolutionU, unsigned int resolutionV) const
+{
+    // Distance between the surface and the two triangles of each cell, sampled at the cell center
+    float maxError = 0.0f;
+    for (unsigned int i = 0; i < resolutionU; i++)
     {
-        for (unsigned int i = 0; i < m_NumControlPointsU - 1; i++)
+        float u0 = (float)i / resolutionU;
+        float u1 = (float)(i + 1) / resolutionU;
+
+        for (unsigned int j = 0; j < resolutionV; j++)
         {
-            gridLines.push_back(m_ControlPoints[i][j].x);
-            gridLines.push_back(m_ControlPoints[i][j].y);
-            gridLines.push_back(m_ControlPoints[i][j].z);
+            float v0 = (float)j / resolutionV;
+            float v1 = (float)(j + 1) / resolutionV;
 
-            gridLines.push_back(m_ControlPoints[i + 1][j].x);
-            gridLines.push_back(m_ControlPoints[i + 1][j].y);
-            gridLines.push_back(m_ControlPoints[i + 1][j].z);
+            // The shared diagonal of the two triangles goes from (u0, v1) to (u1, v0)
+            glm::vec3 diagonalCenter = (CalculatePoint(u0, v1) + CalculatePoint(u1, v0)) * 0.5f;
+            glm::vec3 surfaceCenter = CalculatePoint((u0 + u1) * 0.5f, (v0 + v1) * 0.5f);
+            maxError = std::max(maxError, glm::length(surfaceCenter - diagonalCenter));
         }
     }
+    return maxError;
+}
 
-    return gridLines;
+void BezierSurface::SetControlPoints(const std::vector<glm::vec3>& points, unsigned int countU, unsigned int countV)
+{
+    ASSERT(points.size() == countU * countV);
+    if (countU != m_NumControlPointsU || countV != m_NumControlPointsV)
+        m_GridLineIBO.reset();
+
+    m_ControlPoints = points;
+    m_NumControlPointsU = countU;
+    m_NumControlPointsV = countV;
+    MarkControlNetDirty();
+    m_ControlPointIndexDirty = true;
+    Update();
 }
 
-glm::vec3 BezierSurface::CalculatePoint(float u, float v) const
+void BezierSurface::SetControlPoint(unsigned int i, unsigned int j, const glm::vec3& point)
 {
-    std::vector<glm::vec3> tempPoints;
+    if (i >= m_NumControlPointsU || j >= m_NumControlPointsV)
+        return;
 
-    for (unsigned int j = 0; j < m_NumControlPointsV; j++)
+    glm::vec3& controlPoint = m_ControlPoints[i * m_NumControlPointsV + j];
+    glm::vec3 delta = point - controlPoint;
+    controlPoint = point;
+    MarkControlNetDirty();
+    if (!m_ControlPointIndexDirty)
+        m_ControlPointIndex.Update(i * m_NumControlPointsV + j, point);
+
+    if (!CanUpdateIncrementally())
     {
-        std::vector<glm::vec3> uPoints;
-        for (unsigned int i = 0; i < m_NumControlPointsU; i++)
-        {
-            uPoints.push_back(m_ControlPoints[i][j]);
-        }
-        tempPoints.push_back(DeCasteljau(uPoints, u));
+        Update();
+        return;
     }
 
-    // Then use these points to calculate the final point in the v direction
-    return DeCasteljau(tempPoints, v);
+    // Vertex order is the evaluator's, every vertex moves by delta * B_i(u) * B_j(v)
+    m_StagingVertices.resize(m_Evaluator.GetVertexCount() * PatchEvaluator::s_VertexStride);
+    if (++m_IncrementalUpdates < s_MaxIncrementalUpdates)
+    {
+        m_Evaluator.ApplyControlPointDelta(m_ControlPoints.data(), i, j, delta, m_Frame.data(), m_StagingVertices.data());
+    }
+    else
+    {
+        m_Evaluator.Evaluate(m_ControlPoints.data(), m_StagingVertices.data(), true, m_Frame.data());
+        m_IncrementalUpdates = 0;
+    }
+
+    m_Mesh->UpdateVertices(m_StagingVertices.data(), 0, m_Evaluator.GetVertexCount());
+    m_WorldBoundsDirty = true;
 }
 
-glm::vec3 BezierSurface::DeCasteljau(const std::vector<glm::vec3>& points, float t) const
+bool BezierSurface::CanUpdateIncrementally() const
 {
-    if (points.size() == 1)
-        return points[0];
+    // The evaluator and frame match m_Mesh only when it came straight out of Generate
+    return m_Mesh && !m_AdaptiveTessellation && !IsGPUTessellation() && m_LODMeshes.empty() && m_VertexFormat == VertexFormat::Float && !m_OptimizeMesh &&
+        m_Mesh->GetVertexCount() == m_Evaluator.GetVertexCount() && m_Frame.size() == m_Evaluator.GetFrameSize();
+}
 
-    std::vector<glm::vec3> newPoints;
-    for (size_t i = 0; i < points.size() - 1; i++)
+const ControlPointBVH& BezierSurface::GetControlPointIndex() const
+{
+    if (m_ControlPointIndexDirty)
     {
-        glm::vec3 newPoint = (1.0f - t) * points[i] + t * points[i + 1];
-        newPoints.push_back(newPoint);
+        m_ControlPointIndex.Build(m_ControlPoints.data(), m_ControlPoints.size());
+        m_ControlPointIndexDirty = false;
     }
+    return m_ControlPointIndex;
+}
 
-    return DeCasteljau(newPoints, t);
+bool BezierSurface::PickControlPoint(const Ray& ray, float maxSlope, unsigned int& i, unsigned int& j) const
+{
+    glm::mat4 inverseModel = glm::inverse(GetModelMatrix());
+    glm::vec3 origin = glm::vec3(inverseModel * glm::vec4(ray.GetOrigin(), 1.0f));
+    glm::vec3 direction = glm::normalize(glm::vec3(inverseModel * glm::vec4(ray.GetDirection(), 0.0f)));
+
+    unsigned int index;
+    if (!GetControlPointIndex().FindClosestToRay(origin, direction, maxSlope, index))
+        return false;
+
+    i = index / m_NumControlPointsV;
+    j = index % m_NumControlPointsV;
+    return true;
 }
 
-glm::vec3 BezierSurface::CalculateNormal(float u, float v) const
+void BezierSurface::SelectControlPoints(const glm::mat4& viewProjection, std::vector<unsigned int>& selected) const
 {
-    const float delta = 0.01f;
+    // Planes of the clip volume in model space
+    GetControlPointIndex().FindInFrustum(Frustum(viewProjection * GetModelMatrix()), selected);
+}
 
-    glm::vec3 point = CalculatePoint(u, v);
+void BezierSurface::MarkControlNetDirty()
+{
+    m_GridLinesDirty = true;
+    m_ControlNetDirty = true;
+}
 
-    // Calculate partial derivatives
-    glm::vec3 du;
-    if (u + delta <= 1.0f)
-        du = CalculatePoint(u + delta, v) - point;
-    else
-        du = point - CalculatePoint(u - delta, v);
+const std::vector<float>& BezierSurface::GetControlPointGridLines() const
+{
+    if (!m_GridLinesDirty)
+        return m_GridLines;
 
-    glm::vec3 dv;
-    if (v + delta <= 1.0f)
-        dv = CalculatePoint(u, v + delta) - point;
-    else
-        dv = point - CalculatePoint(u, v - delta);
+    m_GridLines.clear();
+    m_GridLines.reserve((m_NumControlPointsU * (m_NumControlPointsV - 1) + m_NumControlPointsV * (m_NumControlPointsU - 1)) * 6);
+    auto addLine = [&](const glm::vec3& a, const glm::vec3& b)
+    {
+        m_GridLines.insert(m_GridLines.end(), { a.x, a.y, a.z, b.x, b.y, b.z });
+    };
 
-    // Cross product to get normal
-    glm::vec3 normal = glm::cross(du, dv);
-    if (glm::length(normal) > 0.0001f)
-        normal = glm::normalize(normal);
-    else
-        normal = glm::vec3(0.0f, 0.0f, 1.0f); // Default normal if calculation failed
+    // Horizontal grid lines, consecutive points of a row
+    for (unsigned int i = 0; i < m_NumControlPointsU; i++)
+    {
+        const glm::vec3* row = &m_ControlPoints[i * m_NumControlPointsV];
+        for (unsigned int j = 0; j + 1 < m_NumControlPointsV; j++)
+            addLine(row[j], row[j + 1]);
+    }
+
+    // Vertical grid lines, one row apart
+    for (unsigned int j = 0; j < m_NumControlPointsV; j++)
+    {
+        for (unsigned int i = 0; i + 1 < m_NumControlPointsU; i++)
+            addLine(m_ControlPoints[i * m_NumControlPointsV + j], m_ControlPoints[(i + 1) * m_NumControlPointsV + j]);
+    }
+
+    m_GridLinesDirty = false;
+    return m_GridLines;
+}
+
+void BezierSurface::UpdateControlNetBuffers() const
+{
+    if (!m_ControlNetVAO || m_ControlNetVBO->GetSize() != GetControlPointDataSize())
+    {
+        // First use or new dimensions, the points are uploaded as they are stored
+        m_ControlNetVAO = std::make_unique<VertexArray>();
+        m_ControlNetVBO = std::make_unique<VertexBuffer>();
+        m_ControlNetVBO->SetData(GetControlPointData(), GetControlPointDataSize());
+
+        VertexBufferLayout layout;
+        layout.Push<float>(3); // Position only
+        m_ControlNetVAO->AddBuffer(*m_ControlNetVBO, layout);
+        m_GridLineIBO.reset();
+    }
+    else if (m_ControlNetDirty)
+    {
+        m_ControlNetVBO->UpdateData(GetControlPointData(), 0, GetControlPointDataSize());
+    }
+    m_ControlNetDirty = false;
+
+    if (!m_GridLineIBO)
+    {
+        // Same segments as GetControlPointGridLines, as indices into the point buffer
+        std::vector<unsigned int> indices;
+        for (unsigned int i = 0; i < m_NumControlPointsU; i++)
+        {
+            for (unsigned int j = 0; j + 1 < m_NumControlPointsV; j++)
+                indices.insert(indices.end(), { i * m_NumControlPointsV + j, i * m_NumControlPointsV + j + 1 });
+        }
+        for (unsigned int j = 0; j < m_NumControlPointsV; j++)
+        {
+            for (unsigned int i = 0; i + 1 < m_NumControlPointsU; i++)
+                indices.insert(indices.end(), { i * m_NumControlPointsV + j, (i + 1) * m_NumControlPointsV + j });
+        }
+
+        // The element array binding belongs to the VAO
+        m_ControlNetVAO->Bind();
+        m_GridLineIBO = std::make_unique<IndexBuffer>(indices.data(), indices.size());
+    }
+}
+
+void BezierSurface::DrawControlNet(Shader& shader, const glm::mat4& view, const glm::mat4& projection) const
+{
+    if (m_ControlPoints.empty())
+        return;
+
+    UpdateControlNetBuffers();
 
-    return normal;
-}
\ No newline at end of file
+    shader.Bind();
+    shader.SetUniformMat4f("u_Model", GetModelMatrix());
+    shader.SetUniformMat4f("u_View", view);
+    shader.SetUniformMat4f("u_Projection", projection);
+
+    m_ControlNetVAO->Bind();
+    m_GridLineIBO->Bind();
+    shader.SetUniform4f("u_Color", 0.6f, 0.6f, 0.6f, 1.0f);
+    GLCall(glDrawElements(GL_LINES, m_GridLineIBO->GetCount(), m_GridLineIBO->GetType(), nullptr));
+
+    shader.SetUniform4f("u_Color", 1.0f, 0.5f, 0.0f, 1.0f);
+    GLCall(glPointSize(6.0f));
+    GLCall(glDrawArrays(GL_POINTS, 0, m_ControlPoints.size()));
+    m_ControlNetVAO->Unbind();
+}
+
+glm::vec3 BezierSurface::CalculatePoint(float u, float v) const
+{
+    // Rows are contiguous, each reduced to its point at v, then those points at u
+    glm::vec3 columnStack[s_MaxStackControlPoints];
+    std::vector<glm::vec3> columnHeap;
+    glm::vec3* column = columnStack;
+    if (m_NumControlPointsU > s_MaxStackControlPoints)
+    {
+        columnHeap.resize(m_NumControlPointsU);
+        column = columnHeap.data();
+    }
+
+    for (unsigned int i = 0; i < m_NumControlPointsU; i++)
+        column[i] = EvaluateBezier(&m_ControlPoints[i * m_NumControlPointsV], m_NumControlPointsV, v);
+
+    return DeCasteljauInPlace(column, m_NumControlPointsU, u);
+}
+
+glm::vec3 BezierSurface::CalculateNormal(float u, float v) const
+{
+    // Exact derivatives in the same pass as the point, no finite differences across the border
+    return PatchEvaluator::EvaluatePoint(m_ControlPoints.data(), m_NumControlPointsU, m_NumControlPointsV, u, v).Normal;
+}
@@ -60,6 +60,19 @@ void Camera::ProcessMouseScroll(float yoffset)
     m_Zoom = std::max(1.0f, std::min(45.0f, m_Zoom));
 }
 
+void Camera::LookAlong(const glm::vec3& position, const glm::vec3& direction)
+{
+    m_Position = position;
+    if (glm::length(direction) <= 0.0f)
+        return;
+
+    // Back to yaw / pitch so mouse look continues from here
+    glm::vec3 front = glm::normalize(direction);
+    m_Pitch = std::max(-89.0f, std::min(89.0f, glm::degrees(glm::asin(front.y))));
+    m_Yaw = glm::degrees(glm::atan(front.z, front.x));
+    UpdateCameraVectors();
+}
+
 void Camera::UpdateCameraVectors()
 {
     // Calculate the new front vector
@@ -6,9 +6,11 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <memory>
 #include <vector>
+#include <algorithm>
 
 #include "Renderer.h"
 #include "Shader.h"
+#include "ShaderCache.h"
 #include "Camera.h"
 
 // Include our new Shape classes
@@ -16,6 +18,9 @@
 #include "Cube.h"
 #include "Sphere.h"
 #include "BezierSurface.h"
+#include "BezierCurve.h"
+#include "Frustum.h"
+#include "FrustumCuller.h"
 
 // Global variables
 Camera camera(glm::vec3(0.0f, 0.0f, 6.0f));
@@ -24,6 +29,12 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+// Camera fly-through around the shapes, played over cameraPathDuration seconds
+const CubicBezier3D cameraPath({ glm::vec3(-8.0f, 1.0f, 8.0f), glm::vec3(-6.0f, 3.0f, -6.0f), glm::vec3(6.0f, -1.0f, -6.0f), glm::vec3(8.0f, 1.0f, 8.0f) });
+const float cameraPathDuration = 8.0f;
+bool cameraPathPlaying = false;
+float cameraPathStart = 0.0f;
+
 // Current shape selection
 enum ShapeType { CUBE, SPHERE, BEZIER_SURFACE };
 ShapeType currentShape = CUBE;
@@ -100,6 +111,113 @@ void processInput(GLFWwindow* window, std::vector<std::unique_ptr<Shape>>& shape
     }
     if (glfwGetKey(window, GLFW_KEY_3) == GLFW_RELEASE)
         key3Pressed = false;
+
+    // Cycle vertex formats (float -> quantized -> packed)
+    static bool keyCPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS && !keyCPressed)
+    {
+        static const char* formatNames[] = { "Float (24 bytes)", "Quantized (12 bytes)", "Packed (8 bytes)" };
+        int next = ((int)shapes[currentShape]->GetVertexFormat() + 1) % 3;
+        for (auto& shape : shapes)
+        {
+            shape->SetVertexFormat((VertexFormat)next);
+        }
+        keyCPressed = true;
+        std::cout << "Vertex format: " << formatNames[next]
+            << ", GPU buffer size: " << shapes[currentShape]->GetGPUBufferSize() << " bytes" << std::endl;
+    }
+    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_RELEASE)
+        keyCPressed = false;
+
+    // Toggle vertex cache / overdraw optimization
+    static bool keyOPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS && !keyOPressed)
+    {
+        bool optimize = !shapes[currentShape]->IsMeshOptimized();
+        for (auto& shape : shapes)
+        {
+            shape->SetMeshOptimization(optimize);
+        }
+        keyOPressed = true;
+        std::cout << "Mesh optimization: " << (optimize ? "ON" : "OFF") << std::endl;
+        if (optimize)
+        {
+            for (auto& shape : shapes)
+            {
+                // Shapes that picked up a cached mesh did not optimize it themselves
+                const MeshOptimizationReport& report = shape->GetOptimizationReport();
+                if (report.VerticesBefore == 0)
+                    continue;
+                std::cout << "[MeshOptimizer] vertices " << report.VerticesBefore << " -> " << report.VerticesAfter
+                    << ", ACMR " << report.Before.ACMR << " -> " << report.After.ACMR
+                    << ", ATVR " << report.Before.ATVR << " -> " << report.After.ATVR << std::endl;
+            }
+        }
+    }
+    if (glfwGetKey(window, GLFW_KEY_O) == GLFW_RELEASE)
+        keyOPressed = false;
+
+    // Play the camera path
+    static bool keyPPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS && !keyPPressed)
+    {
+        cameraPathPlaying = !cameraPathPlaying;
+        cameraPathStart = glfwGetTime();
+        keyPPressed = true;
+        std::cout << "Camera path: " << (cameraPathPlaying ? "PLAYING" : "STOPPED") << std::endl;
+    }
+    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_RELEASE)
+        keyPPressed = false;
+
+    // Toggle screen space error driven level of detail
+    static bool keyLPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS && !keyLPressed)
+    {
+        bool enableLOD = shapes[currentShape]->GetLODCount() == 0;
+        for (auto& shape : shapes)
+        {
+            if (enableLOD)
+                shape->GenerateLODs(5);
+            else
+                shape->ClearLODs();
+        }
+        keyLPressed = true;
+        std::cout << "Level of detail: " << (enableLOD ? "ON" : "OFF") << std::endl;
+    }
+    if (glfwGetKey(window, GLFW_KEY_L) == GLFW_RELEASE)
+        keyLPressed = false;
+
+    // Toggle view dependent tessellation of the Bezier surface
+    static bool keyTPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS && !keyTPressed)
+    {
+        BezierSurface* surface = static_cast<BezierSurface*>(shapes[BEZIER_SURFACE].get());
+        bool adaptive = !surface->IsAdaptiveTessellation();
+        surface->SetAdaptiveTessellation(adaptive);
+        keyTPressed = true;
+        std::cout << "Adaptive tessellation: " << (adaptive ? "ON" : "OFF") << std::endl;
+    }
+    if (glfwGetKey(window, GLFW_KEY_T) == GLFW_RELEASE)
+        keyTPressed = false;
+
+    // Toggle tessellation shaders for the Bezier surface
+    static bool keyGPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS && !keyGPressed)
+    {
+        BezierSurface* surface = static_cast<BezierSurface*>(shapes[BEZIER_SURFACE].get());
+        keyGPressed = true;
+        if (surface->SupportsGPUTessellation())
+        {
+            surface->SetGPUTessellation(!surface->IsGPUTessellation());
+            std::cout << "GPU tessellation: " << (surface->IsGPUTessellation() ? "ON" : "OFF") << std::endl;
+        }
+        else
+        {
+            std::cout << "GPU tessellation needs OpenGL 4.0 and a bicubic control net" << std::endl;
+        }
+    }
+    if (glfwGetKey(window, GLFW_KEY_G) == GLFW_RELEASE)
+        keyGPressed = false;
 }
 
 // Mouse callback for camera rotation
@@ -171,6 +289,12 @@ int main()
     std::cout << "Ctrl      - Move down" << std::endl;
     std::cout << "F         - Toggle wireframe mode" << std::endl;
     std::cout << "1,2,3     - Select shape (Cube, Sphere, Bezier Surface)" << std::endl;
+    std::cout << "C         - Cycle vertex format (float, quantized, packed)" << std::endl;
+    std::cout << "O         - Toggle mesh optimization (vertex cache, overdraw, fetch)" << std::endl;
+    std::cout << "L         - Toggle level of detail" << std::endl;
+    std::cout << "P         - Play camera path" << std::endl;
+    std::cout << "T         - Toggle adaptive tessellation of the Bezier surface" << std::endl;
+    std::cout << "G         - Toggle GPU tessellation of the Bezier surface (OpenGL 4.0)" << std::endl;
 
     // Enable depth testing
     GLCall(glEnable(GL_DEPTH_TEST));
@@ -195,7 +319,14 @@ int main()
 
     {
         // Create shaders
-        Shader shader("res/shaders/Basic3D.shader");
+        Shader basicShader("res/shaders/Basic3D.shader");
+        Shader compressedShader("res/shaders/Compressed3D.shader");
+        // Solid color only, the gradient branch is compiled out. Tessellation shaders are core since
+        // GL 4.0, older contexts keep tessellating on the CPU
+        std::shared_ptr<Shader> patchShader;
+        if (GLAD_GL_VERSION_4_0)
+            patchShader = Shader::GetVariant("res/shaders/BezierPatch.shader", { { "USE_GRADIENT", "0" } });
+        ShaderCache::Get().PrintReport();
 
         // Prepare light properties
         glm::vec3 lightPos(2.0f, 2.0f, 2.0f);
@@ -205,6 +336,10 @@ int main()
         Renderer renderer;
         renderer.SetClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 
+        // Frustum culling of the shapes, indices match the shapes vector
+        FrustumCuller culler;
+        std::vector<unsigned int> visibleShapes;
+
         // Main loop
         while (!glfwWindowShouldClose(window))
         {
@@ -216,6 +351,18 @@ int main()
             // Process input
             processInput(window, shapes);
 
+            // Follow the camera path, looking along its tangent
+            if (cameraPathPlaying)
+            {
+                float t = (currentFrame - cameraPathStart) / cameraPathDuration;
+                if (t >= 1.0f)
+                {
+                    t = 1.0f;
+                    cameraPathPlaying = false;
+                }
+                camera.LookAlong(cameraPath.Evaluate(t), cameraPath.Derivative(t));
+            }
+
             // Clear frame
             renderer.Clear();
             GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
@@ -224,6 +371,12 @@ int main()
             glm::mat4 view = camera.GetViewMatrix();
             glm::mat4 projection = glm::perspective(glm::radians(camera.GetZoom()), 800.0f / 600.0f, 0.1f, 100.0f);
 
+            // Compressed vertex formats are decoded by their own shader, GPU tessellated patches by theirs
+            BezierSurface* surface = static_cast<BezierSurface*>(shapes[BEZIER_SURFACE].get());
+            bool tessellatedOnGPU = patchShader && currentShape == BEZIER_SURFACE && surface->IsGPUTessellation();
+            Shader& shader = tessellatedOnGPU ? *patchShader :
+                shapes[currentShape]->GetVertexFormat() == VertexFormat::Float ? basicShader : compressedShader;
+
             // Bind shader and set common uniforms
             shader.Bind();
             shader.SetUniform3f("u_LightPosition", lightPos.x, lightPos.y, lightPos.z);
@@ -241,8 +394,34 @@ int main()
                 shader.SetUniform4f("u_Color", 0.1f, 0.1f, 0.8f, 1.0f); // Blue for Bezier surface
             }
 
+            // Pick the level of detail from the projected error (1 pixel)
+            if (shapes[currentShape]->SelectLOD(camera, 600.0f))
+            {
+                std::cout << "LOD " << shapes[currentShape]->GetCurrentLOD() << ": "
+                    << shapes[currentShape]->GetIndexCount() / 3 << " triangles" << std::endl;
+            }
+
+            // Re-tessellate the adaptive Bezier surface when the view needs other levels
+            if (currentShape == BEZIER_SURFACE &&
+                static_cast<BezierSurface*>(shapes[BEZIER_SURFACE].get())->UpdateTessellation(camera, 600.0f))
+            {
+                std::cout << "Adaptive tessellation: " << shapes[BEZIER_SURFACE]->GetIndexCount() / 3 << " triangles" << std::endl;
+            }
+
+            // Cull against the camera frustum, the current shape is only drawn when visible
+            culler.Clear();
+            for (const auto& shape : shapes)
+                culler.Add(shape->GetWorldBoundsCenter(), shape->GetWorldBoundingRadius(), shape->GetWorldBoundsExtents());
+            culler.Cull(Frustum(projection * view), visibleShapes);
+
             // Draw the current shape
-            shapes[currentShape]->Draw(shader, view, projection);
+            if (std::find(visibleShapes.begin(), visibleShapes.end(), (unsigned int)currentShape) != visibleShapes.end())
+            {
+                if (tessellatedOnGPU)
+                    surface->DrawTessellated(shader, view, projection, camera, 600.0f);
+                else
+                    shapes[currentShape]->Draw(shader, view, projection);
+            }
 
             // Swap buffers and poll events
             glfwSwapBuffers(window);
@@ -0,0 +1,265 @@
+#include "ControlPointBVH.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Points per leaf
+static const unsigned int s_LeafSize = 8;
+
+// Whether the box reaches into the cone around the ray, and where the ray enters it. The box is
+// grown by the cone radius at its far end, so this only errs on the side of visiting
+static bool IntersectsCone(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::vec3& origin, const glm::vec3& direction, float slope, float& entry)
+{
+    glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+    glm::vec3 extents = (boundsMax - boundsMin) * 0.5f;
+    float farthest = glm::dot(center - origin, direction) + glm::dot(extents, glm::abs(direction));
+    if (farthest <= 0.0f)
+        return false;
+
+    glm::vec3 margin(slope * farthest);
+    glm::vec3 grownMin = boundsMin - margin;
+    glm::vec3 grownMax = boundsMax + margin;
+
+    // Slabs, t >= 0 only
+    float near = 0.0f;
+    float far = std::numeric_limits<float>::max();
+    for (int axis = 0; axis < 3; axis++)
+    {
+        if (std::abs(direction[axis]) < 1e-12f)
+        {
+            if (origin[axis] < grownMin[axis] || origin[axis] > grownMax[axis])
+                return false;
+            continue;
+        }
+
+        float t0 = (grownMin[axis] - origin[axis]) / direction[axis];
+        float t1 = (grownMax[axis] - origin[axis]) / direction[axis];
+        near = std::max(near, std::min(t0, t1));
+        far = std::min(far, std::max(t0, t1));
+        if (near > far)
+            return false;
+    }
+    entry = near;
+    return true;
+}
+
+ControlPointBVH::ControlPointBVH()
+    : m_Refits(0)
+{
+}
+
+ControlPointBVH::~ControlPointBVH()
+{
+}
+
+void ControlPointBVH::Clear()
+{
+    m_Points.clear();
+    m_Order.clear();
+    m_Leaves.clear();
+    m_Nodes.clear();
+    m_Refits = 0;
+}
+
+void ControlPointBVH::Build(const glm::vec3* points, unsigned int count)
+{
+    m_Points.assign(points, points + count);
+    m_Order.resize(count);
+    for (unsigned int i = 0; i < count; i++)
+        m_Order[i] = i;
+    m_Leaves.resize(count);
+    m_Nodes.clear();
+    m_Refits = 0;
+
+    if (count == 0)
+        return;
+
+    m_Nodes.reserve(2 * (count / s_LeafSize + 1));
+    m_Nodes.push_back(Node());
+    BuildNode(0, ~0u, 0, count);
+}
+
+void ControlPointBVH::BuildNode(unsigned int nodeIndex, unsigned int parent, unsigned int first, unsigned int count)
+{
+    glm::vec3 boundsMin = m_Points[m_Order[first]];
+    glm::vec3 boundsMax = boundsMin;
+    for (unsigned int i = first + 1; i < first + count; i++)
+    {
+        boundsMin = glm::min(boundsMin, m_Points[m_Order[i]]);
+        boundsMax = glm::max(boundsMax, m_Points[m_Order[i]]);
+    }
+    m_Nodes[nodeIndex].Min = boundsMin;
+    m_Nodes[nodeIndex].Max = boundsMax;
+    m_Nodes[nodeIndex].Parent = parent;
+
+    if (count <= s_LeafSize)
+    {
+        m_Nodes[nodeIndex].First = first;
+        m_Nodes[nodeIndex].Count = count;
+        for (unsigned int i = first; i < first + count; i++)
+            m_Leaves[m_Order[i]] = nodeIndex;
+        return;
+    }
+
+    // Median along the longest axis
+    glm::vec3 size = boundsMax - boundsMin;
+    int axis = size.x >= size.y ? (size.x >= size.z ? 0 : 2) : (size.y >= size.z ? 1 : 2);
+    unsigned int half = count / 2;
+    std::nth_element(m_Order.begin() + first, m_Order.begin() + first + half, m_Order.begin() + first + count,
+        [this, axis](unsigned int a, unsigned int b) { return m_Points[a][axis] < m_Points[b][axis]; });
+
+    unsigned int left = m_Nodes.size();
+    m_Nodes.push_back(Node());
+    m_Nodes.push_back(Node());
+    m_Nodes[nodeIndex].First = left;
+    m_Nodes[nodeIndex].Count = 0;
+
+    BuildNode(left, nodeIndex, first, half);
+    BuildNode(left + 1, nodeIndex, first + half, count - half);
+}
+
+void ControlPointBVH::Update(unsigned int index, const glm::vec3& point)
+{
+    m_Points[index] = point;
+
+    // Refitted boxes overlap more and more, start over once every point could have moved
+    if (++m_Refits > m_Points.size())
+    {
+        std::vector<glm::vec3> points;
+        points.swap(m_Points);
+        Build(points.data(), points.size());
+        return;
+    }
+
+    unsigned int nodeIndex = m_Leaves[index];
+    Node& leaf = m_Nodes[nodeIndex];
+    leaf.Min = leaf.Max = m_Points[m_Order[leaf.First]];
+    for (unsigned int i = leaf.First + 1; i < leaf.First + leaf.Count; i++)
+    {
+        leaf.Min = glm::min(leaf.Min, m_Points[m_Order[i]]);
+        leaf.Max = glm::max(leaf.Max, m_Points[m_Order[i]]);
+    }
+
+    // Up to the first box that comes out the same
+    while (m_Nodes[nodeIndex].Parent != ~0u)
+    {
+        nodeIndex = m_Nodes[nodeIndex].Parent;
+        Node& node = m_Nodes[nodeIndex];
+        glm::vec3 boundsMin = glm::min(m_Nodes[node.First].Min, m_Nodes[node.First + 1].Min);
+        glm::vec3 boundsMax = glm::max(m_Nodes[node.First].Max, m_Nodes[node.First + 1].Max);
+        if (boundsMin == node.Min && boundsMax == node.Max)
+            break;
+        node.Min = boundsMin;
+        node.Max = boundsMax;
+    }
+}
+
+bool ControlPointBVH::FindClosestToRay(const glm::vec3& origin, const glm::vec3& direction, float maxSlope, unsigned int& index) const
+{
+    if (m_Nodes.empty())
+        return false;
+
+    // The cone narrows to the best angle found so far
+    float bestSlope = maxSlope;
+    float bestDistance = std::numeric_limits<float>::max();
+    bool found = false;
+
+    unsigned int stack[64];
+    unsigned int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const Node& node = m_Nodes[stack[--stackSize]];
+        float entry;
+        if (!IntersectsCone(node.Min, node.Max, origin, direction, bestSlope, entry))
+            continue;
+
+        if (node.Count > 0)
+        {
+            for (unsigned int i = node.First; i < node.First + node.Count; i++)
+            {
+                glm::vec3 offset = m_Points[m_Order[i]] - origin;
+                float along = glm::dot(offset, direction);
+                if (along <= 0.0f)
+                    continue;
+
+                // Equal angles go to the nearer point
+                float slope = std::sqrt(std::max(glm::dot(offset, offset) - along * along, 0.0f)) / along;
+                if (slope < bestSlope || (slope == bestSlope && along < bestDistance))
+                {
+                    bestSlope = slope;
+                    bestDistance = along;
+                    index = m_Order[i];
+                    found = true;
+                }
+            }
+            continue;
+        }
+
+        // Child the ray enters first on top of the stack
+        float leftEntry = 0.0f, rightEntry = 0.0f;
+        bool leftHit = IntersectsCone(m_Nodes[node.First].Min, m_Nodes[node.First].Max, origin, direction, bestSlope, leftEntry);
+        bool rightHit = IntersectsCone(m_Nodes[node.First + 1].Min, m_Nodes[node.First + 1].Max, origin, direction, bestSlope, rightEntry);
+        if (leftHit && rightHit)
+        {
+            bool leftFirst = leftEntry <= rightEntry;
+            stack[stackSize++] = leftFirst ? node.First + 1 : node.First;
+            stack[stackSize++] = leftFirst ? node.First : node.First + 1;
+        }
+        else if (leftHit || rightHit)
+        {
+            stack[stackSize++] = leftHit ? node.First : node.First + 1;
+        }
+    }
+    return found;
+}
+
+void ControlPointBVH::FindInFrustum(const Frustum& frustum, std::vector<unsigned int>& indices) const
+{
+    indices.clear();
+    if (m_Nodes.empty())
+        return;
+
+    unsigned int stack[64];
+    unsigned int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        unsigned int nodeIndex = stack[--stackSize];
+        const Node& node = m_Nodes[nodeIndex];
+        glm::vec3 center = (node.Min + node.Max) * 0.5f;
+        glm::vec3 extents = (node.Max - node.Min) * 0.5f;
+        if (!frustum.IntersectsAABB(center, extents))
+            continue;
+
+        if (frustum.ContainsAABB(center, extents))
+        {
+            // A subtree holds one range of m_Order, from its leftmost to its rightmost leaf
+            unsigned int leftmost = nodeIndex, rightmost = nodeIndex;
+            while (m_Nodes[leftmost].Count == 0)
+                leftmost = m_Nodes[leftmost].First;
+            while (m_Nodes[rightmost].Count == 0)
+                rightmost = m_Nodes[rightmost].First + 1;
+            indices.insert(indices.end(), m_Order.begin() + m_Nodes[leftmost].First,
+                m_Order.begin() + m_Nodes[rightmost].First + m_Nodes[rightmost].Count);
+            continue;
+        }
+
+        if (node.Count > 0)
+        {
+            for (unsigned int i = node.First; i < node.First + node.Count; i++)
+            {
+                if (frustum.IntersectsSphere(m_Points[m_Order[i]], 0.0f))
+                    indices.push_back(m_Order[i]);
+            }
+            continue;
+        }
+
+        stack[stackSize++] = node.First;
+        stack[stackSize++] = node.First + 1;
+    }
+}
+
@@ -4,6 +4,8 @@
 Cube::Cube(float width, float height, float depth)
     : m_Width(width), m_Height(height), m_Depth(depth), m_Color(1.0f, 1.0f, 1.0f, 1.0f)
 {
+    // The mesh is a unit cube, the dimensions are applied through the model matrix
+    SetMeshScale(glm::vec3(m_Width, m_Height, m_Depth));
     Generate();
 }
 
@@ -13,12 +15,16 @@ Cube::~Cube()
 
 void Cube::Generate()
 {
+    // Every cube shares one unit mesh
+    if (UseCachedMesh("Cube"))
+        return;
+
     m_Vertices.clear();
     m_Indices.clear();
 
-    float halfWidth = m_Width / 2.0f;
-    float halfHeight = m_Height / 2.0f;
-    float halfDepth = m_Depth / 2.0f;
+    float halfWidth = 0.5f;
+    float halfHeight = 0.5f;
+    float halfDepth = 0.5f;
 
     // Vertex positions and normals
     // Format: x, y, z, nx, ny, nz
@@ -123,8 +129,8 @@ void Cube::Generate()
         m_Indices.push_back(indices[i]);
     }
 
-    // Setup OpenGL buffers
-    SetupMesh();
+    // Setup OpenGL buffers and share them
+    SetupCachedMesh("Cube");
 }
 
 void Cube::Update()
@@ -135,10 +141,11 @@ void Cube::Update()
 
 void Cube::SetDimensions(float width, float height, float depth)
 {
+    // Only the mesh scale changes, the shared unit mesh stays the same
     m_Width = width;
     m_Height = height;
     m_Depth = depth;
-    Update();
+    SetMeshScale(glm::vec3(m_Width, m_Height, m_Depth));
 }
 
 void Cube::SetColor(const glm::vec4& color)
@@ -0,0 +1,183 @@
+#include "CurveBatch.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <thread>
+
+// Below this many curves the threads cost more than they save
+static const unsigned int s_ParallelThreshold = 16384;
+
+CubicCurveBatch::CubicCurveBatch()
+{
+}
+
+CubicCurveBatch::~CubicCurveBatch()
+{
+}
+
+void CubicCurveBatch::Clear()
+{
+    for (int i = 0; i < 4; i++)
+    {
+        m_X[i].clear();
+        m_Y[i].clear();
+    }
+}
+
+void CubicCurveBatch::Reserve(unsigned int count)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        m_X[i].reserve(count);
+        m_Y[i].reserve(count);
+    }
+}
+
+unsigned int CubicCurveBatch::Add(const glm::vec2& p0, const glm::vec2& p1, const glm::vec2& p2, const glm::vec2& p3)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        m_X[i].push_back(0.0f);
+        m_Y[i].push_back(0.0f);
+    }
+    unsigned int index = GetCount() - 1;
+    SetCurve(index, p0, p1, p2, p3);
+    return index;
+}
+
+void CubicCurveBatch::SetCurve(unsigned int index, const glm::vec2& p0, const glm::vec2& p1, const glm::vec2& p2, const glm::vec2& p3)
+{
+    const glm::vec2* points[4] = { &p0, &p1, &p2, &p3 };
+    for (int i = 0; i < 4; i++)
+    {
+        m_X[i][index] = points[i]->x;
+        m_Y[i][index] = points[i]->y;
+    }
+}
+
+void CubicCurveBatch::Evaluate(unsigned int resolution, std::vector<float>& vertices, bool parallel) const
+{
+    // A curve needs both of its end points
+    resolution = std::max(1u, resolution);
+    unsigned int count = GetCount();
+    unsigned int vertexCount = count * (resolution + 1);
+    vertices.resize(vertexCount * 2);
+    if (count == 0)
+        return;
+
+    unsigned int threadCount = std::max(1u, std::thread::hardware_concurrency());
+    if (!parallel || count < s_ParallelThreshold || threadCount == 1)
+    {
+        EvaluateRange(0, count, resolution, vertices.data());
+        return;
+    }
+
+    // Contiguous chunks, a multiple of 8 curves so only the last one has a scalar tail
+    unsigned int chunk = ((count + threadCount - 1) / threadCount + 7) & ~7u;
+    std::vector<std::thread> threads;
+    for (unsigned int first = 0; first < count; first += chunk)
+    {
+        unsigned int last = std::min(first + chunk, count);
+        float* output = vertices.data() + first * (resolution + 1) * 2;
+        threads.emplace_back([this, first, last, resolution, output]() { EvaluateRange(first, last, resolution, output); });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+void CubicCurveBatch::EvaluateScalar(unsigned int resolution, std::vector<float>& vertices) const
+{
+    resolution = std::max(1u, resolution);
+    unsigned int count = GetCount();
+    vertices.resize(count * (resolution + 1) * 2);
+
+    float* output = vertices.data();
+    for (unsigned int c = 0; c < count; c++)
+    {
+        for (unsigned int s = 0; s <= resolution; s++)
+        {
+            float t = static_cast<float>(s) / static_cast<float>(resolution);
+            float u = 1.0f - t;
+            float b0 = u * u * u, b1 = 3.0f * u * u * t, b2 = 3.0f * u * t * t, b3 = t * t * t;
+            *output++ = b0 * m_X[0][c] + b1 * m_X[1][c] + b2 * m_X[2][c] + b3 * m_X[3][c];
+            *output++ = b0 * m_Y[0][c] + b1 * m_Y[1][c] + b2 * m_Y[2][c] + b3 * m_Y[3][c];
+        }
+    }
+}
+
+void CubicCurveBatch::EvaluateRange(unsigned int first, unsigned int last, unsigned int resolution, float* output) const
+{
+    const unsigned int stride = (resolution + 1) * 2; // Floats per curve
+    unsigned int c = first;
+
+#if defined(SIMD_AVX) || defined(SIMD_SSE)
+#if defined(SIMD_AVX)
+    const unsigned int width = 8;
+#else
+    const unsigned int width = 4;
+#endif
+    alignas(32) float x[8];
+    alignas(32) float y[8];
+
+    for (; c + width <= last; c += width)
+    {
+#if defined(SIMD_AVX)
+        __m256 x0 = _mm256_loadu_ps(&m_X[0][c]), x1 = _mm256_loadu_ps(&m_X[1][c]), x2 = _mm256_loadu_ps(&m_X[2][c]), x3 = _mm256_loadu_ps(&m_X[3][c]);
+        __m256 y0 = _mm256_loadu_ps(&m_Y[0][c]), y1 = _mm256_loadu_ps(&m_Y[1][c]), y2 = _mm256_loadu_ps(&m_Y[2][c]), y3 = _mm256_loadu_ps(&m_Y[3][c]);
+#else
+        __m128 x0 = _mm_loadu_ps(&m_X[0][c]), x1 = _mm_loadu_ps(&m_X[1][c]), x2 = _mm_loadu_ps(&m_X[2][c]), x3 = _mm_loadu_ps(&m_X[3][c]);
+        __m128 y0 = _mm_loadu_ps(&m_Y[0][c]), y1 = _mm_loadu_ps(&m_Y[1][c]), y2 = _mm_loadu_ps(&m_Y[2][c]), y3 = _mm_loadu_ps(&m_Y[3][c]);
+#endif
+        float* curveOutput = output + (c - first) * stride;
+
+        for (unsigned int s = 0; s <= resolution; s++)
+        {
+            // Same Bernstein weights for every lane
+            float t = static_cast<float>(s) / static_cast<float>(resolution);
+            float u = 1.0f - t;
+#if defined(SIMD_AVX)
+            __m256 b0 = _mm256_set1_ps(u * u * u), b1 = _mm256_set1_ps(3.0f * u * u * t);
+            __m256 b2 = _mm256_set1_ps(3.0f * u * t * t), b3 = _mm256_set1_ps(t * t * t);
+            _mm256_store_ps(x, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(b0, x0), _mm256_mul_ps(b1, x1)), _mm256_add_ps(_mm256_mul_ps(b2, x2), _mm256_mul_ps(b3, x3))));
+            _mm256_store_ps(y, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(b0, y0), _mm256_mul_ps(b1, y1)), _mm256_add_ps(_mm256_mul_ps(b2, y2), _mm256_mul_ps(b3, y3))));
+#else
+            __m128 b0 = _mm_set1_ps(u * u * u), b1 = _mm_set1_ps(3.0f * u * u * t);
+            __m128 b2 = _mm_set1_ps(3.0f * u * t * t), b3 = _mm_set1_ps(t * t * t);
+            _mm_store_ps(x, _mm_add_ps(_mm_add_ps(_mm_mul_ps(b0, x0), _mm_mul_ps(b1, x1)), _mm_add_ps(_mm_mul_ps(b2, x2), _mm_mul_ps(b3, x3))));
+            _mm_store_ps(y, _mm_add_ps(_mm_add_ps(_mm_mul_ps(b0, y0), _mm_mul_ps(b1, y1)), _mm_add_ps(_mm_mul_ps(b2, y2), _mm_mul_ps(b3, y3))));
+#endif
+            // Lanes go to their own curve in the curve major output
+            for (unsigned int lane = 0; lane < width; lane++)
+            {
+                curveOutput[lane * stride + s * 2] = x[lane];
+                curveOutput[lane * stride + s * 2 + 1] = y[lane];
+            }
+        }
+    }
+#endif
+
+    // Remaining curves (or everything without SIMD)
+    for (; c < last; c++)
+    {
+        float* curveOutput = output + (c - first) * stride;
+        for (unsigned int s = 0; s <= resolution; s++)
+        {
+            float t = static_cast<float>(s) / static_cast<float>(resolution);
+            float u = 1.0f - t;
+            float b0 = u * u * u, b1 = 3.0f * u * u * t, b2 = 3.0f * u * t * t, b3 = t * t * t;
+            curveOutput[s * 2] = b0 * m_X[0][c] + b1 * m_X[1][c] + b2 * m_X[2][c] + b3 * m_X[3][c];
+            curveOutput[s * 2 + 1] = b0 * m_Y[0][c] + b1 * m_Y[1][c] + b2 * m_Y[2][c] + b3 * m_Y[3][c];
+        }
+    }
+}
+
+void CubicCurveBatch::GetDrawRanges(unsigned int resolution, std::vector<int>& firsts, std::vector<int>& counts) const
+{
+    resolution = std::max(1u, resolution);
+    unsigned int count = GetCount();
+    firsts.resize(count);
+    counts.assign(count, resolution + 1);
+    for (unsigned int c = 0; c < count; c++)
+        firsts[c] = c * (resolution + 1);
+}
+
@@ -0,0 +1,239 @@
+#include "CurveFitting.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <glm/gtc/constants.hpp>
+
+// Pieces whose error is under this many tolerances are reparameterized before splitting
+static const float s_ReparameterizeFactor = 4.0f;
+static const int s_MaxNewtonIterations = 4;
+
+static glm::vec2 SafeNormalize(const glm::vec2& v)
+{
+    float length = glm::length(v);
+    return length > 0.0f ? v / length : glm::vec2(0.0f);
+}
+
+// Chord length parameter of each sample of [first, last]
+static void ChordLengthParameterize(const glm::vec2* points, unsigned int count, std::vector<float>& u)
+{
+    u.resize(count);
+    u[0] = 0.0f;
+    for (unsigned int i = 1; i < count; i++)
+        u[i] = u[i - 1] + glm::length(points[i] - points[i - 1]);
+
+    float total = u[count - 1];
+    for (unsigned int i = 1; i < count; i++)
+        u[i] = total > 0.0f ? u[i] / total : static_cast<float>(i) / (count - 1);
+}
+
+// Least squares control points along the given end tangents
+static CubicBezier2D GenerateBezier(const glm::vec2* points, unsigned int count, const std::vector<float>& u,
+    const glm::vec2& tangentStart, const glm::vec2& tangentEnd)
+{
+    glm::vec2 first = points[0];
+    glm::vec2 last = points[count - 1];
+
+    float c00 = 0.0f, c01 = 0.0f, c11 = 0.0f, x0 = 0.0f, x1 = 0.0f;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        float t = u[i], s = 1.0f - t;
+        float b0 = s * s * s, b1 = 3.0f * s * s * t, b2 = 3.0f * s * t * t, b3 = t * t * t;
+        glm::vec2 a0 = tangentStart * b1;
+        glm::vec2 a1 = tangentEnd * b2;
+
+        c00 += glm::dot(a0, a0);
+        c01 += glm::dot(a0, a1);
+        c11 += glm::dot(a1, a1);
+
+        glm::vec2 residual = points[i] - (first * (b0 + b1) + last * (b2 + b3));
+        x0 += glm::dot(a0, residual);
+        x1 += glm::dot(a1, residual);
+    }
+
+    float determinant = c00 * c11 - c01 * c01;
+    float alphaStart = 0.0f, alphaEnd = 0.0f;
+    if (std::abs(determinant) > 1e-12f)
+    {
+        alphaStart = (x0 * c11 - x1 * c01) / determinant;
+        alphaEnd = (c00 * x1 - c01 * x0) / determinant;
+    }
+
+    // Degenerate or backwards handles fall back to the Wu / Barsky heuristic
+    float chord = glm::length(last - first);
+    float epsilon = 1e-6f * chord;
+    if (alphaStart < epsilon || alphaEnd < epsilon)
+        alphaStart = alphaEnd = chord / 3.0f;
+
+    return CubicBezier2D({ first, first + tangentStart * alphaStart, last + tangentEnd * alphaEnd, last });
+}
+
+// Squared error of the worst sample and its index
+static float ComputeMaxError(const glm::vec2* points, unsigned int count, const CubicBezier2D& bezier,
+    const std::vector<float>& u, unsigned int& splitIndex)
+{
+    float maxDistanceSq = 0.0f;
+    splitIndex = count / 2;
+    for (unsigned int i = 1; i + 1 < count; i++)
+    {
+        glm::vec2 difference = bezier.Evaluate(u[i]) - points[i];
+        float distanceSq = glm::dot(difference, difference);
+        if (distanceSq >= maxDistanceSq)
+        {
+            maxDistanceSq = distanceSq;
+            splitIndex = i;
+        }
+    }
+    return maxDistanceSq;
+}
+
+// One Newton step per sample on (B(u) - P) . B'(u) = 0
+static void Reparameterize(const glm::vec2* points, unsigned int count, const CubicBezier2D& bezier, std::vector<float>& u)
+{
+    for (unsigned int i = 0; i < count; i++)
+    {
+        glm::vec2 difference = bezier.Evaluate(u[i]) - points[i];
+        glm::vec2 first = bezier.Derivative(u[i]);
+        glm::vec2 second = bezier.SecondDerivative(u[i]);
+
+        float numerator = glm::dot(difference, first);
+        float denominator = glm::dot(first, first) + glm::dot(difference, second);
+        if (std::abs(denominator) > 1e-12f)
+            u[i] = glm::clamp(u[i] - numerator / denominator, 0.0f, 1.0f);
+    }
+}
+
+static void FitCubic(const glm::vec2* points, unsigned int count, const glm::vec2& tangentStart, const glm::vec2& tangentEnd,
+    float toleranceSq, std::vector<CubicBezier2D>& segments, std::vector<float>& u)
+{
+    glm::vec2 first = points[0];
+    glm::vec2 last = points[count - 1];
+
+    // Two samples, handles at a third of the chord
+    if (count == 2)
+    {
+        float third = glm::length(last - first) / 3.0f;
+        segments.push_back(CubicBezier2D({ first, first + tangentStart * third, last + tangentEnd * third, last }));
+        return;
+    }
+
+    ChordLengthParameterize(points, count, u);
+    CubicBezier2D bezier = GenerateBezier(points, count, u, tangentStart, tangentEnd);
+
+    unsigned int splitIndex;
+    float errorSq = ComputeMaxError(points, count, bezier, u, splitIndex);
+    if (errorSq <= toleranceSq)
+    {
+        segments.push_back(bezier);
+        return;
+    }
+
+    // Close enough to be worth moving the parameters instead of splitting
+    if (errorSq <= toleranceSq * s_ReparameterizeFactor * s_ReparameterizeFactor)
+    {
+        for (int iteration = 0; iteration < s_MaxNewtonIterations; iteration++)
+        {
+            Reparameterize(points, count, bezier, u);
+            bezier = GenerateBezier(points, count, u, tangentStart, tangentEnd);
+            errorSq = ComputeMaxError(points, count, bezier, u, splitIndex);
+            if (errorSq <= toleranceSq)
+            {
+                segments.push_back(bezier);
+                return;
+            }
+        }
+    }
+
+    // Split at the worst sample, both halves share its tangent
+    splitIndex = glm::clamp(splitIndex, 1u, count - 2);
+    glm::vec2 center = SafeNormalize(points[splitIndex - 1] - points[splitIndex + 1]);
+    if (center == glm::vec2(0.0f))
+        center = SafeNormalize(glm::vec2(-(points[splitIndex] - points[splitIndex - 1]).y, (points[splitIndex] - points[splitIndex - 1]).x));
+
+    FitCubic(points, splitIndex + 1, tangentStart, center, toleranceSq, segments, u);
+    FitCubic(points + splitIndex, count - splitIndex, -center, tangentEnd, toleranceSq, segments, u);
+}
+
+std::vector<CubicBezier2D> FitCubicBeziers(const std::vector<glm::vec2>& points, float tolerance, float cornerAngle)
+{
+    std::vector<CubicBezier2D> segments;
+
+    // Repeated samples have no tangent
+    std::vector<glm::vec2> samples;
+    samples.reserve(points.size());
+    for (const glm::vec2& point : points)
+    {
+        if (samples.empty() || point != samples.back())
+            samples.push_back(point);
+    }
+    if (samples.size() < 2)
+        return segments;
+
+    // Corners where the direction turns more than cornerAngle, the pieces between them are fitted separately
+    float cornerCosine = std::cos(glm::radians(cornerAngle));
+    std::vector<unsigned int> breaks;
+    breaks.push_back(0);
+    for (unsigned int i = 1; i + 1 < samples.size(); i++)
+    {
+        glm::vec2 in = SafeNormalize(samples[i] - samples[i - 1]);
+        glm::vec2 out = SafeNormalize(samples[i + 1] - samples[i]);
+        if (glm::dot(in, out) < cornerCosine)
+            breaks.push_back(i);
+    }
+    breaks.push_back(samples.size() - 1);
+
+    std::vector<float> u;
+    float toleranceSq = tolerance * tolerance;
+    for (unsigned int b = 0; b + 1 < breaks.size(); b++)
+    {
+        const glm::vec2* piece = &samples[breaks[b]];
+        unsigned int count = breaks[b + 1] - breaks[b] + 1;
+
+        glm::vec2 tangentStart = SafeNormalize(piece[1] - piece[0]);
+        glm::vec2 tangentEnd = SafeNormalize(piece[count - 2] - piece[count - 1]);
+        FitCubic(piece, count, tangentStart, tangentEnd, toleranceSq, segments, u);
+    }
+    return segments;
+}
+
+float GetFittingError(const std::vector<glm::vec2>& points, const std::vector<CubicBezier2D>& segments)
+{
+    // Dense flattening of the chain, then point to polyline distance
+    const unsigned int samplesPerSegment = 64;
+    std::vector<glm::vec2> polyline;
+    for (const CubicBezier2D& segment : segments)
+    {
+        for (unsigned int s = polyline.empty() ? 0 : 1; s <= samplesPerSegment; s++)
+            polyline.push_back(segment.Evaluate(static_cast<float>(s) / samplesPerSegment));
+    }
+
+    // Nothing to measure against
+    if (polyline.empty())
+        return 0.0f;
+
+    float maxError = 0.0f;
+    unsigned int hint = 0;
+    for (const glm::vec2& point : points)
+    {
+        // Samples advance along the chain, search a window around the last match
+        float best = std::numeric_limits<float>::max();
+        unsigned int begin = hint > 2 * samplesPerSegment ? hint - 2 * samplesPerSegment : 0;
+        unsigned int end = std::min<unsigned int>(hint + 4 * samplesPerSegment, polyline.size() - 1);
+        for (unsigned int i = begin; i < end; i++)
+        {
+            glm::vec2 edge = polyline[i + 1] - polyline[i];
+            float lengthSq = glm::dot(edge, edge);
+            float t = lengthSq > 0.0f ? glm::clamp(glm::dot(point - polyline[i], edge) / lengthSq, 0.0f, 1.0f) : 0.0f;
+            float distance = glm::length(point - (polyline[i] + t * edge));
+            if (distance < best)
+            {
+                best = distance;
+                hint = i;
+            }
+        }
+        maxError = std::max(maxError, best);
+    }
+    return maxError;
+}
+
@@ -0,0 +1,671 @@
+#include "CurveQueries.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Subdivision depth limits, 2^-24 of the parameter range is far below float precision of the points
+static const unsigned int s_MaxClosestPointDepth = 24;
+static const unsigned int s_MaxIntersectionDepth = 48;
+static const int s_NewtonIterations = 8;
+
+static void GetHullBounds(const glm::vec2* points, unsigned int count, glm::vec2& boundsMin, glm::vec2& boundsMax)
+{
+    boundsMin = boundsMax = points[0];
+    for (unsigned int i = 1; i < count; i++)
+    {
+        boundsMin = glm::min(boundsMin, points[i]);
+        boundsMax = glm::max(boundsMax, points[i]);
+    }
+}
+
+static float DistanceToBox(const glm::vec2& point, const glm::vec2& boundsMin, const glm::vec2& boundsMax)
+{
+    glm::vec2 outside = glm::max(glm::max(boundsMin - point, point - boundsMax), glm::vec2(0.0f));
+    return glm::length(outside);
+}
+
+// Control points of the derivative curve, count - 1 of them
+template<typename Point>
+static void GetHodograph(const Point* points, unsigned int count, Point* hodograph)
+{
+    float degree = static_cast<float>(count - 1);
+    for (unsigned int i = 0; i + 1 < count; i++)
+        hodograph[i] = degree * (points[i + 1] - points[i]);
+}
+
+// Scratch for curves with more points than fit on the stack
+template<typename Point>
+static Point* GetScratch(Point* stackBuffer, std::vector<Point>& heapBuffer, unsigned int size, unsigned int stackSize)
+{
+    if (size <= stackSize)
+        return stackBuffer;
+    heapBuffer.resize(size);
+    return heapBuffer.data();
+}
+
+CurveHit FindClosestPoint(const glm::vec2* points, unsigned int count, const glm::vec2& query, float tolerance)
+{
+    CurveHit best;
+    best.T = 0.0f;
+    best.Point = points[0];
+    best.Distance = glm::length(points[0] - query);
+    if (count < 2)
+        return best;
+
+    float endDistance = glm::length(points[count - 1] - query);
+    if (endDistance < best.Distance)
+    {
+        best.T = 1.0f;
+        best.Point = points[count - 1];
+        best.Distance = endDistance;
+    }
+
+    // Depth first on an explicit stack of control polygons, nearer halves first so the bound tightens fast
+    const unsigned int slotCount = s_MaxClosestPointDepth + 2;
+    glm::vec2 stackBuffer[(slotCount + 1) * 4];
+    std::vector<glm::vec2> heapBuffer;
+    glm::vec2* slots = GetScratch(stackBuffer, heapBuffer, (slotCount + 1) * count, (slotCount + 1) * 4);
+    glm::vec2* left = slots + slotCount * count;
+
+    struct Piece { float T0; float T1; unsigned int Depth; };
+    Piece pieces[slotCount];
+    unsigned int top = 0;
+    std::copy(points, points + count, slots);
+    pieces[0] = { 0.0f, 1.0f, 0 };
+
+    while (true)
+    {
+        glm::vec2* piece = slots + top * count;
+        Piece current = pieces[top];
+
+        glm::vec2 boundsMin, boundsMax;
+        GetHullBounds(piece, count, boundsMin, boundsMax);
+
+        bool prune = DistanceToBox(query, boundsMin, boundsMax) >= best.Distance;
+        if (!prune)
+        {
+            // The middle of every visited piece is a candidate, it keeps the upper bound tight
+            float middle = 0.5f * (current.T0 + current.T1);
+            glm::vec2 point = EvaluateBezier(piece, count, 0.5f);
+            float distance = glm::length(point - query);
+            if (distance < best.Distance)
+            {
+                best.T = middle;
+                best.Point = point;
+                best.Distance = distance;
+            }
+
+            glm::vec2 extent = boundsMax - boundsMin;
+            prune = current.Depth >= s_MaxClosestPointDepth || std::max(extent.x, extent.y) < tolerance;
+        }
+
+        if (prune)
+        {
+            if (top == 0)
+                break;
+            top--;
+            continue;
+        }
+
+        // Right half goes to the next slot, then the nearer half is moved on top
+        glm::vec2* next = piece + count;
+        SplitBezier(piece, count, 0.5f, left, next);
+        float middle = 0.5f * (current.T0 + current.T1);
+        Piece leftPiece = { current.T0, middle, current.Depth + 1 };
+        Piece rightPiece = { middle, current.T1, current.Depth + 1 };
+
+        glm::vec2 leftMin, leftMax, rightMin, rightMax;
+        GetHullBounds(left, count, leftMin, leftMax);
+        GetHullBounds(next, count, rightMin, rightMax);
+        if (DistanceToBox(query, leftMin, leftMax) <= DistanceToBox(query, rightMin, rightMax))
+        {
+            std::copy(next, next + count, piece);
+            std::copy(left, left + count, next);
+            pieces[top] = rightPiece;
+            pieces[top + 1] = leftPiece;
+        }
+        else
+        {
+            std::copy(left, left + count, piece);
+            pieces[top] = leftPiece;
+            pieces[top + 1] = rightPiece;
+        }
+        top++;
+    }
+
+    // Newton on (B(t) - q) . B'(t) = 0 from the best sample
+    glm::vec2 firstStack[s_MaxStackControlPoints];
+    glm::vec2 secondStack[s_MaxStackControlPoints];
+    std::vector<glm::vec2> firstHeap, secondHeap;
+    glm::vec2* first = GetScratch(firstStack, firstHeap, count, s_MaxStackControlPoints);
+    glm::vec2* second = GetScratch(secondStack, secondHeap, count, s_MaxStackControlPoints);
+    GetHodograph(points, count, first);
+    GetHodograph(first, count - 1, second);
+
+    float t = best.T;
+    for (int iteration = 0; iteration < s_NewtonIterations; iteration++)
+    {
+        glm::vec2 difference = EvaluateBezier(points, count, t) - query;
+        glm::vec2 velocity = EvaluateBezier(first, count - 1, t);
+        glm::vec2 acceleration = count > 2 ? EvaluateBezier(second, count - 2, t) : glm::vec2(0.0f);
+
+        float denominator = glm::dot(velocity, velocity) + glm::dot(difference, acceleration);
+        if (std::abs(denominator) < 1e-12f)
+            break;
+        float step = glm::dot(difference, velocity) / denominator;
+        t = glm::clamp(t - step, 0.0f, 1.0f);
+        if (std::abs(step) < 1e-7f)
+            break;
+    }
+
+    glm::vec2 polished = EvaluateBezier(points, count, t);
+    float polishedDistance = glm::length(polished - query);
+    if (polishedDistance < best.Distance)
+    {
+        best.T = t;
+        best.Point = polished;
+        best.Distance = polishedDistance;
+    }
+    return best;
+}
+
+static void IntersectRecursive(const glm::vec2* first, float first0, float first1, const glm::vec2* second, float second0, float second1,
+    unsigned int firstCount, unsigned int secondCount, unsigned int depth, float threshold, std::vector<CurveIntersection>& candidates)
+{
+    glm::vec2 firstMin, firstMax, secondMin, secondMax;
+    GetHullBounds(first, firstCount, firstMin, firstMax);
+    GetHullBounds(second, secondCount, secondMin, secondMax);
+
+    // Disjoint hull boxes can't intersect
+    if (firstMax.x < secondMin.x || secondMax.x < firstMin.x || firstMax.y < secondMin.y || secondMax.y < firstMin.y)
+        return;
+
+    glm::vec2 firstExtent = firstMax - firstMin;
+    glm::vec2 secondExtent = secondMax - secondMin;
+    float firstSize = std::max(firstExtent.x, firstExtent.y);
+    float secondSize = std::max(secondExtent.x, secondExtent.y);
+
+    if ((firstSize < threshold && secondSize < threshold) || depth >= s_MaxIntersectionDepth)
+    {
+        CurveIntersection candidate;
+        candidate.T0 = 0.5f * (first0 + first1);
+        candidate.T1 = 0.5f * (second0 + second1);
+        candidates.push_back(candidate);
+        return;
+    }
+
+    // Split the larger of the two
+    glm::vec2 left[s_MaxStackControlPoints];
+    glm::vec2 right[s_MaxStackControlPoints];
+    if (firstSize >= secondSize)
+    {
+        float middle = 0.5f * (first0 + first1);
+        SplitBezier(first, firstCount, 0.5f, left, right);
+        IntersectRecursive(left, first0, middle, second, second0, second1, firstCount, secondCount, depth + 1, threshold, candidates);
+        IntersectRecursive(right, middle, first1, second, second0, second1, firstCount, secondCount, depth + 1, threshold, candidates);
+    }
+    else
+    {
+        float middle = 0.5f * (second0 + second1);
+        SplitBezier(second, secondCount, 0.5f, left, right);
+        IntersectRecursive(first, first0, first1, left, second0, middle, firstCount, secondCount, depth + 1, threshold, candidates);
+        IntersectRecursive(first, first0, first1, right, middle, second1, firstCount, secondCount, depth + 1, threshold, candidates);
+    }
+}
+
+void IntersectCurves(const glm::vec2* first, unsigned int firstCount, const glm::vec2* second, unsigned int secondCount,
+    std::vector<CurveIntersection>& intersections, float tolerance)
+{
+    if (firstCount < 2 || secondCount < 2 || firstCount > s_MaxStackControlPoints || secondCount > s_MaxStackControlPoints)
+        return;
+
+    // Subdivide down to a fraction of the curve size, Newton does the rest
+    glm::vec2 firstMin, firstMax, secondMin, secondMax;
+    GetHullBounds(first, firstCount, firstMin, firstMax);
+    GetHullBounds(second, secondCount, secondMin, secondMax);
+    float size = std::max(glm::length(firstMax - firstMin), glm::length(secondMax - secondMin));
+    float threshold = std::max(tolerance, 1e-3f * size);
+
+    std::vector<CurveIntersection> candidates;
+    IntersectRecursive(first, 0.0f, 1.0f, second, 0.0f, 1.0f, firstCount, secondCount, 0, threshold, candidates);
+
+    glm::vec2 firstHodograph[s_MaxStackControlPoints];
+    glm::vec2 secondHodograph[s_MaxStackControlPoints];
+    GetHodograph(first, firstCount, firstHodograph);
+    GetHodograph(second, secondCount, secondHodograph);
+
+    for (CurveIntersection& candidate : candidates)
+    {
+        // Newton on A(s) - B(t) = 0
+        float s = candidate.T0, t = candidate.T1;
+        for (int iteration = 0; iteration < s_NewtonIterations; iteration++)
+        {
+            glm::vec2 difference = EvaluateBezier(first, firstCount, s) - EvaluateBezier(second, secondCount, t);
+            glm::vec2 ds = EvaluateBezier(firstHodograph, firstCount - 1, s);
+            glm::vec2 dt = -EvaluateBezier(secondHodograph, secondCount - 1, t);
+
+            float determinant = ds.x * dt.y - ds.y * dt.x;
+            if (std::abs(determinant) < 1e-12f)
+                break;
+            float stepS = (difference.x * dt.y - difference.y * dt.x) / determinant;
+            float stepT = (ds.x * difference.y - ds.y * difference.x) / determinant;
+            s = glm::clamp(s - stepS, 0.0f, 1.0f);
+            t = glm::clamp(t - stepT, 0.0f, 1.0f);
+            if (std::abs(stepS) < 1e-7f && std::abs(stepT) < 1e-7f)
+                break;
+        }
+
+        // Keep whichever of the sample and the polished pair is closer
+        glm::vec2 a = EvaluateBezier(first, firstCount, s);
+        glm::vec2 b = EvaluateBezier(second, secondCount, t);
+        glm::vec2 sampleA = EvaluateBezier(first, firstCount, candidate.T0);
+        glm::vec2 sampleB = EvaluateBezier(second, secondCount, candidate.T1);
+        if (glm::length(a - b) <= glm::length(sampleA - sampleB))
+        {
+            candidate.T0 = s;
+            candidate.T1 = t;
+            candidate.Point = 0.5f * (a + b);
+        }
+        else
+            candidate.Point = 0.5f * (sampleA + sampleB);
+
+        // Neighbouring pieces find the same crossing
+        bool duplicate = false;
+        for (const CurveIntersection& existing : intersections)
+        {
+            if (glm::length(existing.Point - candidate.Point) < threshold)
+            {
+                duplicate = true;
+                break;
+            }
+        }
+        if (!duplicate)
+            intersections.push_back(candidate);
+    }
+}
+
+static void LineRootsRecursive(const float* distances, unsigned int count, float t0, float t1, unsigned int depth, std::vector<float>& roots)
+{
+    // The curve stays on one side while all its control points do
+    float low = distances[0], high = distances[0];
+    for (unsigned int i = 1; i < count; i++)
+    {
+        low = std::min(low, distances[i]);
+        high = std::max(high, distances[i]);
+    }
+    if (low > 0.0f || high < 0.0f)
+        return;
+
+    // Zero all along, only the ends of the piece are distinct roots
+    if (low == 0.0f && high == 0.0f)
+    {
+        roots.push_back(t0);
+        roots.push_back(t1);
+        return;
+    }
+
+    if (t1 - t0 < 1e-3f || depth >= s_MaxIntersectionDepth)
+    {
+        roots.push_back(0.5f * (t0 + t1));
+        return;
+    }
+
+    float left[s_MaxStackControlPoints];
+    float right[s_MaxStackControlPoints];
+    SplitBezier(distances, count, 0.5f, left, right);
+    float middle = 0.5f * (t0 + t1);
+    LineRootsRecursive(left, count, t0, middle, depth + 1, roots);
+    LineRootsRecursive(right, count, middle, t1, depth + 1, roots);
+}
+
+// Roots of the 1D Bezier values in [0, 1], appended to roots and polished with Newton steps
+static void FindRoots(const float* values, unsigned int count, std::vector<float>& roots)
+{
+    float derivative[s_MaxStackControlPoints];
+    GetHodograph(values, count, derivative);
+
+    unsigned int first = roots.size();
+    LineRootsRecursive(values, count, 0.0f, 1.0f, 0, roots);
+    for (unsigned int i = first; i < roots.size(); i++)
+    {
+        float& t = roots[i];
+        for (int iteration = 0; iteration < s_NewtonIterations; iteration++)
+        {
+            float slope = EvaluateBezier(derivative, count - 1, t);
+            if (std::abs(slope) < 1e-12f)
+                break;
+            float step = EvaluateBezier(values, count, t) / slope;
+            t = glm::clamp(t - step, 0.0f, 1.0f);
+            if (std::abs(step) < 1e-7f)
+                break;
+        }
+    }
+}
+
+void IntersectLine(const glm::vec2* points, unsigned int count, const glm::vec2& lineStart, const glm::vec2& lineEnd,
+    std::vector<CurveHit>& hits, float tolerance)
+{
+    glm::vec2 direction = lineEnd - lineStart;
+    float lengthSq = glm::dot(direction, direction);
+    if (count < 2 || count > s_MaxStackControlPoints || lengthSq <= 0.0f)
+        return;
+
+    // Signed distances to the line are a 1D Bezier with the same parameter
+    glm::vec2 normal = glm::vec2(-direction.y, direction.x) / std::sqrt(lengthSq);
+    float distances[s_MaxStackControlPoints];
+    float flatness = tolerance * std::sqrt(lengthSq);
+    bool collinear = true;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        distances[i] = glm::dot(points[i] - lineStart, normal);
+        collinear = collinear && std::abs(distances[i]) <= flatness;
+    }
+
+    std::vector<float> roots;
+    if (collinear)
+    {
+        // The curve lies on the line, the overlap with the segment is reported by its end points:
+        // the curve's own ends inside the segment and where it passes the segment's ends
+        float along[s_MaxStackControlPoints];
+        float beyond[s_MaxStackControlPoints];
+        for (unsigned int i = 0; i < count; i++)
+        {
+            along[i] = glm::dot(points[i] - lineStart, direction) / lengthSq;
+            beyond[i] = along[i] - 1.0f;
+        }
+        roots.push_back(0.0f);
+        roots.push_back(1.0f);
+        FindRoots(along, count, roots);
+        FindRoots(beyond, count, roots);
+        std::sort(roots.begin(), roots.end());
+    }
+    else
+    {
+        FindRoots(distances, count, roots);
+    }
+
+    // Only hits added here are deduplicated, the caller's earlier hits stay as they are
+    unsigned int firstNew = hits.size();
+    for (float t : roots)
+    {
+        // Only crossings inside the segment
+        glm::vec2 point = EvaluateBezier(points, count, t);
+        float along = glm::dot(point - lineStart, direction) / lengthSq;
+        if (along < -tolerance || along > 1.0f + tolerance)
+            continue;
+
+        bool duplicate = false;
+        for (unsigned int i = firstNew; i < hits.size(); i++)
+        {
+            if (std::abs(hits[i].T - t) < 1e-4f)
+                duplicate = true;
+        }
+        if (duplicate)
+            continue;
+
+        CurveHit hit;
+        hit.T = t;
+        hit.Point = point;
+        hit.Distance = 0.0f;
+        hits.push_back(hit);
+    }
+}
+
+// Bezier pieces of a curve with the global parameter range they cover
+static unsigned int GetPieceCount(const BezierCurve& curve)
+{
+    return curve.GetMode() == CurveMode::Bezier ? (curve.GetControlPoints().size() >= 2 ? 1 : 0) : curve.GetSegmentCount();
+}
+
+static const glm::vec2* GetPiece(const BezierCurve& curve, unsigned int piece, glm::vec2* segment, unsigned int& count)
+{
+    if (curve.GetMode() == CurveMode::Bezier)
+    {
+        count = curve.GetControlPoints().size();
+        return curve.GetControlPoints().data();
+    }
+    count = 4;
+    curve.GetSegmentPoints(piece, segment);
+    return segment;
+}
+
+CurveHit FindClosestPoint(const BezierCurve& curve, const glm::vec2& query, float tolerance)
+{
+    CurveHit best;
+    best.Distance = std::numeric_limits<float>::max();
+
+    unsigned int pieceCount = GetPieceCount(curve);
+    for (unsigned int i = 0; i < pieceCount; i++)
+    {
+        glm::vec2 segment[4];
+        unsigned int count;
+        const glm::vec2* points = GetPiece(curve, i, segment, count);
+
+        glm::vec2 boundsMin, boundsMax;
+        GetHullBounds(points, count, boundsMin, boundsMax);
+        if (DistanceToBox(query, boundsMin, boundsMax) >= best.Distance)
+            continue;
+
+        CurveHit hit = FindClosestPoint(points, count, query, tolerance);
+        if (hit.Distance < best.Distance)
+        {
+            best = hit;
+            best.T = (static_cast<float>(i) + hit.T) / pieceCount;
+        }
+    }
+    return best;
+}
+
+std::vector<CurveIntersection> IntersectCurves(const BezierCurve& first, const BezierCurve& second, float tolerance)
+{
+    std::vector<CurveIntersection> intersections;
+    unsigned int firstPieces = GetPieceCount(first);
+    unsigned int secondPieces = GetPieceCount(second);
+
+    for (unsigned int i = 0; i < firstPieces; i++)
+    {
+        glm::vec2 firstSegment[4];
+        unsigned int firstCount;
+        const glm::vec2* firstPoints = GetPiece(first, i, firstSegment, firstCount);
+
+        for (unsigned int j = 0; j < secondPieces; j++)
+        {
+            glm::vec2 secondSegment[4];
+            unsigned int secondCount;
+            const glm::vec2* secondPoints = GetPiece(second, j, secondSegment, secondCount);
+
+            std::vector<CurveIntersection> pieceIntersections;
+            IntersectCurves(firstPoints, firstCount, secondPoints, secondCount, pieceIntersections, tolerance);
+            for (CurveIntersection intersection : pieceIntersections)
+            {
+                // Segment ends are shared, the same crossing can show up twice
+                bool duplicate = false;
+                for (const CurveIntersection& existing : intersections)
+                {
+                    if (glm::length(existing.Point - intersection.Point) < 1e-4f)
+                        duplicate = true;
+                }
+                if (duplicate)
+                    continue;
+
+                intersection.T0 = (static_cast<float>(i) + intersection.T0) / firstPieces;
+                intersection.T1 = (static_cast<float>(j) + intersection.T1) / secondPieces;
+                intersections.push_back(intersection);
+            }
+        }
+    }
+    return intersections;
+}
+
+std::vector<CurveHit> IntersectLine(const BezierCurve& curve, const glm::vec2& lineStart, const glm::vec2& lineEnd)
+{
+    std::vector<CurveHit> hits;
+    unsigned int pieceCount = GetPieceCount(curve);
+    for (unsigned int i = 0; i < pieceCount; i++)
+    {
+        glm::vec2 segment[4];
+        unsigned int count;
+        const glm::vec2* points = GetPiece(curve, i, segment, count);
+
+        std::vector<CurveHit> pieceHits;
+        IntersectLine(points, count, lineStart, lineEnd, pieceHits);
+        for (CurveHit hit : pieceHits)
+        {
+            bool duplicate = false;
+            for (const CurveHit& existing : hits)
+            {
+                if (glm::length(existing.Point - hit.Point) < 1e-4f)
+                    duplicate = true;
+            }
+            if (duplicate)
+                continue;
+
+            hit.T = (static_cast<float>(i) + hit.T) / pieceCount;
+            hits.push_back(hit);
+        }
+    }
+    return hits;
+}
+
+CurveBVH::CurveBVH()
+{
+}
+
+CurveBVH::~CurveBVH()
+{
+}
+
+void CurveBVH::Clear()
+{
+    m_Curves.clear();
+    m_CurveMin.clear();
+    m_CurveMax.clear();
+    m_Order.clear();
+    m_Nodes.clear();
+}
+
+unsigned int CurveBVH::Add(const CubicBezier2D& curve)
+{
+    glm::vec2 boundsMin, boundsMax;
+    GetHullBounds(curve.GetControlPoints(), 4, boundsMin, boundsMax);
+
+    m_Curves.push_back(curve);
+    m_CurveMin.push_back(boundsMin);
+    m_CurveMax.push_back(boundsMax);
+    return m_Curves.size() - 1;
+}
+
+void CurveBVH::AddCurve(const BezierCurve& curve)
+{
+    unsigned int pieceCount = GetPieceCount(curve);
+    for (unsigned int i = 0; i < pieceCount; i++)
+    {
+        glm::vec2 segment[4];
+        unsigned int count;
+        const glm::vec2* points = GetPiece(curve, i, segment, count);
+        if (count == 4)
+            Add(CubicBezier2D({ points[0], points[1], points[2], points[3] }));
+    }
+}
+
+void CurveBVH::Build()
+{
+    m_Nodes.clear();
+    m_Order.resize(m_Curves.size());
+    for (unsigned int i = 0; i < m_Order.size(); i++)
+        m_Order[i] = i;
+
+    if (m_Curves.empty())
+        return;
+
+    m_Nodes.reserve(2 * m_Curves.size());
+    m_Nodes.push_back(Node());
+    BuildNode(0, 0, m_Curves.size());
+}
+
+void CurveBVH::BuildNode(unsigned int nodeIndex, unsigned int first, unsigned int count)
+{
+    const unsigned int leafSize = 4;
+
+    glm::vec2 boundsMin = m_CurveMin[m_Order[first]];
+    glm::vec2 boundsMax = m_CurveMax[m_Order[first]];
+    for (unsigned int i = first + 1; i < first + count; i++)
+    {
+        boundsMin = glm::min(boundsMin, m_CurveMin[m_Order[i]]);
+        boundsMax = glm::max(boundsMax, m_CurveMax[m_Order[i]]);
+    }
+    m_Nodes[nodeIndex].Min = boundsMin;
+    m_Nodes[nodeIndex].Max = boundsMax;
+
+    if (count <= leafSize)
+    {
+        m_Nodes[nodeIndex].First = first;
+        m_Nodes[nodeIndex].Count = count;
+        return;
+    }
+
+    // Median of the box centers along the longest axis
+    int axis = (boundsMax.x - boundsMin.x) >= (boundsMax.y - boundsMin.y) ? 0 : 1;
+    unsigned int half = count / 2;
+    std::nth_element(m_Order.begin() + first, m_Order.begin() + first + half, m_Order.begin() + first + count,
+        [this, axis](unsigned int a, unsigned int b) { return m_CurveMin[a][axis] + m_CurveMax[a][axis] < m_CurveMin[b][axis] + m_CurveMax[b][axis]; });
+
+    unsigned int left = m_Nodes.size();
+    m_Nodes.push_back(Node());
+    m_Nodes.push_back(Node());
+    m_Nodes[nodeIndex].First = left;
+    m_Nodes[nodeIndex].Count = 0;
+
+    BuildNode(left, first, half);
+    BuildNode(left + 1, first + half, count - half);
+}
+
+bool CurveBVH::FindClosest(const glm::vec2& query, float maxDistance, CurveBVHHit& hit) const
+{
+    if (m_Nodes.empty())
+        return false;
+
+    float bestDistance = maxDistance;
+    bool found = false;
+
+    unsigned int stack[64];
+    unsigned int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const Node& node = m_Nodes[stack[--stackSize]];
+        if (DistanceToBox(query, node.Min, node.Max) > bestDistance)
+            continue;
+
+        if (node.Count > 0)
+        {
+            for (unsigned int i = node.First; i < node.First + node.Count; i++)
+            {
+                unsigned int curve = m_Order[i];
+                if (DistanceToBox(query, m_CurveMin[curve], m_CurveMax[curve]) > bestDistance)
+                    continue;
+
+                CurveHit curveHit = FindClosestPoint(m_Curves[curve].GetControlPoints(), 4, query);
+                if (curveHit.Distance <= bestDistance)
+                {
+                    bestDistance = curveHit.Distance;
+                    hit.Curve = curve;
+                    hit.Hit = curveHit;
+                    found = true;
+                }
+            }
+            continue;
+        }
+
+        // Nearer child on top of the stack
+        const Node& left = m_Nodes[node.First];
+        const Node& right = m_Nodes[node.First + 1];
+        bool leftFirst = DistanceToBox(query, left.Min, left.Max) <= DistanceToBox(query, right.Min, right.Max);
+        stack[stackSize++] = leftFirst ? node.First + 1 : node.First;
+        stack[stackSize++] = leftFirst ? node.First : node.First + 1;
+    }
+    return found;
+}
+
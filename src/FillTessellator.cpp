@@ -0,0 +1,610 @@
+#include "FillTessellator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <glm/gtc/constants.hpp>
+
+// Chain of a monotone polygon a vertex belongs to
+static const int s_NoSide = -1;
+static const int s_LeftSide = 0;
+static const int s_RightSide = 1;
+
+// Intersections closer than this to an edge end (in edge parameter) snap to the end point
+static const float s_SplitEpsilon = 1e-5f;
+static const unsigned int s_MaxSplitPasses = 8;
+
+// Intersections closer than this (relative to the size of the outline) are merged
+static const float s_SnapEpsilon = 1e-5f;
+
+static float Cross(const glm::vec2& a, const glm::vec2& b)
+{
+    return a.x * b.y - a.y * b.x;
+}
+
+FillTessellator::FillTessellator()
+{
+}
+
+FillTessellator::~FillTessellator()
+{
+}
+
+void FillTessellator::Clear()
+{
+    m_ContourPoints.clear();
+    m_ContourStarts.clear();
+    m_Vertices.clear();
+    m_Indices.clear();
+}
+
+void FillTessellator::BeginContour()
+{
+    m_ContourStarts.push_back(m_ContourPoints.size());
+}
+
+void FillTessellator::AddPoint(const glm::vec2& point)
+{
+    if (m_ContourStarts.empty())
+        BeginContour();
+
+    // Joined curves repeat their end points
+    if (m_ContourPoints.size() > m_ContourStarts.back() && m_ContourPoints.back() == point)
+        return;
+    m_ContourPoints.push_back(point);
+}
+
+void FillTessellator::AddCurve(const BezierCurve& curve, float tolerance)
+{
+    const std::vector<glm::vec2>& controlPoints = curve.GetControlPoints();
+    if (curve.GetMode() == CurveMode::Bezier)
+    {
+        if (controlPoints.empty())
+            return;
+
+        unsigned int count = controlPoints.size();
+        unsigned int segments = EstimateSegmentCount(controlPoints.data(), count, tolerance);
+        AddPoint(controlPoints[0]);
+        for (unsigned int i = 1; i <= segments; i++)
+            AddPoint(EvaluateBezier(controlPoints.data(), count, static_cast<float>(i) / segments));
+        return;
+    }
+
+    for (unsigned int s = 0; s < curve.GetSegmentCount(); s++)
+    {
+        glm::vec2 points[4];
+        curve.GetSegmentPoints(s, points);
+        AddCubic(CubicBezier2D(points), tolerance);
+    }
+}
+
+void FillTessellator::AddCubic(const CubicBezier2D& curve, float tolerance)
+{
+    unsigned int segments = EstimateSegmentCount(curve.GetControlPoints(), 4, tolerance);
+    AddPoint(curve.GetControlPoint(0));
+    for (unsigned int i = 1; i <= segments; i++)
+        AddPoint(curve.Evaluate(static_cast<float>(i) / segments));
+}
+
+void FillTessellator::AddContour(const float* points, unsigned int pointCount)
+{
+    BeginContour();
+    for (unsigned int i = 0; i < pointCount; i++)
+        AddPoint(glm::vec2(points[i * 2], points[i * 2 + 1]));
+}
+
+void FillTessellator::Tessellate(FillRule rule)
+{
+    m_Vertices.clear();
+    m_Indices.clear();
+    if (m_ContourPoints.size() < 3)
+        return;
+
+    m_Points = m_ContourPoints;
+    SortVertices();
+    BuildEdges();
+    // Pieces of split edges can still cross where several edges meet at one point
+    for (unsigned int pass = 0; pass < s_MaxSplitPasses && SplitIntersections(); pass++)
+    {
+    }
+    Sweep(rule);
+
+    m_Vertices.resize(m_SweepPoints.size() * 2);
+    for (unsigned int i = 0; i < m_SweepPoints.size(); i++)
+    {
+        m_Vertices[i * 2] = m_SweepPoints[i].x;
+        m_Vertices[i * 2 + 1] = m_SweepPoints[i].y;
+    }
+}
+
+void FillTessellator::SortVertices()
+{
+    unsigned int count = m_Points.size();
+    m_Order.resize(count);
+    std::iota(m_Order.begin(), m_Order.end(), 0u);
+    std::sort(m_Order.begin(), m_Order.end(), [&](unsigned int a, unsigned int b)
+    {
+        const glm::vec2& pa = m_Points[a];
+        const glm::vec2& pb = m_Points[b];
+        return pa.y < pb.y || (pa.y == pb.y && pa.x < pb.x);
+    });
+
+    // Equal points become one vertex, contours touching there share it
+    m_VertexIds.resize(count);
+    m_SweepPoints.clear();
+    for (unsigned int i = 0; i < count; i++)
+    {
+        const glm::vec2& point = m_Points[m_Order[i]];
+        if (m_SweepPoints.empty() || point != m_SweepPoints.back())
+            m_SweepPoints.push_back(point);
+        m_VertexIds[m_Order[i]] = m_SweepPoints.size() - 1;
+    }
+}
+
+void FillTessellator::AddEdge(std::vector<Edge>& edges, unsigned int from, unsigned int to, int direction) const
+{
+    unsigned int a = m_VertexIds[from];
+    unsigned int b = m_VertexIds[to];
+    if (a == b)
+        return;
+
+    Edge edge;
+    edge.Top = std::min(a, b);
+    edge.Bottom = std::max(a, b);
+    edge.Winding = a < b ? direction : -direction;
+    edges.push_back(edge);
+}
+
+void FillTessellator::BuildEdges()
+{
+    m_Edges.clear();
+    for (unsigned int c = 0; c < m_ContourStarts.size(); c++)
+    {
+        unsigned int begin = m_ContourStarts[c];
+        unsigned int end = c + 1 < m_ContourStarts.size() ? m_ContourStarts[c + 1] : m_ContourPoints.size();
+        if (end - begin < 3)
+            continue;
+
+        for (unsigned int i = begin; i < end; i++)
+            AddEdge(m_Edges, i, i + 1 < end ? i + 1 : begin, 1);
+    }
+}
+
+bool FillTessellator::SplitIntersections()
+{
+    // Sweep over the edges by top vertex, the active ones overlap the current edge in y
+    std::sort(m_Edges.begin(), m_Edges.end(), [](const Edge& a, const Edge& b) { return a.Top < b.Top; });
+    m_Active.clear();
+    m_Splits.clear();
+    unsigned int vertexCount = m_SweepPoints.size();
+
+    for (unsigned int e = 0; e < m_Edges.size(); e++)
+    {
+        const Edge& edge = m_Edges[e];
+        glm::vec2 p0 = m_SweepPoints[edge.Top];
+        glm::vec2 p1 = m_SweepPoints[edge.Bottom];
+
+        unsigned int kept = 0;
+        for (unsigned int i = 0; i < m_Active.size(); i++)
+        {
+            if (m_SweepPoints[m_Edges[m_Active[i]].Bottom].y >= p0.y)
+                m_Active[kept++] = m_Active[i];
+        }
+        m_Active.resize(kept);
+
+        float minX = std::min(p0.x, p1.x);
+        float maxX = std::max(p0.x, p1.x);
+        glm::vec2 r = p1 - p0;
+
+        for (unsigned int i = 0; i < m_Active.size(); i++)
+        {
+            unsigned int o = m_Active[i];
+            const Edge& other = m_Edges[o];
+            bool sharesVertex = other.Top == edge.Top || other.Top == edge.Bottom || other.Bottom == edge.Top || other.Bottom == edge.Bottom;
+
+            glm::vec2 q0 = m_SweepPoints[other.Top];
+            glm::vec2 q1 = m_SweepPoints[other.Bottom];
+            if (std::max(q0.x, q1.x) < minX || std::min(q0.x, q1.x) > maxX)
+                continue;
+
+            glm::vec2 s = q1 - q0;
+            glm::vec2 offset = q0 - p0;
+            float denominator = Cross(r, s);
+            if (denominator == 0.0f)
+            {
+                // Overlapping collinear edges are split at each other's end points, the shared
+                // pieces then become duplicate edges. This holds for edges from one vertex too, the
+                // longer one still needs the far end of the shorter one, the shared end is at t 0 or 1
+                if (Cross(offset, r) != 0.0f)
+                    continue;
+
+                float edgeLength = glm::dot(r, r);
+                float otherLength = glm::dot(s, s);
+                float t0 = glm::dot(q0 - p0, r) / edgeLength;
+                float t1 = glm::dot(q1 - p0, r) / edgeLength;
+                float u0 = glm::dot(p0 - q0, s) / otherLength;
+                float u1 = glm::dot(p1 - q0, s) / otherLength;
+                if (t0 > s_SplitEpsilon && t0 < 1.0f - s_SplitEpsilon)
+                    m_Splits.push_back({ e, t0, other.Top });
+                if (t1 > s_SplitEpsilon && t1 < 1.0f - s_SplitEpsilon)
+                    m_Splits.push_back({ e, t1, other.Bottom });
+                if (u0 > s_SplitEpsilon && u0 < 1.0f - s_SplitEpsilon)
+                    m_Splits.push_back({ o, u0, edge.Top });
+                if (u1 > s_SplitEpsilon && u1 < 1.0f - s_SplitEpsilon)
+                    m_Splits.push_back({ o, u1, edge.Bottom });
+                continue;
+            }
+
+            // Edges that cross only meet at their shared vertex
+            if (sharesVertex)
+                continue;
+
+            float t = Cross(offset, s) / denominator;
+            float u = Cross(offset, r) / denominator;
+            if (t < -s_SplitEpsilon || t > 1.0f + s_SplitEpsilon || u < -s_SplitEpsilon || u > 1.0f + s_SplitEpsilon)
+                continue;
+
+            bool insideEdge = t > s_SplitEpsilon && t < 1.0f - s_SplitEpsilon;
+            bool insideOther = u > s_SplitEpsilon && u < 1.0f - s_SplitEpsilon;
+            if (insideEdge && insideOther)
+            {
+                // Both get the same new vertex
+                unsigned int vertex = m_SweepPoints.size();
+                m_SweepPoints.push_back(p0 + t * r);
+                m_Splits.push_back({ e, t, vertex });
+                m_Splits.push_back({ o, u, vertex });
+            }
+            else if (insideEdge)
+            {
+                // An end of the other edge touches this one
+                m_Splits.push_back({ e, t, u < 0.5f ? other.Top : other.Bottom });
+            }
+            else if (insideOther)
+            {
+                m_Splits.push_back({ o, u, t < 0.5f ? edge.Top : edge.Bottom });
+            }
+        }
+        m_Active.push_back(e);
+    }
+
+    if (m_Splits.empty())
+        return false;
+
+    // Several edges through one point give slightly different intersections, they become one
+    // vertex or the pieces would cross again around it
+    float extent = 0.0f;
+    for (unsigned int i = 0; i < vertexCount; i++)
+        extent = std::max(extent, std::max(std::abs(m_SweepPoints[i].x), std::abs(m_SweepPoints[i].y)));
+    float snapDistance = extent * s_SnapEpsilon;
+
+    unsigned int newCount = m_SweepPoints.size() - vertexCount;
+    m_Order.resize(newCount);
+    std::iota(m_Order.begin(), m_Order.end(), vertexCount);
+    std::sort(m_Order.begin(), m_Order.end(), [&](unsigned int a, unsigned int b) { return m_SweepPoints[a].x < m_SweepPoints[b].x; });
+
+    // Onto an existing vertex first (they are sorted by y), then onto each other
+    m_Snapped.assign(newCount, ~0u);
+    for (unsigned int i = 0; i < newCount; i++)
+    {
+        const glm::vec2& point = m_SweepPoints[vertexCount + i];
+        const glm::vec2* nearby = std::lower_bound(m_SweepPoints.data(), m_SweepPoints.data() + vertexCount, point.y - snapDistance,
+            [](const glm::vec2& vertex, float y) { return vertex.y < y; });
+        for (; nearby < m_SweepPoints.data() + vertexCount && nearby->y <= point.y + snapDistance; nearby++)
+        {
+            if (std::abs(nearby->x - point.x) <= snapDistance)
+            {
+                m_Snapped[i] = nearby - m_SweepPoints.data();
+                break;
+            }
+        }
+    }
+    for (unsigned int i = 0; i < newCount; i++)
+    {
+        unsigned int vertex = m_Order[i];
+        if (m_Snapped[vertex - vertexCount] != ~0u)
+            continue;
+        m_Snapped[vertex - vertexCount] = vertex;
+
+        const glm::vec2& point = m_SweepPoints[vertex];
+        for (unsigned int j = i + 1; j < newCount && m_SweepPoints[m_Order[j]].x - point.x <= snapDistance; j++)
+        {
+            unsigned int other = m_Order[j];
+            if (m_Snapped[other - vertexCount] == ~0u && std::abs(m_SweepPoints[other].y - point.y) <= snapDistance)
+                m_Snapped[other - vertexCount] = vertex;
+        }
+    }
+    for (unsigned int i = 0; i < m_Splits.size(); i++)
+    {
+        if (m_Splits[i].Vertex >= vertexCount)
+            m_Splits[i].Vertex = m_Snapped[m_Splits[i].Vertex - vertexCount];
+    }
+
+    // New vertices change the sweep order, sort again with the old vertices as the input points
+    std::sort(m_Splits.begin(), m_Splits.end(), [](const Split& a, const Split& b)
+    {
+        return a.Edge < b.Edge || (a.Edge == b.Edge && a.T < b.T);
+    });
+    m_Points.swap(m_SweepPoints);
+    SortVertices();
+
+    m_Pieces.clear();
+    unsigned int split = 0;
+    for (unsigned int e = 0; e < m_Edges.size(); e++)
+    {
+        const Edge& edge = m_Edges[e];
+        unsigned int previous = edge.Top;
+        for (; split < m_Splits.size() && m_Splits[split].Edge == e; split++)
+        {
+            AddEdge(m_Pieces, previous, m_Splits[split].Vertex, edge.Winding);
+            previous = m_Splits[split].Vertex;
+        }
+        AddEdge(m_Pieces, previous, edge.Bottom, edge.Winding);
+    }
+    m_Edges.swap(m_Pieces);
+    return true;
+}
+
+bool FillTessellator::IsInside(int winding, FillRule rule) const
+{
+    return rule == FillRule::EvenOdd ? (winding & 1) != 0 : winding != 0;
+}
+
+float FillTessellator::GetEdgeX(const Edge& edge, float y) const
+{
+    const glm::vec2& top = m_SweepPoints[edge.Top];
+    const glm::vec2& bottom = m_SweepPoints[edge.Bottom];
+    if (y <= top.y)
+        return top.x;
+    if (y >= bottom.y)
+        return bottom.x;
+    return top.x + (bottom.x - top.x) * (y - top.y) / (bottom.y - top.y);
+}
+
+void FillTessellator::Sweep(FillRule rule)
+{
+    // Edges below each vertex from left to right, a horizontal edge is the rightmost
+    std::sort(m_Edges.begin(), m_Edges.end(), [&](const Edge& a, const Edge& b)
+    {
+        if (a.Top != b.Top)
+            return a.Top < b.Top;
+        glm::vec2 da = m_SweepPoints[a.Bottom] - m_SweepPoints[a.Top];
+        glm::vec2 db = m_SweepPoints[b.Bottom] - m_SweepPoints[b.Top];
+        float cross = Cross(da, db);
+        if (cross != 0.0f)
+            return cross < 0.0f;
+
+        // Collinear, the sort must not depend on the input order
+        return a.Bottom < b.Bottom || (a.Bottom == b.Bottom && a.Winding < b.Winding);
+    });
+
+    unsigned int vertexCount = m_SweepPoints.size();
+    m_EdgeStarts.assign(vertexCount + 1, 0);
+    for (unsigned int e = 0; e < m_Edges.size(); e++)
+        m_EdgeStarts[m_Edges[e].Top + 1]++;
+    for (unsigned int v = 0; v < vertexCount; v++)
+        m_EdgeStarts[v + 1] += m_EdgeStarts[v];
+
+    m_Regions.resize(m_Edges.size());
+    m_Active.clear();
+    m_Polys.clear();
+    m_FreePolys.clear();
+
+    const Region outside = { 0, -1, -1 };
+    for (unsigned int v = 0; v < vertexCount; v++)
+    {
+        const glm::vec2& point = m_SweepPoints[v];
+        unsigned int firstBelow = m_EdgeStarts[v];
+        unsigned int lastBelow = m_EdgeStarts[v + 1];
+
+        // Edges ending at v sit next to each other in the active list
+        unsigned int begin = m_Active.size();
+        unsigned int end = 0;
+        for (unsigned int i = 0; i < m_Active.size(); i++)
+        {
+            if (m_Edges[m_Active[i]].Bottom == v)
+            {
+                begin = std::min(begin, i);
+                end = i + 1;
+            }
+        }
+
+        Region right = outside;
+        if (end > begin)
+        {
+            Region* left = begin > 0 ? &m_Regions[m_Active[begin - 1]] : nullptr;
+            right = m_Regions[m_Active[end - 1]];
+
+            // Regions between the ending edges are done
+            for (unsigned int i = begin; i + 1 < end; i++)
+            {
+                const Region& inner = m_Regions[m_Active[i]];
+                if (inner.LeftPoly < 0)
+                    continue;
+                FinishPoly(inner.LeftPoly, v);
+                if (inner.RightPoly != inner.LeftPoly)
+                    FinishPoly(inner.RightPoly, v);
+            }
+
+            // v is on the right chain of the region to its left, a pending merge vertex gets its
+            // diagonal to v which closes the polygon along that side
+            if (left && left->LeftPoly >= 0)
+            {
+                if (left->RightPoly != left->LeftPoly)
+                {
+                    FinishPoly(left->RightPoly, v);
+                    left->RightPoly = left->LeftPoly;
+                }
+                AddPolyVertex(left->LeftPoly, v, s_RightSide);
+            }
+            if (right.LeftPoly >= 0)
+            {
+                if (right.RightPoly != right.LeftPoly)
+                {
+                    FinishPoly(right.LeftPoly, v);
+                    right.LeftPoly = right.RightPoly;
+                }
+                AddPolyVertex(right.LeftPoly, v, s_LeftSide);
+            }
+
+            m_Active.erase(m_Active.begin() + begin, m_Active.begin() + end);
+
+            // Nothing continues below, the left and right regions become one and v is a merge vertex
+            if (firstBelow == lastBelow)
+            {
+                if (left && left->LeftPoly >= 0 && right.LeftPoly >= 0)
+                    left->RightPoly = right.LeftPoly;
+                continue;
+            }
+        }
+        else
+        {
+            if (firstBelow == lastBelow)
+                continue;
+
+            begin = 0;
+            while (begin < m_Active.size() && GetEdgeX(m_Edges[m_Active[begin]], point.y) <= point.x)
+                begin++;
+
+            Region* left = begin > 0 ? &m_Regions[m_Active[begin - 1]] : nullptr;
+            if (left)
+                right = *left;
+
+            // Split vertex, the region is cut in two by a diagonal from its lowest vertex
+            if (right.LeftPoly >= 0)
+            {
+                if (right.RightPoly != right.LeftPoly)
+                {
+                    AddPolyVertex(right.LeftPoly, v, s_RightSide);
+                    AddPolyVertex(right.RightPoly, v, s_LeftSide);
+                    left->RightPoly = left->LeftPoly;
+                    right.LeftPoly = right.RightPoly;
+                }
+                else
+                {
+                    int poly = right.LeftPoly;
+                    unsigned int helper = m_Polys[poly].LastVertex;
+                    bool helperOnLeft = m_Polys[poly].LastSide == s_LeftSide;
+
+                    // The part on the side of the helper starts over from the helper
+                    int upper = NewPoly(helper);
+                    if (helperOnLeft)
+                    {
+                        AddPolyVertex(upper, v, s_RightSide);
+                        AddPolyVertex(poly, v, s_LeftSide);
+                        left->LeftPoly = left->RightPoly = upper;
+                    }
+                    else
+                    {
+                        AddPolyVertex(poly, v, s_RightSide);
+                        AddPolyVertex(upper, v, s_LeftSide);
+                        right.LeftPoly = right.RightPoly = upper;
+                    }
+                }
+            }
+        }
+
+        // Edges below v open new regions between them, the last one keeps the region on the right
+        int winding = begin > 0 ? m_Regions[m_Active[begin - 1]].Winding : 0;
+        m_Active.insert(m_Active.begin() + begin, lastBelow - firstBelow, 0);
+        for (unsigned int e = firstBelow; e < lastBelow; e++)
+        {
+            m_Active[begin + e - firstBelow] = e;
+            winding += m_Edges[e].Winding;
+
+            Region& region = m_Regions[e];
+            if (e + 1 < lastBelow)
+            {
+                region.Winding = winding;
+                region.LeftPoly = region.RightPoly = IsInside(winding, rule) ? NewPoly(v) : -1;
+            }
+            else
+            {
+                region = right;
+                region.Winding = winding;
+            }
+        }
+    }
+}
+
+int FillTessellator::NewPoly(unsigned int top)
+{
+    int poly;
+    if (!m_FreePolys.empty())
+    {
+        poly = m_FreePolys.back();
+        m_FreePolys.pop_back();
+    }
+    else
+    {
+        poly = m_Polys.size();
+        m_Polys.emplace_back();
+    }
+
+    MonotonePoly& monotone = m_Polys[poly];
+    monotone.Stack.clear();
+    monotone.Stack.push_back(top);
+    monotone.StackSide = s_NoSide;
+    monotone.LastVertex = top;
+    monotone.LastSide = s_NoSide;
+    return poly;
+}
+
+void FillTessellator::AddPolyVertex(int poly, unsigned int vertex, int side)
+{
+    MonotonePoly& monotone = m_Polys[poly];
+    std::vector<unsigned int>& stack = monotone.Stack;
+
+    if (stack.size() > 1 && side != monotone.StackSide)
+    {
+        // Opposite chain, v sees the whole reflex chain
+        for (unsigned int i = 0; i + 1 < stack.size(); i++)
+            EmitTriangle(vertex, stack[i], stack[i + 1]);
+        unsigned int top = stack.back();
+        stack.clear();
+        stack.push_back(top);
+    }
+    else if (stack.size() > 1)
+    {
+        // Same chain, cut ears while the chain turns away from the inside
+        const glm::vec2& point = m_SweepPoints[vertex];
+        unsigned int top = stack.back();
+        stack.pop_back();
+        while (!stack.empty())
+        {
+            unsigned int next = stack.back();
+            float turn = Cross(m_SweepPoints[top] - m_SweepPoints[next], point - m_SweepPoints[next]);
+            if (side == s_LeftSide ? turn >= 0.0f : turn <= 0.0f)
+                break;
+            EmitTriangle(vertex, top, next);
+            top = next;
+            stack.pop_back();
+        }
+        stack.push_back(top);
+    }
+
+    stack.push_back(vertex);
+    monotone.StackSide = side;
+    monotone.LastVertex = vertex;
+    monotone.LastSide = side;
+}
+
+void FillTessellator::FinishPoly(int poly, unsigned int vertex)
+{
+    // The bottom vertex closes both chains
+    std::vector<unsigned int>& stack = m_Polys[poly].Stack;
+    for (unsigned int i = 0; i + 1 < stack.size(); i++)
+        EmitTriangle(vertex, stack[i], stack[i + 1]);
+    stack.clear();
+    m_FreePolys.push_back(poly);
+}
+
+void FillTessellator::EmitTriangle(unsigned int a, unsigned int b, unsigned int c)
+{
+    // Counter clockwise with y up
+    if (Cross(m_SweepPoints[b] - m_SweepPoints[a], m_SweepPoints[c] - m_SweepPoints[a]) < 0.0f)
+        std::swap(b, c);
+    m_Indices.push_back(a);
+    m_Indices.push_back(b);
+    m_Indices.push_back(c);
+}
+
@@ -0,0 +1,53 @@
+#include "Frustum.h"
+
+Frustum::Frustum(const glm::mat4& viewProjection)
+{
+    // Gribb / Hartmann: the planes are sums and differences of the matrix rows (glm is column major)
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++)
+        rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+    m_Planes[LEFT_PLANE] = rows[3] + rows[0];
+    m_Planes[RIGHT_PLANE] = rows[3] - rows[0];
+    m_Planes[BOTTOM_PLANE] = rows[3] + rows[1];
+    m_Planes[TOP_PLANE] = rows[3] - rows[1];
+    m_Planes[NEAR_PLANE] = rows[3] + rows[2];
+    m_Planes[FAR_PLANE] = rows[3] - rows[2];
+
+    for (int i = 0; i < PLANE_COUNT; i++)
+        m_Planes[i] /= glm::length(glm::vec3(m_Planes[i]));
+}
+
+bool Frustum::IntersectsSphere(const glm::vec3& center, float radius) const
+{
+    for (int i = 0; i < PLANE_COUNT; i++)
+    {
+        if (glm::dot(glm::vec3(m_Planes[i]), center) + m_Planes[i].w < -radius)
+            return false;
+    }
+    return true;
+}
+
+bool Frustum::IntersectsAABB(const glm::vec3& center, const glm::vec3& extents) const
+{
+    for (int i = 0; i < PLANE_COUNT; i++)
+    {
+        glm::vec3 normal(m_Planes[i]);
+        float projectedRadius = glm::dot(glm::abs(normal), extents);
+        if (glm::dot(normal, center) + m_Planes[i].w < -projectedRadius)
+            return false;
+    }
+    return true;
+}
+
+bool Frustum::ContainsAABB(const glm::vec3& center, const glm::vec3& extents) const
+{
+    for (int i = 0; i < PLANE_COUNT; i++)
+    {
+        glm::vec3 normal(m_Planes[i]);
+        float projectedRadius = glm::dot(glm::abs(normal), extents);
+        if (glm::dot(normal, center) + m_Planes[i].w < projectedRadius)
+            return false;
+    }
+    return true;
+}
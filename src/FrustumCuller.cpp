@@ -0,0 +1,181 @@
+#include "FrustumCuller.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <cmath>
+
+FrustumCuller::FrustumCuller()
+{
+}
+
+FrustumCuller::~FrustumCuller()
+{
+}
+
+void FrustumCuller::Clear()
+{
+    m_CenterX.clear();
+    m_CenterY.clear();
+    m_CenterZ.clear();
+    m_Radius.clear();
+    m_ExtentX.clear();
+    m_ExtentY.clear();
+    m_ExtentZ.clear();
+}
+
+void FrustumCuller::Reserve(unsigned int count)
+{
+    m_CenterX.reserve(count);
+    m_CenterY.reserve(count);
+    m_CenterZ.reserve(count);
+    m_Radius.reserve(count);
+    m_ExtentX.reserve(count);
+    m_ExtentY.reserve(count);
+    m_ExtentZ.reserve(count);
+}
+
+unsigned int FrustumCuller::Add(const glm::vec3& center, float radius, const glm::vec3& extents)
+{
+    m_CenterX.push_back(center.x);
+    m_CenterY.push_back(center.y);
+    m_CenterZ.push_back(center.z);
+    m_Radius.push_back(radius);
+    m_ExtentX.push_back(extents.x);
+    m_ExtentY.push_back(extents.y);
+    m_ExtentZ.push_back(extents.z);
+    return m_CenterX.size() - 1;
+}
+
+bool FrustumCuller::IsVisible(const Frustum& frustum, unsigned int i) const
+{
+    for (int p = 0; p < Frustum::PLANE_COUNT; p++)
+    {
+        const glm::vec4& plane = frustum.GetPlane(p);
+        float distance = plane.x * m_CenterX[i] + plane.y * m_CenterY[i] + plane.z * m_CenterZ[i] + plane.w;
+
+        // The sphere and the box share the center, whichever reaches less far along the normal is tighter
+        float boxRadius = std::abs(plane.x) * m_ExtentX[i] + std::abs(plane.y) * m_ExtentY[i] + std::abs(plane.z) * m_ExtentZ[i];
+        if (distance < -std::min(m_Radius[i], boxRadius))
+            return false;
+    }
+    return true;
+}
+
+void FrustumCuller::CullScalar(const Frustum& frustum, std::vector<unsigned int>& visible) const
+{
+    visible.clear();
+    unsigned int count = GetCount();
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (IsVisible(frustum, i))
+            visible.push_back(i);
+    }
+}
+
+void FrustumCuller::Cull(const Frustum& frustum, std::vector<unsigned int>& visible) const
+{
+    visible.clear();
+    unsigned int count = GetCount();
+    unsigned int i = 0;
+
+#if defined(SIMD_AVX)
+    __m256 planeX[Frustum::PLANE_COUNT], planeY[Frustum::PLANE_COUNT], planeZ[Frustum::PLANE_COUNT], planeW[Frustum::PLANE_COUNT];
+    __m256 absX[Frustum::PLANE_COUNT], absY[Frustum::PLANE_COUNT], absZ[Frustum::PLANE_COUNT];
+    for (int p = 0; p < Frustum::PLANE_COUNT; p++)
+    {
+        const glm::vec4& plane = frustum.GetPlane(p);
+        planeX[p] = _mm256_set1_ps(plane.x);
+        planeY[p] = _mm256_set1_ps(plane.y);
+        planeZ[p] = _mm256_set1_ps(plane.z);
+        planeW[p] = _mm256_set1_ps(plane.w);
+        absX[p] = _mm256_set1_ps(std::abs(plane.x));
+        absY[p] = _mm256_set1_ps(std::abs(plane.y));
+        absZ[p] = _mm256_set1_ps(std::abs(plane.z));
+    }
+    const __m256 zero = _mm256_setzero_ps();
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 cx = _mm256_loadu_ps(&m_CenterX[i]);
+        __m256 cy = _mm256_loadu_ps(&m_CenterY[i]);
+        __m256 cz = _mm256_loadu_ps(&m_CenterZ[i]);
+        __m256 radius = _mm256_loadu_ps(&m_Radius[i]);
+        __m256 ex = _mm256_loadu_ps(&m_ExtentX[i]);
+        __m256 ey = _mm256_loadu_ps(&m_ExtentY[i]);
+        __m256 ez = _mm256_loadu_ps(&m_ExtentZ[i]);
+
+        __m256 outside = zero;
+        for (int p = 0; p < Frustum::PLANE_COUNT; p++)
+        {
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[p], cx), _mm256_mul_ps(planeY[p], cy)),
+                                            _mm256_add_ps(_mm256_mul_ps(planeZ[p], cz), planeW[p]));
+            __m256 boxRadius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(absX[p], ex), _mm256_mul_ps(absY[p], ey)), _mm256_mul_ps(absZ[p], ez));
+            __m256 reach = _mm256_min_ps(radius, boxRadius);
+
+            // distance + reach < 0 means fully behind this plane
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, reach), zero, _CMP_LT_OQ));
+        }
+
+        unsigned int mask = ~(unsigned int)_mm256_movemask_ps(outside) & 0xFFu;
+        while (mask)
+        {
+            unsigned int bit = 0;
+            while (!(mask & (1u << bit)))
+                bit++;
+            visible.push_back(i + bit);
+            mask &= mask - 1;
+        }
+    }
+#elif defined(SIMD_SSE)
+    __m128 planeX[Frustum::PLANE_COUNT], planeY[Frustum::PLANE_COUNT], planeZ[Frustum::PLANE_COUNT], planeW[Frustum::PLANE_COUNT];
+    __m128 absX[Frustum::PLANE_COUNT], absY[Frustum::PLANE_COUNT], absZ[Frustum::PLANE_COUNT];
+    for (int p = 0; p < Frustum::PLANE_COUNT; p++)
+    {
+        const glm::vec4& plane = frustum.GetPlane(p);
+        planeX[p] = _mm_set1_ps(plane.x);
+        planeY[p] = _mm_set1_ps(plane.y);
+        planeZ[p] = _mm_set1_ps(plane.z);
+        planeW[p] = _mm_set1_ps(plane.w);
+        absX[p] = _mm_set1_ps(std::abs(plane.x));
+        absY[p] = _mm_set1_ps(std::abs(plane.y));
+        absZ[p] = _mm_set1_ps(std::abs(plane.z));
+    }
+    const __m128 zero = _mm_setzero_ps();
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 cx = _mm_loadu_ps(&m_CenterX[i]);
+        __m128 cy = _mm_loadu_ps(&m_CenterY[i]);
+        __m128 cz = _mm_loadu_ps(&m_CenterZ[i]);
+        __m128 radius = _mm_loadu_ps(&m_Radius[i]);
+        __m128 ex = _mm_loadu_ps(&m_ExtentX[i]);
+        __m128 ey = _mm_loadu_ps(&m_ExtentY[i]);
+        __m128 ez = _mm_loadu_ps(&m_ExtentZ[i]);
+
+        __m128 outside = zero;
+        for (int p = 0; p < Frustum::PLANE_COUNT; p++)
+        {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], cx), _mm_mul_ps(planeY[p], cy)),
+                                         _mm_add_ps(_mm_mul_ps(planeZ[p], cz), planeW[p]));
+            __m128 boxRadius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absX[p], ex), _mm_mul_ps(absY[p], ey)), _mm_mul_ps(absZ[p], ez));
+            __m128 reach = _mm_min_ps(radius, boxRadius);
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, reach), zero));
+        }
+
+        unsigned int mask = ~(unsigned int)_mm_movemask_ps(outside) & 0xFu;
+        for (unsigned int bit = 0; bit < 4; bit++)
+        {
+            if (mask & (1u << bit))
+                visible.push_back(i + bit);
+        }
+    }
+#endif
+
+    // Remaining objects (or everything without SIMD)
+    for (; i < count; i++)
+    {
+        if (IsVisible(frustum, i))
+            visible.push_back(i);
+    }
+}
+
@@ -3,14 +3,16 @@
 #include "Renderer.h"
 
 
-IndexBuffer::IndexBuffer() {
+IndexBuffer::IndexBuffer()
+	:m_Count(0), m_Type(GL_UNSIGNED_INT)
+{
 	GLCall(glGenBuffers(1, &m_Render_ID));
 	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_Render_ID));
 
 }
 
 IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count)
-	:m_Count(count)
+	:m_Count(count), m_Type(GL_UNSIGNED_INT)
 {
 	ASSERT(sizeof(unsigned int) == sizeof(GLuint)); 
 	GLCall(glGenBuffers(1, &m_Render_ID));
@@ -18,6 +20,16 @@ IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count)
 	GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int  ), data, GL_STATIC_DRAW));
 }
 
+// 16 bit indices halve the index bandwidth for meshes with at most 65536 vertices
+IndexBuffer::IndexBuffer(const unsigned short* data, unsigned int count)
+	:m_Count(count), m_Type(GL_UNSIGNED_SHORT)
+{
+	ASSERT(sizeof(unsigned short) == sizeof(GLushort));
+	GLCall(glGenBuffers(1, &m_Render_ID));
+	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_Render_ID));
+	GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned short), data, GL_STATIC_DRAW));
+}
+
 IndexBuffer::~IndexBuffer()
 {
 	GLCall(glDeleteBuffers(1, &m_Render_ID));
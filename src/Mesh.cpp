@@ -0,0 +1,115 @@
+#include "Mesh.h"
+#include "Renderer.h"
+#include <algorithm>
+#include <cmath>
+
+Mesh::Mesh(std::vector<float> vertices, std::vector<unsigned int> indices, VertexFormat format)
+    : m_Vertices(std::move(vertices)), m_Indices(std::move(indices)),
+    m_VertexFormat(format), m_PositionOffset(0.0f, 0.0f, 0.0f), m_PositionScale(1.0f, 1.0f, 1.0f),
+    m_GPUBufferSize(0), m_BoundsMin(0.0f), m_BoundsMax(0.0f), m_BoundingRadius(0.0f)
+{
+    ComputeBounds();
+    Upload();
+}
+
+Mesh::~Mesh()
+{
+}
+
+void Mesh::ComputeBounds()
+{
+    unsigned int vertexCount = GetVertexCount();
+    if (vertexCount == 0)
+        return;
+
+    m_BoundsMin = m_BoundsMax = glm::vec3(m_Vertices[0], m_Vertices[1], m_Vertices[2]);
+    for (unsigned int i = 1; i < vertexCount; i++)
+    {
+        glm::vec3 p(m_Vertices[i * 6], m_Vertices[i * 6 + 1], m_Vertices[i * 6 + 2]);
+        m_BoundsMin = glm::min(m_BoundsMin, p);
+        m_BoundsMax = glm::max(m_BoundsMax, p);
+    }
+
+    glm::vec3 center = GetBoundsCenter();
+    float radiusSquared = 0.0f;
+    for (unsigned int i = 0; i < vertexCount; i++)
+    {
+        glm::vec3 d = glm::vec3(m_Vertices[i * 6], m_Vertices[i * 6 + 1], m_Vertices[i * 6 + 2]) - center;
+        radiusSquared = std::max(radiusSquared, glm::dot(d, d));
+    }
+    m_BoundingRadius = std::sqrt(radiusSquared);
+}
+
+void Mesh::Upload()
+{
+    if (m_Vertices.empty() || m_Indices.empty())
+        return;
+
+    // Create vertex array and buffer
+    m_VAO = std::make_unique<VertexArray>();
+
+    if (m_VertexFormat == VertexFormat::Float)
+    {
+        m_VBO = std::make_unique<VertexBuffer>(m_Vertices.data(), m_Vertices.size() * sizeof(float));
+        m_GPUBufferSize = m_Vertices.size() * sizeof(float);
+
+        // Setup the vertex buffer layout
+        VertexBufferLayout layout;
+        layout.Push<float>(3); // Position (3 components: x, y, z)
+        layout.Push<float>(3); // Normal (3 components: nx, ny, nz)
+        m_VAO->AddBuffer(*m_VBO, layout);
+    }
+    else
+    {
+        // Quantized positions + octahedral normals, see VertexCompression.h
+        CompressedVertexData compressed = CompressVertices(m_Vertices, m_VertexFormat);
+        m_VBO = std::make_unique<VertexBuffer>(compressed.Data.data(), compressed.Data.size());
+        m_PositionOffset = compressed.PositionOffset;
+        m_PositionScale = compressed.PositionScale;
+        m_GPUBufferSize = compressed.Data.size();
+        m_VAO->AddBuffer(*m_VBO, compressed.Layout);
+    }
+
+    // Create index buffer, 16 bit when every index fits
+    if (GetVertexCount() <= 65536)
+    {
+        std::vector<unsigned short> shortIndices(m_Indices.begin(), m_Indices.end());
+        m_IBO = std::make_unique<IndexBuffer>(shortIndices.data(), shortIndices.size());
+        m_GPUBufferSize += shortIndices.size() * sizeof(unsigned short);
+    }
+    else
+    {
+        m_IBO = std::make_unique<IndexBuffer>(m_Indices.data(), m_Indices.size());
+        m_GPUBufferSize += m_Indices.size() * sizeof(unsigned int);
+    }
+}
+
+void Mesh::UpdateVertices(const float* vertices, unsigned int firstVertex, unsigned int vertexCount)
+{
+    ASSERT(m_VertexFormat == VertexFormat::Float);
+    ASSERT(firstVertex + vertexCount <= GetVertexCount());
+    if (!m_VBO || vertexCount == 0)
+        return;
+
+    std::copy(vertices, vertices + vertexCount * 6, m_Vertices.begin() + firstVertex * 6);
+    m_VBO->UpdateData(vertices, firstVertex * 6 * sizeof(float), vertexCount * 6 * sizeof(float));
+    ComputeBounds();
+}
+
+void Mesh::Bind() const
+{
+    if (m_VAO && m_IBO)
+    {
+        m_VAO->Bind();
+        m_IBO->Bind();
+    }
+}
+
+void Mesh::Unbind() const
+{
+    if (m_VAO && m_IBO)
+    {
+        m_VAO->Unbind();
+        m_IBO->Unbind();
+    }
+}
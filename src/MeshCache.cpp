@@ -0,0 +1,42 @@
+#include "MeshCache.h"
+
+MeshCache& MeshCache::Get()
+{
+    static MeshCache s_Instance;
+    return s_Instance;
+}
+
+std::shared_ptr<Mesh> MeshCache::Find(const std::string& key)
+{
+    auto it = m_Meshes.find(key);
+    if (it == m_Meshes.end())
+        return nullptr;
+
+    std::shared_ptr<Mesh> mesh = it->second.lock();
+    if (!mesh)
+        m_Meshes.erase(it); // Last user is gone, drop the stale entry
+    return mesh;
+}
+
+void MeshCache::Insert(const std::string& key, const std::shared_ptr<Mesh>& mesh)
+{
+    m_Meshes[key] = mesh;
+}
+
+unsigned int MeshCache::GetLiveMeshCount()
+{
+    unsigned int count = 0;
+    for (auto it = m_Meshes.begin(); it != m_Meshes.end();)
+    {
+        if (it->second.expired())
+        {
+            it = m_Meshes.erase(it);
+        }
+        else
+        {
+            count++;
+            ++it;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,386 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <glm/glm.hpp>
+
+VertexCacheStatistics AnalyzeVertexCache(const std::vector<unsigned int>& indices, unsigned int vertexCount, unsigned int cacheSize)
+{
+    VertexCacheStatistics stats = { 0, 0.0f, 0.0f };
+    if (indices.empty() || vertexCount == 0)
+        return stats;
+
+    // FIFO cache, a vertex is in the cache if it was pushed less than cacheSize pushes ago
+    std::vector<unsigned int> cacheTimestamps(vertexCount, 0);
+    unsigned int timestamp = cacheSize + 1;
+
+    for (unsigned int index : indices)
+    {
+        if (timestamp - cacheTimestamps[index] > cacheSize)
+        {
+            cacheTimestamps[index] = timestamp++;
+            stats.CacheMisses++;
+        }
+    }
+
+    stats.ACMR = (float)stats.CacheMisses / (float)(indices.size() / 3);
+    stats.ATVR = (float)stats.CacheMisses / (float)vertexCount;
+    return stats;
+}
+
+unsigned int WeldVertices(std::vector<float>& vertices, std::vector<unsigned int>& indices, unsigned int floatsPerVertex, float epsilon)
+{
+    unsigned int vertexCount = vertices.size() / floatsPerVertex;
+    std::vector<unsigned int> remap(vertexCount);
+    std::vector<float> welded;
+    welded.reserve(vertices.size());
+
+    // Hash the (optionally quantized) attribute bits so equal vertices land in the same bucket
+    std::unordered_map<std::string, unsigned int> unique;
+    unique.reserve(vertexCount);
+    std::string key(floatsPerVertex * sizeof(float), '\0');
+
+    for (unsigned int i = 0; i < vertexCount; i++)
+    {
+        const float* v = &vertices[i * floatsPerVertex];
+        for (unsigned int k = 0; k < floatsPerVertex; k++)
+        {
+            float value = epsilon > 0.0f ? std::round(v[k] / epsilon) : v[k];
+            if (value == 0.0f)
+                value = 0.0f; // -0 and +0 should weld
+            std::memcpy(&key[k * sizeof(float)], &value, sizeof(float));
+        }
+
+        auto it = unique.find(key);
+        if (it != unique.end())
+        {
+            remap[i] = it->second;
+        }
+        else
+        {
+            unsigned int newIndex = welded.size() / floatsPerVertex;
+            unique.emplace(key, newIndex);
+            welded.insert(welded.end(), v, v + floatsPerVertex);
+            remap[i] = newIndex;
+        }
+    }
+
+    for (unsigned int& index : indices)
+        index = remap[index];
+
+    vertices.swap(welded);
+    return vertices.size() / floatsPerVertex;
+}
+
+// Forsyth scoring, see "Linear-Speed Vertex Cache Optimisation" (Tom Forsyth, 2006)
+static const int s_CacheSize = 32;
+static const float s_CacheDecayPower = 1.5f;
+static const float s_LastTriangleScore = 0.75f;
+static const float s_ValenceBoostScale = 2.0f;
+static const float s_ValenceBoostPower = 0.5f;
+
+static float ForsythVertexScore(int cachePosition, unsigned int remainingTriangles)
+{
+    // No triangle left to draw, the vertex is useless
+    if (remainingTriangles == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        // The three vertices of the last triangle get a fixed score so it is not reused straight away
+        if (cachePosition < 3)
+            score = s_LastTriangleScore;
+        else
+            score = std::pow(1.0f - (float)(cachePosition - 3) / (float)(s_CacheSize - 3), s_CacheDecayPower);
+    }
+
+    // Boost vertices with few triangles left so lonely triangles get drawn early
+    score += s_ValenceBoostScale * std::pow((float)remainingTriangles, -s_ValenceBoostPower);
+    return score;
+}
+
+void OptimizeVertexCache(std::vector<unsigned int>& indices, unsigned int vertexCount)
+{
+    unsigned int triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    // Vertex -> triangle adjacency in compact form
+    std::vector<unsigned int> triangleOffsets(vertexCount + 1, 0);
+    for (unsigned int index : indices)
+        triangleOffsets[index + 1]++;
+    for (unsigned int i = 0; i < vertexCount; i++)
+        triangleOffsets[i + 1] += triangleOffsets[i];
+
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<unsigned int> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+    for (unsigned int t = 0; t < triangleCount; t++)
+        for (unsigned int k = 0; k < 3; k++)
+            adjacency[fill[indices[t * 3 + k]]++] = t;
+
+    std::vector<unsigned int> remaining(vertexCount);
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (unsigned int v = 0; v < vertexCount; v++)
+    {
+        remaining[v] = triangleOffsets[v + 1] - triangleOffsets[v];
+        vertexScore[v] = ForsythVertexScore(-1, remaining[v]);
+    }
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (unsigned int t = 0; t < triangleCount; t++)
+        triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+
+    // LRU cache with room for the three incoming vertices
+    std::vector<unsigned int> cache;
+    std::vector<unsigned int> newCache;
+    cache.reserve(s_CacheSize + 3);
+    newCache.reserve(s_CacheSize + 3);
+
+    unsigned int scanPosition = 0;
+    int bestTriangle = -1;
+
+    for (unsigned int emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+    {
+        // Cache ran dry (or first triangle), pick the best remaining triangle with a linear scan
+        if (bestTriangle < 0)
+        {
+            float bestScore = -1.0f;
+            for (unsigned int t = scanPosition; t < triangleCount; t++)
+            {
+                if (!emitted[t] && triangleScore[t] > bestScore)
+                {
+                    bestScore = triangleScore[t];
+                    bestTriangle = t;
+                }
+            }
+            while (scanPosition < triangleCount && emitted[scanPosition])
+                scanPosition++;
+        }
+
+        const unsigned int* tri = &indices[bestTriangle * 3];
+        result.insert(result.end(), tri, tri + 3);
+        emitted[bestTriangle] = true;
+
+        // Remove the triangle from its vertices' adjacency
+        for (unsigned int k = 0; k < 3; k++)
+        {
+            unsigned int v = tri[k];
+            unsigned int* begin = &adjacency[triangleOffsets[v]];
+            unsigned int* end = begin + remaining[v];
+            unsigned int* found = std::find(begin, end, (unsigned int)bestTriangle);
+            std::swap(*found, *(end - 1));
+            remaining[v]--;
+        }
+
+        // Move the triangle's vertices to the front of the LRU cache
+        newCache.clear();
+        newCache.insert(newCache.end(), tri, tri + 3);
+        for (unsigned int v : cache)
+        {
+            if (v != tri[0] && v != tri[1] && v != tri[2])
+                newCache.push_back(v);
+        }
+
+        // Vertices falling out of the cache lose their position score
+        for (size_t i = s_CacheSize; i < newCache.size(); i++)
+            cachePosition[newCache[i]] = -1;
+        if (newCache.size() > (size_t)s_CacheSize)
+            newCache.resize(s_CacheSize);
+        cache.swap(newCache);
+
+        // Rescore cached vertices and their triangles, remember the best candidate
+        for (size_t i = 0; i < cache.size(); i++)
+        {
+            unsigned int v = cache[i];
+            cachePosition[v] = (int)i;
+            vertexScore[v] = ForsythVertexScore((int)i, remaining[v]);
+        }
+
+        bestTriangle = -1;
+        float bestScore = -1.0f;
+        for (unsigned int v : cache)
+        {
+            for (unsigned int a = 0; a < remaining[v]; a++)
+            {
+                unsigned int t = adjacency[triangleOffsets[v] + a];
+                float score = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+                triangleScore[t] = score;
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    bestTriangle = t;
+                }
+            }
+        }
+    }
+
+    indices.swap(result);
+}
+
+void OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<float>& vertices, unsigned int floatsPerVertex, float threshold)
+{
+    unsigned int triangleCount = indices.size() / 3;
+    unsigned int vertexCount = vertices.size() / floatsPerVertex;
+    if (triangleCount == 0)
+        return;
+
+    const unsigned int cacheSize = 16;
+    std::vector<unsigned int> cacheTimestamps(vertexCount, 0);
+    unsigned int timestamp = cacheSize + 1;
+
+    auto triangleMisses = [&](unsigned int t)
+    {
+        unsigned int misses = 0;
+        for (unsigned int k = 0; k < 3; k++)
+        {
+            unsigned int v = indices[t * 3 + k];
+            if (timestamp - cacheTimestamps[v] > cacheSize)
+            {
+                cacheTimestamps[v] = timestamp++;
+                misses++;
+            }
+        }
+        return misses;
+    };
+    auto resetCache = [&]() { timestamp += cacheSize + 1; };
+
+    // Hard boundaries: triangles where the cache had nothing to offer, the optimizer restarted there.
+    // The first cluster always starts at 0, a degenerate or cached first triangle is no boundary
+    std::vector<unsigned int> hardBoundaries(1, 0);
+    for (unsigned int t = 0; t < triangleCount; t++)
+    {
+        if (triangleMisses(t) == 3 && t > 0)
+            hardBoundaries.push_back(t);
+    }
+    hardBoundaries.push_back(triangleCount);
+
+    // Soft boundaries: cut hard clusters further wherever the running ACMR stays under the threshold
+    std::vector<unsigned int> clusters;
+    for (size_t h = 0; h + 1 < hardBoundaries.size(); h++)
+    {
+        unsigned int start = hardBoundaries[h];
+        unsigned int end = hardBoundaries[h + 1];
+
+        resetCache();
+        unsigned int clusterMisses = 0;
+        for (unsigned int t = start; t < end; t++)
+            clusterMisses += triangleMisses(t);
+        float clusterThreshold = threshold * (float)clusterMisses / (float)(end - start);
+
+        resetCache();
+        clusters.push_back(start);
+        unsigned int runningMisses = 0;
+        unsigned int runningTriangles = 0;
+        for (unsigned int t = start; t < end; t++)
+        {
+            runningMisses += triangleMisses(t);
+            runningTriangles++;
+            if (t + 1 < end && (float)runningMisses / (float)runningTriangles <= clusterThreshold)
+            {
+                clusters.push_back(t + 1);
+                resetCache();
+                runningMisses = 0;
+                runningTriangles = 0;
+            }
+        }
+    }
+    clusters.push_back(triangleCount);
+
+    auto position = [&](unsigned int v)
+    {
+        return glm::vec3(vertices[v * floatsPerVertex], vertices[v * floatsPerVertex + 1], vertices[v * floatsPerVertex + 2]);
+    };
+
+    // Area weighted mesh centroid
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    for (unsigned int t = 0; t < triangleCount; t++)
+    {
+        glm::vec3 a = position(indices[t * 3]), b = position(indices[t * 3 + 1]), c = position(indices[t * 3 + 2]);
+        float area = glm::length(glm::cross(b - a, c - a));
+        meshCentroid += (a + b + c) * (area / 3.0f);
+        meshArea += area;
+    }
+    if (meshArea > 0.0f)
+        meshCentroid /= meshArea;
+
+    // Clusters facing away from the centroid are more likely to occlude the others, draw them first
+    size_t clusterCount = clusters.size() - 1;
+    std::vector<float> sortKeys(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        glm::vec3 centroid(0.0f), normal(0.0f);
+        float area = 0.0f;
+        for (unsigned int t = clusters[c]; t < clusters[c + 1]; t++)
+        {
+            glm::vec3 p0 = position(indices[t * 3]), p1 = position(indices[t * 3 + 1]), p2 = position(indices[t * 3 + 2]);
+            glm::vec3 faceNormal = glm::cross(p1 - p0, p2 - p0);
+            float faceArea = glm::length(faceNormal);
+            centroid += (p0 + p1 + p2) * (faceArea / 3.0f);
+            normal += faceNormal;
+            area += faceArea;
+        }
+        if (area > 0.0f)
+            centroid /= area;
+        float normalLength = glm::length(normal);
+        sortKeys[c] = normalLength > 0.0f ? glm::dot(centroid - meshCentroid, normal / normalLength) : 0.0f;
+    }
+
+    std::vector<unsigned int> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++)
+        order[c] = c;
+    std::stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    for (unsigned int c : order)
+        result.insert(result.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+
+    indices.swap(result);
+}
+
+void OptimizeVertexFetch(std::vector<float>& vertices, std::vector<unsigned int>& indices, unsigned int floatsPerVertex)
+{
+    const unsigned int unused = ~0u;
+    unsigned int vertexCount = vertices.size() / floatsPerVertex;
+    std::vector<unsigned int> remap(vertexCount, unused);
+    std::vector<float> reordered;
+    reordered.reserve(vertices.size());
+
+    for (unsigned int& index : indices)
+    {
+        if (remap[index] == unused)
+        {
+            remap[index] = reordered.size() / floatsPerVertex;
+            reordered.insert(reordered.end(), vertices.begin() + index * floatsPerVertex, vertices.begin() + (index + 1) * floatsPerVertex);
+        }
+        index = remap[index];
+    }
+
+    vertices.swap(reordered);
+}
+
+MeshOptimizationReport OptimizeMesh(std::vector<float>& vertices, std::vector<unsigned int>& indices, unsigned int floatsPerVertex, float weldEpsilon)
+{
+    MeshOptimizationReport report;
+    report.VerticesBefore = vertices.size() / floatsPerVertex;
+    report.Before = AnalyzeVertexCache(indices, report.VerticesBefore);
+
+    unsigned int vertexCount = WeldVertices(vertices, indices, floatsPerVertex, weldEpsilon);
+    OptimizeVertexCache(indices, vertexCount);
+    OptimizeOverdraw(indices, vertices, floatsPerVertex);
+    OptimizeVertexFetch(vertices, indices, floatsPerVertex);
+
+    report.VerticesAfter = vertices.size() / floatsPerVertex;
+    report.After = AnalyzeVertexCache(indices, report.VerticesAfter);
+    return report;
+}
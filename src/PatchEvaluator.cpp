@@ -0,0 +1,505 @@
+#include "PatchEvaluator.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+const unsigned int PatchEvaluator::s_VertexStride;
+const unsigned int PatchEvaluator::s_FramePlanes;
+
+// Below this many vertices the threads cost more than they save
+static const unsigned int s_ParallelThreshold = 16384;
+
+// Below this |dS/du x dS/dv| the point is degenerate (collapsed edge) and the normal comes from
+// the second derivatives
+static const float s_MinNormalLength = 1e-4f;
+
+#if defined(SIMD_AVX)
+static const unsigned int s_SimdWidth = 8;
+#elif defined(SIMD_SSE)
+static const unsigned int s_SimdWidth = 4;
+#else
+static const unsigned int s_SimdWidth = 1;
+#endif
+
+PatchEvaluator::PatchEvaluator()
+    : m_PaddedSamplesV(0)
+{
+}
+
+PatchEvaluator::~PatchEvaluator()
+{
+}
+
+void PatchEvaluator::Build(unsigned int degreeU, unsigned int degreeV, unsigned int resolutionU, unsigned int resolutionV)
+{
+    m_BasisU.Build(degreeU, resolutionU);
+
+    bool rebuildV = m_WeightsV.empty() || m_BasisV.GetDegree() != degreeV || m_BasisV.GetResolution() != resolutionV;
+    m_BasisV.Build(degreeV, resolutionV);
+    if (!rebuildV)
+        return;
+
+    unsigned int samples = resolutionV + 1;
+    m_PaddedSamplesV = (samples + s_SimdWidth - 1) / s_SimdWidth * s_SimdWidth;
+    m_WeightsV.assign((degreeV + 1) * m_PaddedSamplesV, 0.0f);
+    m_DerivativesV.assign((degreeV + 1) * m_PaddedSamplesV, 0.0f);
+    for (unsigned int s = 0; s < samples; s++)
+    {
+        const float* weights = m_BasisV.GetWeights(s);
+        const float* derivatives = m_BasisV.GetDerivativeWeights(s);
+        for (unsigned int b = 0; b <= degreeV; b++)
+        {
+            m_WeightsV[b * m_PaddedSamplesV + s] = weights[b];
+            m_DerivativesV[b * m_PaddedSamplesV + s] = derivatives[b];
+        }
+    }
+}
+
+void PatchEvaluator::Evaluate(const glm::vec3* net, float* output, bool parallel, float* frame) const
+{
+    unsigned int rows = GetResolutionU() + 1;
+    unsigned int threadCount = std::max(1u, std::thread::hardware_concurrency());
+    if (!parallel || GetVertexCount() < s_ParallelThreshold || threadCount == 1)
+    {
+        EvaluateRows(net, 0, rows, output, frame);
+        return;
+    }
+
+    unsigned int chunk = (rows + threadCount - 1) / threadCount;
+    unsigned int rowFloats = (GetResolutionV() + 1) * s_VertexStride;
+    std::vector<std::thread> threads;
+    for (unsigned int first = 0; first < rows; first += chunk)
+    {
+        unsigned int last = std::min(first + chunk, rows);
+        float* rowOutput = output + first * rowFloats;
+        float* rowFrame = frame ? frame + first * s_FramePlanes * m_PaddedSamplesV : nullptr;
+        threads.emplace_back([this, net, first, last, rowOutput, rowFrame]() { EvaluateRows(net, first, last, rowOutput, rowFrame); });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+void PatchEvaluator::ApplyControlPointDelta(const glm::vec3* net, unsigned int i, unsigned int j, const glm::vec3& delta, float* frame, float* output, bool parallel) const
+{
+    unsigned int rows = GetResolutionU() + 1;
+    unsigned int threadCount = std::max(1u, std::thread::hardware_concurrency());
+    if (!parallel || GetVertexCount() < s_ParallelThreshold || threadCount == 1)
+    {
+        ApplyDeltaRows(net, i, j, delta, 0, rows, frame, output);
+        return;
+    }
+
+    unsigned int chunk = (rows + threadCount - 1) / threadCount;
+    unsigned int rowFloats = (GetResolutionV() + 1) * s_VertexStride;
+    std::vector<std::thread> threads;
+    for (unsigned int first = 0; first < rows; first += chunk)
+    {
+        unsigned int last = std::min(first + chunk, rows);
+        float* rowOutput = output + first * rowFloats;
+        float* rowFrame = frame + first * s_FramePlanes * m_PaddedSamplesV;
+        threads.emplace_back([this, net, i, j, delta, first, last, rowFrame, rowOutput]() { ApplyDeltaRows(net, i, j, delta, first, last, rowFrame, rowOutput); });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+#if defined(SIMD_AVX) || defined(SIMD_SSE)
+// 4 samples as x, y, z, nx, ny, nz vertices, a 6 x 4 transpose through pairs of components
+static inline void StoreInterleaved(__m128 x, __m128 y, __m128 z, __m128 nx, __m128 ny, __m128 nz, float* vertices)
+{
+    __m128 xy01 = _mm_unpacklo_ps(x, y), xy23 = _mm_unpackhi_ps(x, y);
+    __m128 zn01 = _mm_unpacklo_ps(z, nx), zn23 = _mm_unpackhi_ps(z, nx);
+    __m128 nn01 = _mm_unpacklo_ps(ny, nz), nn23 = _mm_unpackhi_ps(ny, nz);
+    _mm_storeu_ps(vertices, _mm_movelh_ps(xy01, zn01));
+    _mm_storeu_ps(vertices + 4, _mm_shuffle_ps(nn01, xy01, _MM_SHUFFLE(3, 2, 1, 0)));
+    _mm_storeu_ps(vertices + 8, _mm_movehl_ps(nn01, zn01));
+    _mm_storeu_ps(vertices + 12, _mm_movelh_ps(xy23, zn23));
+    _mm_storeu_ps(vertices + 16, _mm_shuffle_ps(nn23, xy23, _MM_SHUFFLE(3, 2, 1, 0)));
+    _mm_storeu_ps(vertices + 20, _mm_movehl_ps(nn23, zn23));
+}
+#endif
+
+#if defined(SIMD_AVX)
+// Unit normals dS/du x dS/dv of 8 samples. With a full chunk of valid normals the vertices go
+// straight to the output, otherwise they are left in lanes (x, y, z, nx, ny, nz) for WriteLanes
+// and false is returned
+static inline bool StoreVertices(__m256 px, __m256 py, __m256 pz, __m256 ux, __m256 uy, __m256 uz, __m256 vx, __m256 vy, __m256 vz,
+    unsigned int laneCount, float* vertices, float (*lanes)[8], unsigned int& validLanes)
+{
+    __m256 nx = _mm256_sub_ps(_mm256_mul_ps(uy, vz), _mm256_mul_ps(uz, vy));
+    __m256 ny = _mm256_sub_ps(_mm256_mul_ps(uz, vx), _mm256_mul_ps(ux, vz));
+    __m256 nz = _mm256_sub_ps(_mm256_mul_ps(ux, vy), _mm256_mul_ps(uy, vx));
+    __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, nx), _mm256_mul_ps(ny, ny)), _mm256_mul_ps(nz, nz)));
+    __m256 valid = _mm256_cmp_ps(length, _mm256_set1_ps(s_MinNormalLength), _CMP_GT_OQ);
+    __m256 inverse = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_max_ps(length, _mm256_set1_ps(s_MinNormalLength)));
+    nx = _mm256_and_ps(valid, _mm256_mul_ps(nx, inverse));
+    ny = _mm256_and_ps(valid, _mm256_mul_ps(ny, inverse));
+    nz = _mm256_blendv_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(nz, inverse), valid);
+    validLanes = _mm256_movemask_ps(valid);
+
+    if (validLanes == 0xFF && laneCount == 8)
+    {
+        StoreInterleaved(_mm256_castps256_ps128(px), _mm256_castps256_ps128(py), _mm256_castps256_ps128(pz),
+            _mm256_castps256_ps128(nx), _mm256_castps256_ps128(ny), _mm256_castps256_ps128(nz), vertices);
+        StoreInterleaved(_mm256_extractf128_ps(px, 1), _mm256_extractf128_ps(py, 1), _mm256_extractf128_ps(pz, 1),
+            _mm256_extractf128_ps(nx, 1), _mm256_extractf128_ps(ny, 1), _mm256_extractf128_ps(nz, 1), vertices + 24);
+        return true;
+    }
+
+    _mm256_store_ps(lanes[0], px);
+    _mm256_store_ps(lanes[1], py);
+    _mm256_store_ps(lanes[2], pz);
+    _mm256_store_ps(lanes[3], nx);
+    _mm256_store_ps(lanes[4], ny);
+    _mm256_store_ps(lanes[5], nz);
+    return false;
+}
+#elif defined(SIMD_SSE)
+static inline bool StoreVertices(__m128 px, __m128 py, __m128 pz, __m128 ux, __m128 uy, __m128 uz, __m128 vx, __m128 vy, __m128 vz,
+    unsigned int laneCount, float* vertices, float (*lanes)[8], unsigned int& validLanes)
+{
+    __m128 nx = _mm_sub_ps(_mm_mul_ps(uy, vz), _mm_mul_ps(uz, vy));
+    __m128 ny = _mm_sub_ps(_mm_mul_ps(uz, vx), _mm_mul_ps(ux, vz));
+    __m128 nz = _mm_sub_ps(_mm_mul_ps(ux, vy), _mm_mul_ps(uy, vx));
+    __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz)));
+    __m128 valid = _mm_cmpgt_ps(length, _mm_set1_ps(s_MinNormalLength));
+    __m128 inverse = _mm_div_ps(_mm_set1_ps(1.0f), _mm_max_ps(length, _mm_set1_ps(s_MinNormalLength)));
+    nx = _mm_and_ps(valid, _mm_mul_ps(nx, inverse));
+    ny = _mm_and_ps(valid, _mm_mul_ps(ny, inverse));
+    nz = _mm_or_ps(_mm_and_ps(valid, _mm_mul_ps(nz, inverse)), _mm_andnot_ps(valid, _mm_set1_ps(1.0f)));
+    validLanes = _mm_movemask_ps(valid);
+
+    if (validLanes == 0xF && laneCount == 4)
+    {
+        StoreInterleaved(px, py, pz, nx, ny, nz, vertices);
+        return true;
+    }
+
+    _mm_store_ps(lanes[0], px);
+    _mm_store_ps(lanes[1], py);
+    _mm_store_ps(lanes[2], pz);
+    _mm_store_ps(lanes[3], nx);
+    _mm_store_ps(lanes[4], ny);
+    _mm_store_ps(lanes[5], nz);
+    return false;
+}
+#endif
+
+void PatchEvaluator::WriteLanes(const glm::vec3* net, unsigned int sampleU, unsigned int firstV, const float (*lanes)[8], unsigned int validLanes, float* rowOutput) const
+{
+    // Partial chunks, the padded lanes past the row end are dropped, lanes where the normal
+    // vanished are redone with EvaluatePoint
+    unsigned int laneCount = std::min(s_SimdWidth, m_BasisV.GetResolution() + 1 - firstV);
+    for (unsigned int lane = 0; lane < laneCount; lane++)
+    {
+        float* vertex = rowOutput + (firstV + lane) * s_VertexStride;
+        for (unsigned int c = 0; c < 6; c++)
+            vertex[c] = lanes[c][lane];
+        if (!(validLanes & (1u << lane)))
+            SetDegenerateNormal(net, sampleU, firstV + lane, vertex);
+    }
+}
+
+void PatchEvaluator::WriteVertex(const glm::vec3* net, unsigned int sampleU, unsigned int sampleV, const glm::vec3& point, const glm::vec3& tangentU, const glm::vec3& tangentV, float* vertex) const
+{
+    glm::vec3 normal = glm::cross(tangentU, tangentV);
+    float length = glm::length(normal);
+
+    vertex[0] = point.x;
+    vertex[1] = point.y;
+    vertex[2] = point.z;
+    if (length > s_MinNormalLength)
+    {
+        normal /= length;
+        vertex[3] = normal.x;
+        vertex[4] = normal.y;
+        vertex[5] = normal.z;
+    }
+    else
+    {
+        SetDegenerateNormal(net, sampleU, sampleV, vertex);
+    }
+}
+
+void PatchEvaluator::EvaluateRows(const glm::vec3* net, unsigned int first, unsigned int last, float* output, float* frame) const
+{
+    unsigned int countU = m_BasisU.GetDegree() + 1;
+    unsigned int countV = m_BasisV.GetDegree() + 1;
+    unsigned int samplesV = m_BasisV.GetResolution() + 1;
+    unsigned int padded = m_PaddedSamplesV;
+
+    // The net contracted with the u weights (and their derivatives) of the current row
+    glm::vec3 rowStack[s_MaxStackControlPoints];
+    glm::vec3 rowDerivativeStack[s_MaxStackControlPoints];
+    std::vector<glm::vec3> rowHeap, rowDerivativeHeap;
+    glm::vec3* row = rowStack;
+    glm::vec3* rowDerivative = rowDerivativeStack;
+    if (countV > s_MaxStackControlPoints)
+    {
+        rowHeap.resize(countV);
+        rowDerivativeHeap.resize(countV);
+        row = rowHeap.data();
+        rowDerivative = rowDerivativeHeap.data();
+    }
+
+    for (unsigned int i = first; i < last; i++)
+    {
+        const float* weightsU = m_BasisU.GetWeights(i);
+        const float* derivativesU = m_BasisU.GetDerivativeWeights(i);
+        for (unsigned int b = 0; b < countV; b++)
+        {
+            glm::vec3 point(0.0f), derivative(0.0f);
+            for (unsigned int a = 0; a < countU; a++)
+            {
+                const glm::vec3& control = net[a * countV + b];
+                point += weightsU[a] * control;
+                derivative += derivativesU[a] * control;
+            }
+            row[b] = point;
+            rowDerivative[b] = derivative;
+        }
+
+        float* rowOutput = output + (i - first) * samplesV * s_VertexStride;
+        float* rowFrame = frame ? frame + (i - first) * s_FramePlanes * padded : nullptr;
+        unsigned int j = 0;
+
+#if defined(SIMD_AVX) || defined(SIMD_SSE)
+        alignas(32) float lanes[6][8];
+        for (; j < samplesV; j += s_SimdWidth)
+        {
+            // Position, dS/du and dS/dv of s_SimdWidth samples along v
+#if defined(SIMD_AVX)
+            __m256 px = _mm256_setzero_ps(), py = _mm256_setzero_ps(), pz = _mm256_setzero_ps();
+            __m256 ux = _mm256_setzero_ps(), uy = _mm256_setzero_ps(), uz = _mm256_setzero_ps();
+            __m256 vx = _mm256_setzero_ps(), vy = _mm256_setzero_ps(), vz = _mm256_setzero_ps();
+            for (unsigned int b = 0; b < countV; b++)
+            {
+                __m256 w = _mm256_loadu_ps(&m_WeightsV[b * padded + j]);
+                __m256 d = _mm256_loadu_ps(&m_DerivativesV[b * padded + j]);
+                __m256 rx = _mm256_set1_ps(row[b].x), ry = _mm256_set1_ps(row[b].y), rz = _mm256_set1_ps(row[b].z);
+                px = _mm256_add_ps(px, _mm256_mul_ps(w, rx));
+                py = _mm256_add_ps(py, _mm256_mul_ps(w, ry));
+                pz = _mm256_add_ps(pz, _mm256_mul_ps(w, rz));
+                ux = _mm256_add_ps(ux, _mm256_mul_ps(w, _mm256_set1_ps(rowDerivative[b].x)));
+                uy = _mm256_add_ps(uy, _mm256_mul_ps(w, _mm256_set1_ps(rowDerivative[b].y)));
+                uz = _mm256_add_ps(uz, _mm256_mul_ps(w, _mm256_set1_ps(rowDerivative[b].z)));
+                vx = _mm256_add_ps(vx, _mm256_mul_ps(d, rx));
+                vy = _mm256_add_ps(vy, _mm256_mul_ps(d, ry));
+                vz = _mm256_add_ps(vz, _mm256_mul_ps(d, rz));
+            }
+
+            if (rowFrame)
+            {
+                __m256 values[s_FramePlanes] = { px, py, pz, ux, uy, uz, vx, vy, vz };
+                for (unsigned int plane = 0; plane < s_FramePlanes; plane++)
+                    _mm256_storeu_ps(rowFrame + plane * padded + j, values[plane]);
+            }
+#else
+            __m128 px = _mm_setzero_ps(), py = _mm_setzero_ps(), pz = _mm_setzero_ps();
+            __m128 ux = _mm_setzero_ps(), uy = _mm_setzero_ps(), uz = _mm_setzero_ps();
+            __m128 vx = _mm_setzero_ps(), vy = _mm_setzero_ps(), vz = _mm_setzero_ps();
+            for (unsigned int b = 0; b < countV; b++)
+            {
+                __m128 w = _mm_loadu_ps(&m_WeightsV[b * padded + j]);
+                __m128 d = _mm_loadu_ps(&m_DerivativesV[b * padded + j]);
+                __m128 rx = _mm_set1_ps(row[b].x), ry = _mm_set1_ps(row[b].y), rz = _mm_set1_ps(row[b].z);
+                px = _mm_add_ps(px, _mm_mul_ps(w, rx));
+                py = _mm_add_ps(py, _mm_mul_ps(w, ry));
+                pz = _mm_add_ps(pz, _mm_mul_ps(w, rz));
+                ux = _mm_add_ps(ux, _mm_mul_ps(w, _mm_set1_ps(rowDerivative[b].x)));
+                uy = _mm_add_ps(uy, _mm_mul_ps(w, _mm_set1_ps(rowDerivative[b].y)));
+                uz = _mm_add_ps(uz, _mm_mul_ps(w, _mm_set1_ps(rowDerivative[b].z)));
+                vx = _mm_add_ps(vx, _mm_mul_ps(d, rx));
+                vy = _mm_add_ps(vy, _mm_mul_ps(d, ry));
+                vz = _mm_add_ps(vz, _mm_mul_ps(d, rz));
+            }
+
+            if (rowFrame)
+            {
+                __m128 values[s_FramePlanes] = { px, py, pz, ux, uy, uz, vx, vy, vz };
+                for (unsigned int plane = 0; plane < s_FramePlanes; plane++)
+                    _mm_storeu_ps(rowFrame + plane * padded + j, values[plane]);
+            }
+#endif
+            unsigned int validLanes;
+            if (!StoreVertices(px, py, pz, ux, uy, uz, vx, vy, vz, std::min(s_SimdWidth, samplesV - j), rowOutput + j * s_VertexStride, lanes, validLanes))
+                WriteLanes(net, i, j, lanes, validLanes, rowOutput);
+        }
+#endif
+
+        // Without SIMD
+        for (; j < samplesV; j++)
+        {
+            glm::vec3 point(0.0f), tangentU(0.0f), tangentV(0.0f);
+            for (unsigned int b = 0; b < countV; b++)
+            {
+                float w = m_WeightsV[b * padded + j];
+                float d = m_DerivativesV[b * padded + j];
+                point += w * row[b];
+                tangentU += w * rowDerivative[b];
+                tangentV += d * row[b];
+            }
+
+            if (rowFrame)
+            {
+                glm::vec3 values[3] = { point, tangentU, tangentV };
+                for (unsigned int plane = 0; plane < s_FramePlanes; plane++)
+                    rowFrame[plane * padded + j] = values[plane / 3][plane % 3];
+            }
+            WriteVertex(net, i, j, point, tangentU, tangentV, rowOutput + j * s_VertexStride);
+        }
+    }
+}
+
+void PatchEvaluator::ApplyDeltaRows(const glm::vec3* net, unsigned int i, unsigned int j, const glm::vec3& delta, unsigned int first, unsigned int last, float* frame, float* output) const
+{
+    unsigned int samplesV = m_BasisV.GetResolution() + 1;
+    unsigned int padded = m_PaddedSamplesV;
+    const float* weightsV = &m_WeightsV[j * padded];
+    const float* derivativesV = &m_DerivativesV[j * padded];
+
+    for (unsigned int row = first; row < last; row++)
+    {
+        // Rows where B_i and B_i' vanish still get their vertices rewritten, a degenerate normal
+        // there depends on the second derivatives which do change
+        float weightU = m_BasisU.GetWeights(row)[i];
+        float derivativeU = m_BasisU.GetDerivativeWeights(row)[i];
+        float* rowFrame = frame + (row - first) * s_FramePlanes * padded;
+        float* rowOutput = output + (row - first) * samplesV * s_VertexStride;
+        glm::vec3 scaledPoint = delta * weightU;
+        glm::vec3 scaledTangentU = delta * derivativeU;
+        unsigned int s = 0;
+
+#if defined(SIMD_AVX) || defined(SIMD_SSE)
+        alignas(32) float lanes[6][8];
+        for (; s < samplesV; s += s_SimdWidth)
+        {
+#if defined(SIMD_AVX)
+            __m256 w = _mm256_loadu_ps(weightsV + s);
+            __m256 d = _mm256_loadu_ps(derivativesV + s);
+            __m256 values[s_FramePlanes];
+            for (unsigned int c = 0; c < 3; c++)
+            {
+                float* plane = rowFrame + c * padded + s;
+                values[c] = _mm256_add_ps(_mm256_loadu_ps(plane), _mm256_mul_ps(w, _mm256_set1_ps(scaledPoint[c])));
+                _mm256_storeu_ps(plane, values[c]);
+
+                plane += 3 * padded;
+                values[c + 3] = _mm256_add_ps(_mm256_loadu_ps(plane), _mm256_mul_ps(w, _mm256_set1_ps(scaledTangentU[c])));
+                _mm256_storeu_ps(plane, values[c + 3]);
+
+                plane += 3 * padded;
+                values[c + 6] = _mm256_add_ps(_mm256_loadu_ps(plane), _mm256_mul_ps(d, _mm256_set1_ps(scaledPoint[c])));
+                _mm256_storeu_ps(plane, values[c + 6]);
+            }
+#else
+            __m128 w = _mm_loadu_ps(weightsV + s);
+            __m128 d = _mm_loadu_ps(derivativesV + s);
+            __m128 values[s_FramePlanes];
+            for (unsigned int c = 0; c < 3; c++)
+            {
+                float* plane = rowFrame + c * padded + s;
+                values[c] = _mm_add_ps(_mm_loadu_ps(plane), _mm_mul_ps(w, _mm_set1_ps(scaledPoint[c])));
+                _mm_storeu_ps(plane, values[c]);
+
+                plane += 3 * padded;
+                values[c + 3] = _mm_add_ps(_mm_loadu_ps(plane), _mm_mul_ps(w, _mm_set1_ps(scaledTangentU[c])));
+                _mm_storeu_ps(plane, values[c + 3]);
+
+                plane += 3 * padded;
+                values[c + 6] = _mm_add_ps(_mm_loadu_ps(plane), _mm_mul_ps(d, _mm_set1_ps(scaledPoint[c])));
+                _mm_storeu_ps(plane, values[c + 6]);
+            }
+#endif
+            unsigned int validLanes;
+            if (!StoreVertices(values[0], values[1], values[2], values[3], values[4], values[5], values[6], values[7], values[8],
+                std::min(s_SimdWidth, samplesV - s), rowOutput + s * s_VertexStride, lanes, validLanes))
+                WriteLanes(net, row, s, lanes, validLanes, rowOutput);
+        }
+#endif
+
+        // Without SIMD
+        for (; s < samplesV; s++)
+        {
+            glm::vec3 values[3];
+            for (unsigned int c = 0; c < 3; c++)
+            {
+                float* plane = rowFrame + c * padded + s;
+                values[0][c] = plane[0] += weightsV[s] * scaledPoint[c];
+                values[1][c] = plane[3 * padded] += weightsV[s] * scaledTangentU[c];
+                values[2][c] = plane[6 * padded] += derivativesV[s] * scaledPoint[c];
+            }
+            WriteVertex(net, row, s, values[0], values[1], values[2], rowOutput + s * s_VertexStride);
+        }
+    }
+}
+
+void PatchEvaluator::SetDegenerateNormal(const glm::vec3* net, unsigned int sampleU, unsigned int sampleV, float* vertex) const
+{
+    unsigned int resolutionU = m_BasisU.GetResolution();
+    unsigned int resolutionV = m_BasisV.GetResolution();
+    float u = resolutionU > 0 ? static_cast<float>(sampleU) / resolutionU : 0.0f;
+    float v = resolutionV > 0 ? static_cast<float>(sampleV) / resolutionV : 0.0f;
+
+    glm::vec3 normal = EvaluatePoint(net, m_BasisU.GetDegree() + 1, m_BasisV.GetDegree() + 1, u, v).Normal;
+    vertex[3] = normal.x;
+    vertex[4] = normal.y;
+    vertex[5] = normal.z;
+}
+
+// buffer holds 4 * size points, size >= countU, countV. Inlined into EvaluatePoint, once with
+// the bicubic counts as constants so the loops unroll
+static inline SurfaceSample EvaluatePatchPoint(const glm::vec3* net, unsigned int countU, unsigned int countV, float u, float v, glm::vec3* buffer, unsigned int size)
+{
+    // Every v column reduced at u to its point and u derivatives, then those three curves at v
+    glm::vec3* column = buffer;
+    glm::vec3* points = buffer + size;
+    glm::vec3* derivativesU = buffer + 2 * size;
+    glm::vec3* secondDerivativesU = buffer + 3 * size;
+
+    for (unsigned int b = 0; b < countV; b++)
+    {
+        for (unsigned int a = 0; a < countU; a++)
+            column[a] = net[a * countV + b];
+        EvaluateBezierDerivativesInPlace(column, countU, u, points[b], derivativesU[b], secondDerivativesU[b]);
+    }
+
+    // The three curves are scratch as well, the second u derivative only needs its point
+    SurfaceSample sample;
+    glm::vec3 secondV, mixed, unused;
+    EvaluateBezierDerivativesInPlace(points, countV, v, sample.Point, sample.TangentV, secondV);
+    EvaluateBezierDerivativesInPlace(derivativesU, countV, v, sample.TangentU, mixed, unused);
+    glm::vec3 secondU = DeCasteljauInPlace(secondDerivativesU, countV, v);
+
+    glm::vec3 normal = glm::cross(sample.TangentU, sample.TangentV);
+    float lengthSquared = glm::dot(normal, normal);
+    if (lengthSquared <= s_MinNormalLength * s_MinNormalLength)
+    {
+        // First order change of the normal a small step towards the inside of the patch
+        float stepU = u < 0.5f ? 1.0f : -1.0f;
+        float stepV = v < 0.5f ? 1.0f : -1.0f;
+        normal = stepU * (glm::cross(secondU, sample.TangentV) + glm::cross(sample.TangentU, mixed)) +
+            stepV * (glm::cross(mixed, sample.TangentV) + glm::cross(sample.TangentU, secondV));
+        lengthSquared = glm::dot(normal, normal);
+    }
+
+    sample.Normal = lengthSquared > 0.0f ? normal * glm::inversesqrt(lengthSquared) : glm::vec3(0.0f, 0.0f, 1.0f);
+    return sample;
+}
+
+SurfaceSample PatchEvaluator::EvaluatePoint(const glm::vec3* net, unsigned int countU, unsigned int countV, float u, float v)
+{
+    unsigned int size = std::max(countU, countV);
+    if (size > s_MaxStackControlPoints)
+    {
+        std::vector<glm::vec3> buffer(4 * size);
+        return EvaluatePatchPoint(net, countU, countV, u, v, buffer.data(), size);
+    }
+
+    glm::vec3 buffer[4 * s_MaxStackControlPoints];
+    if (countU == 4 && countV == 4)
+        return EvaluatePatchPoint(net, 4, 4, u, v, buffer, 4);
+    return EvaluatePatchPoint(net, countU, countV, u, v, buffer, s_MaxStackControlPoints);
+}
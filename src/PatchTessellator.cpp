@@ -0,0 +1,325 @@
+#include "PatchTessellator.h"
+#include "PatchEvaluator.h"
+#include "BezierEvaluation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+// Below this many vertices the threads cost more than they save
+static const unsigned int s_ParallelThreshold = 16384;
+
+// Patches a worker takes from the shared counter at a time
+static const unsigned int s_PatchBlock = 8;
+
+static const unsigned int s_ControlPointsPerPatch = 16;
+
+// Control point indices of the four sides, in the direction of the patch parameter
+static const unsigned int s_SidePoints[4][4] = {
+    { 0, 1, 2, 3 },    // u = 0, along v
+    { 12, 13, 14, 15 },// u = 1, along v
+    { 0, 4, 8, 12 },   // v = 0, along u
+    { 3, 7, 11, 15 }   // v = 1, along u
+};
+
+// Control point of each corner, (u, v) = (0, 0), (0, 1), (1, 0), (1, 1)
+static const unsigned int s_CornerPoints[4] = { 0, 3, 12, 15 };
+
+static bool LessPosition(const glm::vec3& a, const glm::vec3& b)
+{
+    if (a.x != b.x)
+        return a.x < b.x;
+    if (a.y != b.y)
+        return a.y < b.y;
+    return a.z < b.z;
+}
+
+PatchTessellator::PatchTessellator()
+    : m_VertexCount(0), m_IndexCount(0)
+{
+}
+
+PatchTessellator::~PatchTessellator()
+{
+}
+
+void PatchTessellator::Tessellate(const glm::vec3* controlPoints, unsigned int patchCount, float tolerance, unsigned int maxResolution,
+    std::vector<float>& vertices, std::vector<unsigned int>& indices, bool parallel)
+{
+    BuildTopology(controlPoints, patchCount);
+    ChooseResolutions(controlPoints, patchCount, tolerance, std::max(1u, maxResolution));
+    AssignVertices();
+
+    vertices.resize(m_VertexCount * PatchEvaluator::s_VertexStride);
+    indices.resize(m_IndexCount);
+    if (patchCount == 0)
+        return;
+
+    unsigned int threadCount = std::max(1u, std::thread::hardware_concurrency());
+    if (!parallel || m_VertexCount < s_ParallelThreshold || threadCount == 1)
+    {
+        TessellatePatches(controlPoints, 0, patchCount, vertices.data(), indices.data());
+        return;
+    }
+
+    // Patch sizes vary, so workers keep pulling small blocks until none are left
+    std::atomic<unsigned int> nextPatch(0);
+    float* vertexData = vertices.data();
+    unsigned int* indexData = indices.data();
+    auto worker = [&]()
+    {
+        for (;;)
+        {
+            unsigned int first = nextPatch.fetch_add(s_PatchBlock);
+            if (first >= patchCount)
+                return;
+            TessellatePatches(controlPoints, first, std::min(first + s_PatchBlock, patchCount), vertexData, indexData);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < threadCount; t++)
+        threads.emplace_back(worker);
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+void PatchTessellator::BuildTopology(const glm::vec3* controlPoints, unsigned int patchCount)
+{
+    m_Patches.assign(patchCount, PatchLayout());
+
+    // Corners with the same position are one vertex, the lowest patch evaluates it
+    m_CornerRecords.resize(patchCount * 4);
+    for (unsigned int p = 0; p < patchCount; p++)
+    {
+        for (unsigned int c = 0; c < 4; c++)
+            m_CornerRecords[p * 4 + c] = { controlPoints[p * s_ControlPointsPerPatch + s_CornerPoints[c]], p * 4 + c };
+    }
+    std::sort(m_CornerRecords.begin(), m_CornerRecords.end(), [](const CornerRecord& a, const CornerRecord& b)
+    {
+        if (a.Position != b.Position)
+            return LessPosition(a.Position, b.Position);
+        return a.Corner < b.Corner;
+    });
+
+    m_CornerOwners.clear();
+    for (unsigned int r = 0; r < m_CornerRecords.size(); r++)
+    {
+        const CornerRecord& record = m_CornerRecords[r];
+        if (r == 0 || record.Position != m_CornerRecords[r - 1].Position)
+            m_CornerOwners.push_back(record.Corner / 4);
+        m_Patches[record.Corner / 4].Corners[record.Corner % 4] = m_CornerOwners.size() - 1;
+    }
+
+    // Edges with the same control points, in either direction, are one edge
+    m_EdgeRecords.resize(patchCount * 4);
+    for (unsigned int p = 0; p < patchCount; p++)
+    {
+        const glm::vec3* patch = controlPoints + p * s_ControlPointsPerPatch;
+        for (unsigned int side = 0; side < 4; side++)
+        {
+            float forward[12], backward[12];
+            for (unsigned int k = 0; k < 4; k++)
+            {
+                const glm::vec3& point = patch[s_SidePoints[side][k]];
+                const glm::vec3& opposite = patch[s_SidePoints[side][3 - k]];
+                for (unsigned int c = 0; c < 3; c++)
+                {
+                    forward[k * 3 + c] = point[c];
+                    backward[k * 3 + c] = opposite[c];
+                }
+            }
+
+            EdgeRecord& record = m_EdgeRecords[p * 4 + side];
+            record.Edge = p * 4 + side;
+            record.Reversed = std::lexicographical_compare(backward, backward + 12, forward, forward + 12);
+            std::copy(record.Reversed ? backward : forward, (record.Reversed ? backward : forward) + 12, record.Key);
+        }
+    }
+    auto sameKey = [](const EdgeRecord& a, const EdgeRecord& b) { return std::equal(a.Key, a.Key + 12, b.Key); };
+    std::sort(m_EdgeRecords.begin(), m_EdgeRecords.end(), [](const EdgeRecord& a, const EdgeRecord& b)
+    {
+        if (!std::equal(a.Key, a.Key + 12, b.Key))
+            return std::lexicographical_compare(a.Key, a.Key + 12, b.Key, b.Key + 12);
+        return a.Edge < b.Edge;
+    });
+
+    m_EdgeOwners.clear();
+    for (unsigned int r = 0; r < m_EdgeRecords.size(); r++)
+    {
+        const EdgeRecord& record = m_EdgeRecords[r];
+        if (r == 0 || !sameKey(record, m_EdgeRecords[r - 1]))
+            m_EdgeOwners.push_back(record.Edge / 4);
+        m_Patches[record.Edge / 4].Edges[record.Edge % 4] = { (unsigned int)m_EdgeOwners.size() - 1, record.Reversed };
+    }
+}
+
+unsigned int PatchTessellator::FindRoot(unsigned int edge)
+{
+    while (m_Parents[edge] != edge)
+    {
+        m_Parents[edge] = m_Parents[m_Parents[edge]];
+        edge = m_Parents[edge];
+    }
+    return edge;
+}
+
+void PatchTessellator::ChooseResolutions(const glm::vec3* controlPoints, unsigned int patchCount, float tolerance, unsigned int maxResolution)
+{
+    // Opposite edges of a patch share its resolution, so they join one set
+    unsigned int edgeCount = m_EdgeOwners.size();
+    m_Parents.resize(edgeCount);
+    for (unsigned int e = 0; e < edgeCount; e++)
+        m_Parents[e] = e;
+    for (const PatchLayout& patch : m_Patches)
+    {
+        m_Parents[FindRoot(patch.Edges[1].Edge)] = FindRoot(patch.Edges[0].Edge);
+        m_Parents[FindRoot(patch.Edges[3].Edge)] = FindRoot(patch.Edges[2].Edge);
+    }
+
+    // Every set takes the finest resolution any of its patches asks for
+    std::vector<unsigned int> setResolutions(edgeCount, 1);
+    for (unsigned int p = 0; p < patchCount; p++)
+    {
+        const glm::vec3* patch = controlPoints + p * s_ControlPointsPerPatch;
+        unsigned int resolutionU = 1, resolutionV = 1;
+        for (unsigned int k = 0; k < 4; k++)
+        {
+            glm::vec3 column[4] = { patch[k], patch[4 + k], patch[8 + k], patch[12 + k] };
+            resolutionU = std::max(resolutionU, EstimateSegmentCount(column, 4, tolerance));
+            resolutionV = std::max(resolutionV, EstimateSegmentCount(patch + k * 4, 4, tolerance));
+        }
+
+        unsigned int& setV = setResolutions[FindRoot(m_Patches[p].Edges[0].Edge)];
+        unsigned int& setU = setResolutions[FindRoot(m_Patches[p].Edges[2].Edge)];
+        setV = std::max(setV, std::min(resolutionV, maxResolution));
+        setU = std::max(setU, std::min(resolutionU, maxResolution));
+    }
+
+    m_EdgeResolutions.resize(edgeCount);
+    for (unsigned int e = 0; e < edgeCount; e++)
+        m_EdgeResolutions[e] = setResolutions[FindRoot(e)];
+    for (PatchLayout& patch : m_Patches)
+    {
+        patch.ResolutionV = m_EdgeResolutions[patch.Edges[0].Edge];
+        patch.ResolutionU = m_EdgeResolutions[patch.Edges[2].Edge];
+    }
+}
+
+void PatchTessellator::AssignVertices()
+{
+    // Corners first, then the inner samples of every edge, then the inside of every patch
+    unsigned int vertexCount = m_CornerOwners.size();
+    m_EdgeFirstVertex.resize(m_EdgeResolutions.size());
+    for (unsigned int e = 0; e < m_EdgeResolutions.size(); e++)
+    {
+        m_EdgeFirstVertex[e] = vertexCount;
+        vertexCount += m_EdgeResolutions[e] - 1;
+    }
+
+    // Tables for each resolution pair, kept between calls
+    unsigned int evaluatorCount = 0;
+    unsigned int indexCount = 0;
+    for (PatchLayout& patch : m_Patches)
+    {
+        patch.Evaluator = 0;
+        while (patch.Evaluator < evaluatorCount && (m_Evaluators[patch.Evaluator].GetResolutionU() != patch.ResolutionU ||
+            m_Evaluators[patch.Evaluator].GetResolutionV() != patch.ResolutionV))
+            patch.Evaluator++;
+        if (patch.Evaluator == evaluatorCount)
+        {
+            if (evaluatorCount == m_Evaluators.size())
+                m_Evaluators.emplace_back();
+            m_Evaluators[evaluatorCount++].Build(3, 3, patch.ResolutionU, patch.ResolutionV);
+        }
+
+        patch.FirstInterior = vertexCount;
+        patch.FirstIndex = indexCount;
+        vertexCount += (patch.ResolutionU - 1) * (patch.ResolutionV - 1);
+        indexCount += patch.ResolutionU * patch.ResolutionV * 6;
+    }
+
+    m_VertexCount = vertexCount;
+    m_IndexCount = indexCount;
+}
+
+unsigned int PatchTessellator::GetVertexId(const PatchLayout& patch, unsigned int a, unsigned int b) const
+{
+    unsigned int resolutionU = patch.ResolutionU;
+    unsigned int resolutionV = patch.ResolutionV;
+    if (a == 0 || a == resolutionU)
+    {
+        if (b == 0 || b == resolutionV)
+            return patch.Corners[(a == 0 ? 0 : 2) + (b == 0 ? 0 : 1)];
+
+        const PatchEdge& edge = patch.Edges[a == 0 ? 0 : 1];
+        return m_EdgeFirstVertex[edge.Edge] + (edge.Reversed ? resolutionV - b : b) - 1;
+    }
+    if (b == 0 || b == resolutionV)
+    {
+        const PatchEdge& edge = patch.Edges[b == 0 ? 2 : 3];
+        return m_EdgeFirstVertex[edge.Edge] + (edge.Reversed ? resolutionU - a : a) - 1;
+    }
+    return patch.FirstInterior + (a - 1) * (resolutionV - 1) + (b - 1);
+}
+
+bool PatchTessellator::OwnsVertex(unsigned int patchIndex, unsigned int a, unsigned int b) const
+{
+    const PatchLayout& patch = m_Patches[patchIndex];
+    bool edgeU = a == 0 || a == patch.ResolutionU;
+    bool edgeV = b == 0 || b == patch.ResolutionV;
+    if (edgeU && edgeV)
+        return m_CornerOwners[patch.Corners[(a == 0 ? 0 : 2) + (b == 0 ? 0 : 1)]] == patchIndex;
+    if (edgeU)
+        return m_EdgeOwners[patch.Edges[a == 0 ? 0 : 1].Edge] == patchIndex;
+    if (edgeV)
+        return m_EdgeOwners[patch.Edges[b == 0 ? 2 : 3].Edge] == patchIndex;
+    return true;
+}
+
+void PatchTessellator::TessellatePatches(const glm::vec3* controlPoints, unsigned int first, unsigned int last, float* vertices, unsigned int* indices) const
+{
+    std::vector<float> grid;
+    std::vector<unsigned int> ids;
+
+    for (unsigned int p = first; p < last; p++)
+    {
+        const PatchLayout& patch = m_Patches[p];
+        unsigned int samplesU = patch.ResolutionU + 1;
+        unsigned int samplesV = patch.ResolutionV + 1;
+
+        const PatchEvaluator& evaluator = m_Evaluators[patch.Evaluator];
+        grid.resize(evaluator.GetVertexCount() * PatchEvaluator::s_VertexStride);
+        evaluator.Evaluate(controlPoints + p * s_ControlPointsPerPatch, grid.data(), false);
+
+        // Shared samples are written by their owner only, every patch agrees on where they are
+        ids.resize(samplesU * samplesV);
+        for (unsigned int a = 0; a < samplesU; a++)
+        {
+            for (unsigned int b = 0; b < samplesV; b++)
+            {
+                unsigned int id = GetVertexId(patch, a, b);
+                ids[a * samplesV + b] = id;
+                if (OwnsVertex(p, a, b))
+                    std::copy_n(&grid[(a * samplesV + b) * PatchEvaluator::s_VertexStride], PatchEvaluator::s_VertexStride, vertices + id * PatchEvaluator::s_VertexStride);
+            }
+        }
+
+        // Same triangle order and winding as BezierSurface::Generate
+        unsigned int* index = indices + patch.FirstIndex;
+        for (unsigned int a = 0; a < patch.ResolutionU; a++)
+        {
+            for (unsigned int b = 0; b < patch.ResolutionV; b++)
+            {
+                unsigned int p0 = ids[a * samplesV + b];
+                unsigned int p1 = ids[a * samplesV + b + 1];
+                unsigned int p2 = ids[(a + 1) * samplesV + b];
+                unsigned int p3 = ids[(a + 1) * samplesV + b + 1];
+                *index++ = p0; *index++ = p2; *index++ = p1;
+                *index++ = p1; *index++ = p2; *index++ = p3;
+            }
+        }
+    }
+}
+
@@ -1,8 +1,10 @@
 #include "RayTracer.h"
 #include "Renderer.h"
 #include "Sphere.h"
+#include "BezierSurface.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
+#include <cmath>
 
 RayTracer::RayTracer(Camera& camera)
     : m_Camera(camera), m_ShowRay(false), m_CurrentRay(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f)),
@@ -46,6 +48,34 @@ Ray RayTracer::GenerateRay(float screenX, float screenY, int screenWidth, int sc
     return Ray(m_Camera.GetPosition(), direction);
 }
 
+bool RayTracer::PickControlPoint(const BezierSurface& surface, float screenX, float screenY, int screenWidth, int screenHeight,
+    float radiusPixels, unsigned int& i, unsigned int& j)
+{
+    // A pixel spans 2 tan(fov / 2) / screenHeight at distance 1
+    float slope = radiusPixels * 2.0f * std::tan(glm::radians(m_Camera.GetZoom()) * 0.5f) / screenHeight;
+    return surface.PickControlPoint(GenerateRay(screenX, screenY, screenWidth, screenHeight), slope, i, j);
+}
+
+void RayTracer::SelectControlPoints(const BezierSurface& surface, const glm::mat4& projection, const glm::vec2& corner0,
+    const glm::vec2& corner1, int screenWidth, int screenHeight, std::vector<unsigned int>& selected)
+{
+    // Rectangle in normalized device coordinates, flipped in y like GenerateRay
+    glm::vec2 ndc0 = glm::vec2(2.0f * corner0.x / screenWidth - 1.0f, 1.0f - 2.0f * corner0.y / screenHeight);
+    glm::vec2 ndc1 = glm::vec2(2.0f * corner1.x / screenWidth - 1.0f, 1.0f - 2.0f * corner1.y / screenHeight);
+    glm::vec2 low = glm::min(ndc0, ndc1);
+    glm::vec2 high = glm::max(ndc0, ndc1);
+    if (high.x - low.x < 1e-6f || high.y - low.y < 1e-6f)
+    {
+        selected.clear();
+        return;
+    }
+
+    // Pick matrix, stretches the rectangle over the whole clip volume
+    glm::mat4 pick = glm::scale(glm::mat4(1.0f), glm::vec3(2.0f / (high.x - low.x), 2.0f / (high.y - low.y), 1.0f)) *
+        glm::translate(glm::mat4(1.0f), glm::vec3(-(low + high) * 0.5f, 0.0f));
+    surface.SelectControlPoints(pick * projection * m_Camera.GetViewMatrix(), selected);
+}
+
 void RayTracer::SetCurrentRay(const Ray& ray)
 {
     m_CurrentRay = ray;
@@ -37,7 +37,21 @@ void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib, const Shader&
     va.Bind();
     ib.Bind();
 
-    GLCall(glDrawElements(GL_TRIANGLES, ib.GetCount(), GL_UNSIGNED_INT, nullptr));
+    GLCall(glDrawElements(GL_TRIANGLES, ib.GetCount(), ib.GetType(), nullptr));
+}
+
+void Renderer::DrawStrips(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const {
+    shader.Bind();
+    va.Bind();
+    ib.Bind();
+
+    // The max index of the type restarts the strip, one call for any number of strokes. Core since
+    // GL 3.1, unlike GL_PRIMITIVE_RESTART_FIXED_INDEX (4.3)
+    unsigned int restartIndex = ib.GetType() == GL_UNSIGNED_SHORT ? 0xFFFF : 0xFFFFFFFF;
+    GLCall(glEnable(GL_PRIMITIVE_RESTART));
+    GLCall(glPrimitiveRestartIndex(restartIndex));
+    GLCall(glDrawElements(GL_TRIANGLE_STRIP, ib.GetCount(), ib.GetType(), nullptr));
+    GLCall(glDisable(GL_PRIMITIVE_RESTART));
 }
 
 // Added this method to set the clear color
@@ -2,20 +2,124 @@
 #include<iostream>
 #include <fstream>
 #include <sstream>
+#include <chrono>
 
 
 #include "Shader.h"
 #include "Renderer.h"
+#include "ShaderCache.h"
 
 
 
-Shader::Shader(const std::string& filename)
-    :m_FilePath(filename), m_RendererID(0)
+// Nested #include levels before the file is taken for a cycle
+static const unsigned int s_MaxIncludeDepth = 16;
+
+// Path up to and including the last separator
+static std::string GetDirectory(const std::string& filePath) {
+    size_t slash = filePath.find_last_of("/\\");
+    return slash == std::string::npos ? std::string() : filePath.substr(0, slash + 1);
+}
+
+// File of an #include "file" line, empty for any other line
+static std::string GetIncludeName(const std::string& line) {
+    size_t start = line.find_first_not_of(" \t");
+    if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
+        return std::string();
+
+    size_t open = line.find('"', start + 8);
+    size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+    if (close == std::string::npos)
+        return std::string();
+    return line.substr(open + 1, close - open - 1);
+}
+
+// Lines of an included file, its own includes resolved relative to it
+static void AppendInclude(const std::string& filePath, std::stringstream& out, unsigned int depth) {
+    if (depth > s_MaxIncludeDepth) {
+        std::cout << "Shader include nested too deep (cycle?) at " << filePath << std::endl;
+        return;
+    }
+
+    std::ifstream stream(filePath);
+    if (!stream) {
+        std::cout << "Failed to open shader include " << filePath << std::endl;
+        return;
+    }
+
+    std::string line;
+    while (getline(stream, line)) {
+        std::string include = GetIncludeName(line);
+        if (include.empty())
+            out << line << '\n';
+        else
+            AppendInclude(GetDirectory(filePath) + include, out, depth + 1);
+    }
+}
+
+static std::string FormatDefines(const ShaderDefines& defines) {
+    std::string block;
+    for (const auto& define : defines)
+        block += "#define " + define.first + " " + (define.second.empty() ? "1" : define.second) + "\n";
+    return block;
+}
+
+// The defines go right after #version, which has to stay the first line
+static std::string InjectDefines(const std::string& source, const std::string& defines) {
+    if (source.empty() || defines.empty())
+        return source;
+
+    size_t version = source.find("#version");
+    size_t lineEnd = version == std::string::npos ? std::string::npos : source.find('\n', version);
+    if (lineEnd == std::string::npos)
+        return defines + source;
+    return source.substr(0, lineEnd + 1) + defines + source.substr(lineEnd + 1);
+}
+
+Shader::Shader(const std::string& filename, const ShaderDefines& defines)
+    :m_FilePath(filename), m_Defines(defines), m_RendererID(0)
 {
+    auto start = std::chrono::high_resolution_clock::now();
+
     // Use the provided filename instead of hardcoding it
     ShaderProgramSource source = parseShader(filename);
-    m_RendererID = CreateShader(source.VertexSource, source.FragmentSource);
 
+    // Linked binary from an earlier run when the sources and driver are unchanged
+    ShaderCache& cache = ShaderCache::Get();
+    std::string key = cache.MakeKey(source, FormatDefines(m_Defines));
+    m_RendererID = cache.Load(key);
+    bool hit = m_RendererID != 0;
+    if (!hit) {
+        m_RendererID = CreateShader(source);
+        cache.Store(key, m_RendererID);
+    }
+
+    std::string name = filename;
+    for (const auto& define : m_Defines)
+        name += " " + define.first + "=" + define.second;
+
+    auto end = std::chrono::high_resolution_clock::now();
+    cache.Record(name, hit, std::chrono::duration<double, std::milli>(end - start).count());
+}
+
+std::shared_ptr<Shader> Shader::GetVariant(const std::string& filename, const ShaderDefines& defines) {
+    // Weak references, a variant lives as long as one caller uses it
+    static std::unordered_map<std::string, std::weak_ptr<Shader>> s_Variants;
+
+    // Variants nobody uses any more are dropped, the map only holds live ones
+    for (auto it = s_Variants.begin(); it != s_Variants.end();) {
+        if (it->second.expired())
+            it = s_Variants.erase(it);
+        else
+            ++it;
+    }
+
+    std::string key = filename + "\n" + FormatDefines(defines);
+    std::shared_ptr<Shader> shader = s_Variants[key].lock();
+    if (!shader) {
+        shader = std::make_shared<Shader>(filename, defines);
+        s_Variants[key] = shader;
+    }
+    return shader;
 }
 
 Shader::~Shader()
@@ -29,18 +133,21 @@ Shader::~Shader()
  *
  * This parsing is very basic and holde true for our simple exemples
  * where the two shaders are separated by the line #shader vertex or #sahder fragment to get the right one
+ * Tessellation stages go under #shader tess_control and #shader tess_evaluation
+ * #include "file" lines are replaced by the file (relative to the including one) and the
+ * defines of this program are added after the #version line of every stage
  *
  * @param filePatch, the path to the file holding the two shders.
- * @return ShaderProgramSource holding both code source of both Shaders
+ * @return ShaderProgramSource holding the code source of every Shader
  */
 ShaderProgramSource Shader::parseShader(const std::string& filePath) {
     std::ifstream stream(filePath);
     enum class ShaderType {
-        NONE = -1, VERTEX = 0, FRAGMENT = 1
+        NONE = -1, VERTEX = 0, FRAGMENT = 1, TESS_CONTROL = 2, TESS_EVALUATION = 3
     };
 
     std::string line;
-    std::stringstream ss[2];
+    std::stringstream ss[4];
     ShaderType type = ShaderType::NONE;
 
     while (getline(stream, line)) {
@@ -49,14 +156,23 @@ ShaderProgramSource Shader::parseShader(const std::string& filePath) {
                 type = ShaderType::VERTEX;
             else if (line.find("fragment") != std::string::npos)
                 type = ShaderType::FRAGMENT;
+            else if (line.find("tess_control") != std::string::npos)
+                type = ShaderType::TESS_CONTROL;
+            else if (line.find("tess_evaluation") != std::string::npos)
+                type = ShaderType::TESS_EVALUATION;
         }
-        else {
-            if (type != ShaderType::NONE)
+        else if (type != ShaderType::NONE) {
+            std::string include = GetIncludeName(line);
+            if (include.empty())
                 ss[(int)type] << line << '\n';
+            else
+                AppendInclude(GetDirectory(filePath) + include, ss[(int)type], 1);
         }
     }
 
-    return { ss[0].str(), ss[1].str() };
+    std::string defines = FormatDefines(m_Defines);
+    return { InjectDefines(ss[0].str(), defines), InjectDefines(ss[1].str(), defines),
+        InjectDefines(ss[2].str(), defines), InjectDefines(ss[3].str(), defines) };
 }
 
 /**
@@ -81,7 +197,9 @@ unsigned int Shader::CompileShader(unsigned int type, std::string& source) {
         glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
         char* message = (char*)alloca(length * sizeof(char));
         glGetShaderInfoLog(id, length, &length, message);
-        std::cout << "Failed to compile " << (type == GL_VERTEX_SHADER ? "vertex" : "fragment") << "shader" << std::endl;
+        const char* stage = type == GL_VERTEX_SHADER ? "vertex" : type == GL_FRAGMENT_SHADER ? "fragment" :
+            type == GL_TESS_CONTROL_SHADER ? "tessellation control" : "tessellation evaluation";
+        std::cout << "Failed to compile " << stage << " shader" << std::endl;
         std::cout << message << std::endl;
         glDeleteShader(id);
         return 0;
@@ -96,19 +214,38 @@ unsigned int Shader::CompileShader(unsigned int type, std::string& source) {
  * @param values Container whose values are summed.
  * @return sum of `values`, or 0.0 if `values` is empty.
  */
-int Shader::CreateShader(std::string& vetrexShader, std::string fragementShader) {
+int Shader::CreateShader(ShaderProgramSource& source) {
     unsigned int program = glCreateProgram();
-    unsigned int vs = CompileShader(GL_VERTEX_SHADER, vetrexShader);
-    unsigned int fs = CompileShader(GL_FRAGMENT_SHADER, fragementShader);
+    unsigned int vs = CompileShader(GL_VERTEX_SHADER, source.VertexSource);
+    unsigned int fs = CompileShader(GL_FRAGMENT_SHADER, source.FragmentSource);
 
     glAttachShader(program, vs);
     glAttachShader(program, fs);
 
+    // Tessellation stages only when the file has them
+    unsigned int tcs = 0, tes = 0;
+    if (!source.TessControlSource.empty()) {
+        tcs = CompileShader(GL_TESS_CONTROL_SHADER, source.TessControlSource);
+        glAttachShader(program, tcs);
+    }
+    if (!source.TessEvaluationSource.empty()) {
+        tes = CompileShader(GL_TESS_EVALUATION_SHADER, source.TessEvaluationSource);
+        glAttachShader(program, tes);
+    }
+
+    // Lets ShaderCache read the linked binary back
+    if (GLAD_GL_VERSION_4_1)
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
     glLinkProgram(program);
     glValidateProgram(program);
 
     glDeleteShader(vs);
     glDeleteShader(fs);
+    if (tcs)
+        glDeleteShader(tcs);
+    if (tes)
+        glDeleteShader(tes);
 
     return program;
 }
@@ -0,0 +1,179 @@
+#include "ShaderCache.h"
+#include "Renderer.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// File layout: magic, binary format, key length, binary length, key, binary
+static const uint32_t s_Magic = 0x43425053; // "SPBC"
+
+// FNV-1a, only names the file, the key inside it is compared in full
+static uint64_t HashKey(const std::string& key)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : key)
+    {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static void MakeDirectory(const std::string& directory)
+{
+#ifdef _WIN32
+    _mkdir(directory.c_str());
+#else
+    mkdir(directory.c_str(), 0755);
+#endif
+}
+
+ShaderCache::ShaderCache()
+    : m_Directory("shader_cache"), m_Rejected(0), m_Enabled(true)
+{
+}
+
+ShaderCache& ShaderCache::Get()
+{
+    static ShaderCache s_Instance;
+    return s_Instance;
+}
+
+bool ShaderCache::IsSupported() const
+{
+    if (!m_Enabled || !GLAD_GL_VERSION_4_1)
+        return false;
+
+    int formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    return formatCount > 0;
+}
+
+std::string ShaderCache::MakeKey(const ShaderProgramSource& source, const std::string& defines)
+{
+    if (m_Driver.empty())
+    {
+        const char* vendor = (const char*)glGetString(GL_VENDOR);
+        const char* renderer = (const char*)glGetString(GL_RENDERER);
+        const char* version = (const char*)glGetString(GL_VERSION);
+        m_Driver = std::string(vendor ? vendor : "") + '\n' + (renderer ? renderer : "") + '\n' + (version ? version : "");
+    }
+
+    // Stage markers keep a line moving between stages from giving the same key
+    return m_Driver + "\n#defines\n" + defines + "\n#vertex\n" + source.VertexSource + "#fragment\n" + source.FragmentSource +
+        "#tess_control\n" + source.TessControlSource + "#tess_evaluation\n" + source.TessEvaluationSource;
+}
+
+std::string ShaderCache::GetCachePath(const std::string& key) const
+{
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long)HashKey(key));
+    return m_Directory + "/" + name + ".bin";
+}
+
+unsigned int ShaderCache::Load(const std::string& key)
+{
+    if (!IsSupported())
+        return 0;
+
+    std::string path = GetCachePath(key);
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream)
+        return 0;
+
+    stream.seekg(0, std::ios::end);
+    unsigned long long fileSize = (unsigned long long)stream.tellg();
+    stream.seekg(0, std::ios::beg);
+
+    // Lengths come from the file, a truncated or garbled one must not size an allocation
+    uint32_t header[4];
+    if (!stream.read((char*)header, sizeof(header)) || header[0] != s_Magic || header[3] == 0 ||
+        sizeof(header) + (unsigned long long)header[2] + header[3] != fileSize)
+    {
+        stream.close();
+        std::remove(path.c_str());
+        return 0;
+    }
+    if (header[2] != key.size())
+        return 0;
+
+    std::string storedKey(header[2], '\0');
+    std::vector<char> binary(header[3]);
+    if (!stream.read(&storedKey[0], storedKey.size()) || storedKey != key || !stream.read(binary.data(), binary.size()))
+        return 0;
+
+    // A refused binary is a GL error on some drivers and only a failed link on others
+    unsigned int program = glCreateProgram();
+    GLClearError();
+    glProgramBinary(program, header[1], binary.data(), binary.size());
+    int linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    GLClearError();
+    if (linked == GL_FALSE)
+    {
+        std::cout << "[Shader cache] driver rejected " << path << ", compiling from source" << std::endl;
+        glDeleteProgram(program);
+        std::remove(path.c_str());
+        m_Rejected++;
+        return 0;
+    }
+    return program;
+}
+
+void ShaderCache::Store(const std::string& key, unsigned int program)
+{
+    if (!IsSupported())
+        return;
+
+    int linked = GL_FALSE, length = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (linked == GL_FALSE || length <= 0)
+        return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    GLCall(glGetProgramBinary(program, length, &length, &format, binary.data()));
+
+    MakeDirectory(m_Directory);
+    std::string path = GetCachePath(key);
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if (!stream)
+    {
+        std::cout << "[Shader cache] cannot write " << path << std::endl;
+        return;
+    }
+
+    uint32_t header[4] = { s_Magic, format, (uint32_t)key.size(), (uint32_t)length };
+    stream.write((const char*)header, sizeof(header));
+    stream.write(key.data(), key.size());
+    stream.write(binary.data(), length);
+}
+
+void ShaderCache::Record(const std::string& filePath, bool hit, double milliseconds)
+{
+    m_Entries.push_back({ filePath, hit, milliseconds });
+}
+
+void ShaderCache::PrintReport() const
+{
+    unsigned int hits = 0;
+    double hitTime = 0.0, missTime = 0.0;
+    for (const Entry& entry : m_Entries)
+    {
+        std::cout << "[Shader cache] " << (entry.Hit ? "hit  " : "miss ") << entry.FilePath << " " << entry.Milliseconds << " ms" << std::endl;
+        hits += entry.Hit ? 1 : 0;
+        (entry.Hit ? hitTime : missTime) += entry.Milliseconds;
+    }
+
+    std::cout << "[Shader cache] " << hits << " hits (" << hitTime << " ms), " << m_Entries.size() - hits << " misses (" << missTime
+        << " ms), " << m_Rejected << " rejected" << (IsSupported() ? "" : ", program binaries not supported") << std::endl;
+}
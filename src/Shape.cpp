@@ -1,11 +1,28 @@
 #include "Shape.h"
 #include "Renderer.h"
+#include "MeshCache.h"
+#include <algorithm>
+#include <cmath>
+
+// A coarser level is only picked once its error is this far under the threshold, avoids popping back and forth
+static const float s_LODHysteresis = 0.75f;
 
 Shape::Shape()
     : m_Position(0.0f, 0.0f, 0.0f),
     m_Rotation(0.0f, 0.0f, 0.0f),
     m_Scale(1.0f, 1.0f, 1.0f),
-    m_WireframeMode(false)
+    m_MeshScale(1.0f, 1.0f, 1.0f),
+    m_WireframeMode(false),
+    m_VertexFormat(VertexFormat::Float),
+    m_OptimizeMesh(false),
+    m_OptimizationReport(),
+    m_LODLevelCount(0),
+    m_CurrentLOD(0),
+    m_WorldCenter(0.0f),
+    m_WorldExtents(0.0f),
+    m_WorldRadius(0.0f),
+    m_WorldBoundsDirty(true),
+    m_WorldBoundsMesh(nullptr)
 {
 }
 
@@ -18,33 +35,140 @@ void Shape::SetupMesh()
     if (m_Vertices.empty() || m_Indices.empty())
         return;
 
-    // Create vertex array and buffer
-    m_VAO = std::make_unique<VertexArray>();
-    m_VBO = std::make_unique<VertexBuffer>(m_Vertices.data(), m_Vertices.size() * sizeof(float));
+    if (m_OptimizeMesh)
+        m_OptimizationReport = OptimizeMesh(m_Vertices, m_Indices, 6);
+
+    // The mesh takes over the CPU copy so a shared mesh only exists once in memory
+    m_Mesh = std::make_shared<Mesh>(std::move(m_Vertices), std::move(m_Indices), m_VertexFormat);
+    m_Vertices.clear();
+    m_Indices.clear();
+}
+
+static std::string FullMeshKey(const std::string& key, VertexFormat format, bool optimized)
+{
+    return key + "|format=" + std::to_string((int)format) + "|optimized=" + (optimized ? "1" : "0");
+}
+
+bool Shape::UseCachedMesh(const std::string& key)
+{
+    std::shared_ptr<Mesh> mesh = MeshCache::Get().Find(FullMeshKey(key, m_VertexFormat, m_OptimizeMesh));
+    if (!mesh)
+        return false;
 
-    // Setup the vertex buffer layout
-    VertexBufferLayout layout;
-    layout.Push<float>(3); // Position (3 components: x, y, z)
-    layout.Push<float>(3); // Normal (3 components: nx, ny, nz)
-    m_VAO->AddBuffer(*m_VBO, layout);
+    m_Mesh = mesh;
+    m_Vertices.clear();
+    m_Indices.clear();
+    return true;
+}
 
-    // Create index buffer
-    m_IBO = std::make_unique<IndexBuffer>(m_Indices.data(), m_Indices.size());
+void Shape::SetupCachedMesh(const std::string& key)
+{
+    SetupMesh();
+    if (m_Mesh)
+        MeshCache::Get().Insert(FullMeshKey(key, m_VertexFormat, m_OptimizeMesh), m_Mesh);
+}
+
+void Shape::SetVertexFormat(VertexFormat format)
+{
+    if (m_VertexFormat == format)
+        return;
+
+    // Meshes are immutable, regenerate (or pick the shared mesh in that format)
+    m_VertexFormat = format;
+    Update();
+}
+
+unsigned int Shape::GetGPUBufferSize() const
+{
+    return m_Mesh ? m_Mesh->GetGPUBufferSize() : 0;
+}
+
+void Shape::SetMeshOptimization(bool enabled)
+{
+    if (m_OptimizeMesh == enabled)
+        return;
+
+    m_OptimizeMesh = enabled;
+    Update();
+}
+
+void Shape::GenerateLODs(unsigned int)
+{
+    // No parametric resolution to lower, the base mesh is the only level
+    m_LODMeshes.clear();
+    m_LODErrors.clear();
+    m_LODLevelCount = 0;
+    m_CurrentLOD = 0;
+}
+
+void Shape::ClearLODs()
+{
+    if (!m_LODMeshes.empty())
+        m_Mesh = m_LODMeshes[0];
+
+    m_LODMeshes.clear();
+    m_LODErrors.clear();
+    m_LODLevelCount = 0;
+    m_CurrentLOD = 0;
+}
+
+bool Shape::SelectLOD(const Camera& camera, float viewportHeight, float maxPixelError)
+{
+    if (m_LODMeshes.size() < 2)
+        return false;
+
+    // Mesh space errors become world space through the largest scale axis
+    glm::vec3 scale = glm::abs(m_Scale * m_MeshScale);
+    float worldScale = std::max(scale.x, std::max(scale.y, scale.z));
+
+    const Mesh& finest = *m_LODMeshes[0];
+    glm::vec3 center = glm::vec3(GetModelMatrix() * glm::vec4(finest.GetBoundsCenter(), 1.0f));
+    float radius = finest.GetBoundingRadius() * worldScale;
+
+    // Distance to the closest point of the bounding sphere, pixels per world unit at that distance
+    float distance = std::max(glm::length(center - camera.GetPosition()) - radius, 0.01f);
+    float pixelsPerUnit = viewportHeight / (2.0f * distance * std::tan(glm::radians(camera.GetZoom()) * 0.5f));
+
+    auto projectedError = [&](unsigned int level) { return m_LODErrors[level] * worldScale * pixelsPerUnit; };
+
+    // Errors grow with the level, take the coarsest one under the threshold
+    unsigned int target = 0;
+    while (target + 1 < m_LODMeshes.size() && projectedError(target + 1) <= maxPixelError)
+        target++;
+
+    // Refining happens straight away, coarsening needs some margin
+    if (target > m_CurrentLOD)
+    {
+        unsigned int coarser = m_CurrentLOD;
+        while (coarser < target && projectedError(coarser + 1) <= maxPixelError * s_LODHysteresis)
+            coarser++;
+        target = coarser;
+    }
+
+    if (target == m_CurrentLOD)
+        return false;
+
+    m_CurrentLOD = target;
+    m_Mesh = m_LODMeshes[target];
+    return true;
 }
 
 void Shape::SetPosition(const glm::vec3& position)
 {
     m_Position = position;
+    m_WorldBoundsDirty = true;
 }
 
 void Shape::SetRotation(const glm::vec3& rotation)
 {
     m_Rotation = rotation;
+    m_WorldBoundsDirty = true;
 }
 
 void Shape::SetScale(const glm::vec3& scale)
 {
     m_Scale = scale;
+    m_WorldBoundsDirty = true;
 }
 
 glm::mat4 Shape::GetModelMatrix() const
@@ -59,11 +183,62 @@ glm::mat4 Shape::GetModelMatrix() const
     model = glm::rotate(model, glm::radians(m_Rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
     model = glm::rotate(model, glm::radians(m_Rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
 
-    model = glm::scale(model, m_Scale);
+    model = glm::scale(model, m_Scale * m_MeshScale);
 
     return model;
 }
 
+void Shape::SetMeshScale(const glm::vec3& meshScale)
+{
+    m_MeshScale = meshScale;
+    m_WorldBoundsDirty = true;
+}
+
+void Shape::UpdateWorldBounds() const
+{
+    if (!m_WorldBoundsDirty && m_WorldBoundsMesh == m_Mesh.get())
+        return;
+
+    m_WorldBoundsDirty = false;
+    m_WorldBoundsMesh = m_Mesh.get();
+    if (!m_Mesh)
+    {
+        m_WorldCenter = m_Position;
+        m_WorldExtents = glm::vec3(0.0f);
+        m_WorldRadius = 0.0f;
+        return;
+    }
+
+    // Transform the box center, the extents go through the absolute value of the
+    // rotation/scale part so the box still encloses the rotated one
+    glm::mat4 model = GetModelMatrix();
+    glm::vec3 extents = (m_Mesh->GetBoundsMax() - m_Mesh->GetBoundsMin()) * 0.5f;
+    glm::mat3 absolute(glm::abs(glm::vec3(model[0])), glm::abs(glm::vec3(model[1])), glm::abs(glm::vec3(model[2])));
+    m_WorldCenter = glm::vec3(model * glm::vec4(m_Mesh->GetBoundsCenter(), 1.0f));
+    m_WorldExtents = absolute * extents;
+
+    glm::vec3 scale = glm::abs(m_Scale * m_MeshScale);
+    m_WorldRadius = m_Mesh->GetBoundingRadius() * std::max(scale.x, std::max(scale.y, scale.z));
+}
+
+glm::vec3 Shape::GetWorldBoundsCenter() const
+{
+    UpdateWorldBounds();
+    return m_WorldCenter;
+}
+
+glm::vec3 Shape::GetWorldBoundsExtents() const
+{
+    UpdateWorldBounds();
+    return m_WorldExtents;
+}
+
+float Shape::GetWorldBoundingRadius() const
+{
+    UpdateWorldBounds();
+    return m_WorldRadius;
+}
+
 void Shape::ToggleWireframe()
 {
     m_WireframeMode = !m_WireframeMode;
@@ -76,45 +251,39 @@ bool Shape::IsWireframe() const
 
 const std::vector<float>& Shape::GetVertices() const
 {
-    return m_Vertices;
+    return m_Mesh ? m_Mesh->GetVertices() : m_Vertices;
 }
 
 const std::vector<unsigned int>& Shape::GetIndices() const
 {
-    return m_Indices;
+    return m_Mesh ? m_Mesh->GetIndices() : m_Indices;
 }
 
 unsigned int Shape::GetVertexCount() const
 {
-    return m_Vertices.size() / 6; // 6 floats per vertex (position + normal)
+    return GetVertices().size() / 6; // 6 floats per vertex (position + normal)
 }
 
 unsigned int Shape::GetIndexCount() const
 {
-    return m_Indices.size();
+    return GetIndices().size();
 }
 
 void Shape::Bind() const
 {
-    if (m_VAO && m_IBO)
-    {
-        m_VAO->Bind();
-        m_IBO->Bind();
-    }
+    if (m_Mesh)
+        m_Mesh->Bind();
 }
 
 void Shape::Unbind() const
 {
-    if (m_VAO && m_IBO)
-    {
-        m_VAO->Unbind();
-        m_IBO->Unbind();
-    }
+    if (m_Mesh)
+        m_Mesh->Unbind();
 }
 
 void Shape::Draw(Shader& shader, const glm::mat4& view, const glm::mat4& projection) const
 {
-    if (!m_VAO || !m_IBO)
+    if (!m_Mesh || m_Mesh->GetIndexCount() == 0)
         return;
 
     shader.Bind();
@@ -125,6 +294,14 @@ void Shape::Draw(Shader& shader, const glm::mat4& view, const glm::mat4& project
     shader.SetUniformMat4f("u_View", view);
     shader.SetUniformMat4f("u_Projection", projection);
 
+    if (m_Mesh->GetVertexFormat() != VertexFormat::Float)
+    {
+        glm::vec3 offset = m_Mesh->GetPositionOffset();
+        glm::vec3 scale = m_Mesh->GetPositionScale();
+        shader.SetUniform3f("u_PositionOffset", offset.x, offset.y, offset.z);
+        shader.SetUniform3f("u_PositionScale", scale.x, scale.y, scale.z);
+    }
+
     // Bind vertex array and index buffer
     Bind();
 
@@ -135,7 +312,7 @@ void Shape::Draw(Shader& shader, const glm::mat4& view, const glm::mat4& project
     }
 
     // Draw the shape
-    GLCall(glDrawElements(GL_TRIANGLES, GetIndexCount(), GL_UNSIGNED_INT, nullptr));
+    GLCall(glDrawElements(GL_TRIANGLES, m_Mesh->GetIndexCount(), m_Mesh->GetIndexType(), nullptr));
 
     // Reset polygon mode
     if (m_WireframeMode)
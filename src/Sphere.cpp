@@ -1,10 +1,15 @@
 #include "Sphere.h"
 #include "Renderer.h"
 #include <glm/gtc/constants.hpp>
+#include <string>
+#include <algorithm>
+#include <cmath>
 
 Sphere::Sphere(float radius, unsigned int sectors, unsigned int stacks)
     : m_Radius(radius), m_Sectors(sectors), m_Stacks(stacks), m_FlatShading(false)
 {
+    // The mesh is a unit sphere, the radius is applied through the model matrix
+    SetMeshScale(glm::vec3(m_Radius));
     Generate();
 }
 
@@ -12,30 +17,85 @@ Sphere::~Sphere()
 {
 }
 
+std::string Sphere::GetMeshKey(unsigned int sectors, unsigned int stacks, bool flatShading) const
+{
+    return "Sphere|" + std::to_string(sectors) + "|" + std::to_string(stacks) + "|" + (flatShading ? "flat" : "smooth");
+}
+
 void Sphere::Generate()
 {
-    if (m_FlatShading)
+    m_Mesh = GenerateMesh(m_Sectors, m_Stacks, m_FlatShading);
+}
+
+std::shared_ptr<Mesh> Sphere::GenerateMesh(unsigned int sectors, unsigned int stacks, bool flatShading)
+{
+    // Every sphere with the same resolution shares one unit mesh
+    std::string key = GetMeshKey(sectors, stacks, flatShading);
+    if (UseCachedMesh(key))
+        return m_Mesh;
+
+    if (flatShading)
+        BuildFlatShadedSphere(sectors, stacks);
+    else
+        BuildSmoothSphere(sectors, stacks);
+
+    // Setup OpenGL buffers and share them
+    SetupCachedMesh(key);
+    return m_Mesh;
+}
+
+void Sphere::GenerateFlatShadedSphere()
+{
+    m_Mesh = GenerateMesh(m_Sectors, m_Stacks, true);
+}
+
+void Sphere::GenerateLODs(unsigned int levelCount)
+{
+    m_LODMeshes.clear();
+    m_LODErrors.clear();
+    m_LODLevelCount = levelCount;
+
+    // Halve the resolution at every level, down to an octahedron-like 6x3 sphere
+    unsigned int sectors = m_Sectors;
+    unsigned int stacks = m_Stacks;
+    for (unsigned int level = 0; level < levelCount; level++)
     {
-        GenerateFlatShadedSphere();
-        return;
+        m_LODMeshes.push_back(GenerateMesh(sectors, stacks, m_FlatShading));
+
+        // Largest distance between the unit sphere and a quad of the tessellation (at its center)
+        float halfSector = glm::pi<float>() / sectors;
+        float halfStack = glm::pi<float>() / (2.0f * stacks);
+        m_LODErrors.push_back(1.0f - std::cos(halfSector) * std::cos(halfStack));
+
+        if (sectors <= 6 && stacks <= 3)
+            break;
+        sectors = std::max(sectors / 2, 6u);
+        stacks = std::max(stacks / 2, 3u);
     }
 
+    m_CurrentLOD = 0;
+    if (!m_LODMeshes.empty())
+        m_Mesh = m_LODMeshes[0];
+}
+
+void Sphere::BuildSmoothSphere(unsigned int sectors, unsigned int stacks)
+{
     m_Vertices.clear();
     m_Indices.clear();
 
-    float sectorStep = 2 * glm::pi<float>() / m_Sectors;
-    float stackStep = glm::pi<float>() / m_Stacks;
+    float sectorStep = 2 * glm::pi<float>() / sectors;
+    float stackStep = glm::pi<float>() / stacks;
 
     // Generate vertices
-    for (unsigned int i = 0; i <= m_Stacks; ++i)
+    for (unsigned int i = 0; i <= stacks; ++i)
     {
         float stackAngle = glm::pi<float>() / 2 - i * stackStep;  // starting from pi/2 to -pi/2
-        float xy = m_Radius * cosf(stackAngle);                   // r * cos(u)
-        float z = m_Radius * sinf(stackAngle);                    // r * sin(u)
+        float xy = cosf(stackAngle);                              // r * cos(u), r = 1
+        float z = sinf(stackAngle);                               // r * sin(u), r = 1
 
         // Add (sectors+1) vertices per stack
         // The first and last vertices have same position and normal, but different tex coords
-        for (unsigned int j = 0; j <= m_Sectors; ++j)
+        for (unsigned int j = 0; j <= sectors; ++j)
         {
             float sectorAngle = j * sectorStep;  // starting from 0 to 2pi
 
@@ -59,12 +119,12 @@ void Sphere::Generate()
     }
 
     // Generate indices
-    for (unsigned int i = 0; i < m_Stacks; ++i)
+    for (unsigned int i = 0; i < stacks; ++i)
     {
-        unsigned int k1 = i * (m_Sectors + 1);        // beginning of current stack
-        unsigned int k2 = k1 + m_Sectors + 1;         // beginning of next stack
+        unsigned int k1 = i * (sectors + 1);        // beginning of current stack
+        unsigned int k2 = k1 + sectors + 1;         // beginning of next stack
 
-        for (unsigned int j = 0; j < m_Sectors; ++j, ++k1, ++k2)
+        for (unsigned int j = 0; j < sectors; ++j, ++k1, ++k2)
         {
             // 2 triangles per sector excluding the first and last stacks
             // k1 => k2 => k1+1
@@ -76,7 +136,7 @@ void Sphere::Generate()
             }
 
             // k1+1 => k2 => k2+1
-            if (i != (m_Stacks - 1))
+            if (i != (stacks - 1))
             {
                 m_Indices.push_back(k1 + 1);
                 m_Indices.push_back(k2);
@@ -84,29 +144,26 @@ void Sphere::Generate()
             }
         }
     }
-
-    // Setup OpenGL buffers
-    SetupMesh();
 }
 
-void Sphere::GenerateFlatShadedSphere()
+void Sphere::BuildFlatShadedSphere(unsigned int sectors, unsigned int stacks)
 {
     m_Vertices.clear();
     m_Indices.clear();
 
-    float sectorStep = 2 * glm::pi<float>() / m_Sectors;
-    float stackStep = glm::pi<float>() / m_Stacks;
+    float sectorStep = 2 * glm::pi<float>() / sectors;
+    float stackStep = glm::pi<float>() / stacks;
 
     // Generate vertex positions first (for calculating face normals)
     std::vector<glm::vec3> positions;
 
-    for (unsigned int i = 0; i <= m_Stacks; ++i)
+    for (unsigned int i = 0; i <= stacks; ++i)
     {
         float stackAngle = glm::pi<float>() / 2 - i * stackStep;  // starting from pi/2 to -pi/2
-        float xy = m_Radius * cosf(stackAngle);                   // r * cos(u)
-        float z = m_Radius * sinf(stackAngle);                    // r * sin(u)
+        float xy = cosf(stackAngle);                              // r * cos(u), r = 1
+        float z = sinf(stackAngle);                               // r * sin(u), r = 1
 
-        for (unsigned int j = 0; j <= m_Sectors; ++j)
+        for (unsigned int j = 0; j <= sectors; ++j)
         {
             float sectorAngle = j * sectorStep;  // starting from 0 to 2pi
 
@@ -122,12 +179,12 @@ void Sphere::GenerateFlatShadedSphere()
     unsigned int index = 0;
 
     // Indices for accessing positions
-    for (unsigned int i = 0; i < m_Stacks; ++i)
+    for (unsigned int i = 0; i < stacks; ++i)
     {
-        unsigned int k1 = i * (m_Sectors + 1);        // beginning of current stack
-        unsigned int k2 = k1 + m_Sectors + 1;         // beginning of next stack
+        unsigned int k1 = i * (sectors + 1);        // beginning of current stack
+        unsigned int k2 = k1 + sectors + 1;         // beginning of next stack
 
-        for (unsigned int j = 0; j < m_Sectors; ++j, ++k1, ++k2)
+        for (unsigned int j = 0; j < sectors; ++j, ++k1, ++k2)
         {
             // 2 triangles per sector excluding the first and last stacks
             if (i != 0)
@@ -156,7 +213,7 @@ void Sphere::GenerateFlatShadedSphere()
                 m_Indices.push_back(index++);
             }
 
-            if (i != (m_Stacks - 1))
+            if (i != (stacks - 1))
             {
                 // Triangle: k1+1 => k2 => k2+1
                 glm::vec3 v1 = positions[k1 + 1];
@@ -183,21 +240,21 @@ void Sphere::GenerateFlatShadedSphere()
             }
         }
     }
-
-    // Setup OpenGL buffers
-    SetupMesh();
 }
 
 void Sphere::Update()
 {
     // Re-generate the mesh with current parameters
     Generate();
+    if (m_LODLevelCount > 0)
+        GenerateLODs(m_LODLevelCount);
 }
 
 void Sphere::SetRadius(float radius)
 {
+    // Only the mesh scale changes, the shared unit mesh stays the same
     m_Radius = radius;
-    Update();
+    SetMeshScale(glm::vec3(m_Radius));
 }
 
 void Sphere::SetResolution(unsigned int sectors, unsigned int stacks)
@@ -0,0 +1,221 @@
+#include "StrokeTessellator.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/constants.hpp>
+
+const unsigned int StrokeTessellator::s_RestartIndex;
+
+StrokeTessellator::StrokeTessellator()
+{
+}
+
+StrokeTessellator::~StrokeTessellator()
+{
+}
+
+void StrokeTessellator::Clear()
+{
+    m_Vertices.clear();
+    m_Indices.clear();
+}
+
+void StrokeTessellator::AddCurve(const BezierCurve& curve, const StrokeStyle& style)
+{
+    AddPolyline(curve.GetCurvePoints().data(), curve.GetPointCount(), style);
+}
+
+void StrokeTessellator::AddPolylines(const std::vector<float>& points, unsigned int pointsPerCurve, const StrokeStyle& style)
+{
+    if (pointsPerCurve == 0)
+        return;
+
+    unsigned int curveCount = points.size() / (pointsPerCurve * 2);
+    for (unsigned int c = 0; c < curveCount; c++)
+        AddPolyline(&points[c * pointsPerCurve * 2], pointsPerCurve, style);
+}
+
+void StrokeTessellator::AddPolyline(const float* points, unsigned int pointCount, const StrokeStyle& style)
+{
+    // Drop repeated points, they have no direction
+    m_Points.clear();
+    for (unsigned int i = 0; i < pointCount; i++)
+    {
+        glm::vec2 point(points[i * 2], points[i * 2 + 1]);
+        if (m_Points.empty() || point != m_Points.back())
+            m_Points.push_back(point);
+    }
+    if (m_Points.size() < 2)
+        return;
+
+    ComputeNormals();
+
+    // Separate from the previous strip
+    if (!m_Indices.empty())
+        m_Indices.push_back(s_RestartIndex);
+
+    unsigned int last = m_Points.size() - 1;
+
+    glm::vec2 startDirection(m_Normals[0].y, -m_Normals[0].x);
+    EmitCap(m_Points[0], startDirection, m_Normals[0], style, true);
+
+    for (unsigned int i = 1; i < last; i++)
+        EmitJoin(i, style);
+
+    glm::vec2 endNormal = m_Normals[last - 1];
+    glm::vec2 endDirection(endNormal.y, -endNormal.x);
+    EmitCap(m_Points[last], endDirection, endNormal, style, false);
+}
+
+void StrokeTessellator::ComputeNormals()
+{
+    unsigned int segmentCount = m_Points.size() - 1;
+    m_Normals.resize(segmentCount);
+    const float* points = &m_Points[0].x;
+    float* normals = &m_Normals[0].x;
+    unsigned int i = 0;
+
+#if defined(SIMD_SSE)
+    // 4 segments at a time, points are deinterleaved into x / y lanes
+    for (; i + 4 <= segmentCount; i += 4)
+    {
+        __m128 a0 = _mm_loadu_ps(points + i * 2);
+        __m128 a1 = _mm_loadu_ps(points + i * 2 + 4);
+        __m128 b0 = _mm_loadu_ps(points + i * 2 + 2);
+        __m128 b1 = _mm_loadu_ps(points + i * 2 + 6);
+
+        __m128 dx = _mm_sub_ps(_mm_shuffle_ps(b0, b1, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(2, 0, 2, 0)));
+        __m128 dy = _mm_sub_ps(_mm_shuffle_ps(b0, b1, _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(3, 1, 3, 1)));
+
+        // Repeated points were removed, the length is never zero
+        __m128 inverseLength = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy))));
+        __m128 nx = _mm_mul_ps(_mm_sub_ps(_mm_setzero_ps(), dy), inverseLength);
+        __m128 ny = _mm_mul_ps(dx, inverseLength);
+
+        // Back to (nx, ny) pairs
+        _mm_storeu_ps(normals + i * 2, _mm_unpacklo_ps(nx, ny));
+        _mm_storeu_ps(normals + i * 2 + 4, _mm_unpackhi_ps(nx, ny));
+    }
+#endif
+
+    for (; i < segmentCount; i++)
+    {
+        glm::vec2 direction = glm::normalize(m_Points[i + 1] - m_Points[i]);
+        m_Normals[i] = glm::vec2(-direction.y, direction.x);
+    }
+}
+
+void StrokeTessellator::EmitPair(const glm::vec2& left, const glm::vec2& right)
+{
+    unsigned int index = m_Vertices.size() / 2;
+    m_Vertices.push_back(left.x);
+    m_Vertices.push_back(left.y);
+    m_Vertices.push_back(right.x);
+    m_Vertices.push_back(right.y);
+    m_Indices.push_back(index);
+    m_Indices.push_back(index + 1);
+}
+
+unsigned int StrokeTessellator::GetArcSegments(float angle, float halfWidth, const StrokeStyle& style) const
+{
+    // Chord error of an arc step is r * (1 - cos(step / 2))
+    float ratio = glm::clamp(1.0f - style.RoundTolerance / halfWidth, -1.0f, 1.0f);
+    float maxStep = 2.0f * std::acos(ratio);
+    if (maxStep <= 0.0f)
+        return 1;
+    return std::max(1u, static_cast<unsigned int>(std::ceil(angle / maxStep)));
+}
+
+void StrokeTessellator::EmitCap(const glm::vec2& point, const glm::vec2& direction, const glm::vec2& normal, const StrokeStyle& style, bool start)
+{
+    float halfWidth = style.Width * 0.5f;
+
+    // Caps stick out backwards at the start and forwards at the end
+    glm::vec2 outward = start ? -direction : direction;
+
+    if (style.Cap == LineCap::Round)
+    {
+        // Pairs of symmetric points on the half circle, from the tip to the full width (or back)
+        unsigned int steps = GetArcSegments(glm::pi<float>() * 0.5f, halfWidth, style);
+        for (unsigned int k = 0; k <= steps; k++)
+        {
+            unsigned int step = start ? k : steps - k;
+            float angle = glm::pi<float>() * 0.5f * static_cast<float>(step) / static_cast<float>(steps);
+            glm::vec2 across = std::sin(angle) * halfWidth * normal;
+            glm::vec2 along = std::cos(angle) * halfWidth * outward;
+            EmitPair(point + along + across, point + along - across);
+        }
+        return;
+    }
+
+    glm::vec2 across = normal * halfWidth;
+    if (style.Cap == LineCap::Square)
+    {
+        // Extra half width box past the end point
+        glm::vec2 extended = point + outward * halfWidth;
+        if (start)
+            EmitPair(extended + across, extended - across);
+        EmitPair(point + across, point - across);
+        if (!start)
+            EmitPair(extended + across, extended - across);
+        return;
+    }
+
+    EmitPair(point + across, point - across);
+}
+
+void StrokeTessellator::EmitJoin(unsigned int index, const StrokeStyle& style)
+{
+    float halfWidth = style.Width * 0.5f;
+    const glm::vec2& point = m_Points[index];
+    const glm::vec2& before = m_Normals[index - 1];
+    const glm::vec2& after = m_Normals[index];
+
+    float cosine = glm::clamp(glm::dot(before, after), -1.0f, 1.0f);
+
+    // Nearly straight, a single shared pair
+    if (cosine > 0.9999f)
+    {
+        glm::vec2 normal = glm::normalize(before + after);
+        EmitPair(point + normal * halfWidth, point - normal * halfWidth);
+        return;
+    }
+
+    if (style.Join == LineJoin::Miter)
+    {
+        // Miter point along the bisector, length halfWidth / cos(turn / 2)
+        glm::vec2 bisector = before + after;
+        float length = glm::length(bisector);
+        if (length > 1e-6f)
+        {
+            glm::vec2 miter = bisector / length;
+            float miterLength = halfWidth / glm::dot(miter, after);
+            if (miterLength <= style.MiterLimit * halfWidth)
+            {
+                EmitPair(point + miter * miterLength, point - miter * miterLength);
+                return;
+            }
+        }
+    }
+
+    if (style.Join == LineJoin::Round)
+    {
+        // Sweep the normal from one segment to the next, the outer side traces the arc
+        float angle = std::acos(cosine);
+        float turn = before.x * after.y - before.y * after.x > 0.0f ? 1.0f : -1.0f;
+        unsigned int steps = GetArcSegments(angle, halfWidth, style);
+        for (unsigned int k = 0; k <= steps; k++)
+        {
+            float rotation = turn * angle * static_cast<float>(k) / static_cast<float>(steps);
+            float c = std::cos(rotation), s = std::sin(rotation);
+            glm::vec2 normal(before.x * c - before.y * s, before.x * s + before.y * c);
+            EmitPair(point + normal * halfWidth, point - normal * halfWidth);
+        }
+        return;
+    }
+
+    // Bevel (and miters over the limit), end the previous segment and start the next one at the same point
+    EmitPair(point + before * halfWidth, point - before * halfWidth);
+    EmitPair(point + after * halfWidth, point - after * halfWidth);
+}
@@ -24,7 +24,7 @@ void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& la
 		GLCall(glEnableVertexAttribArray(i));
 		GLCall(glVertexAttribPointer(i, element.count, element.type, element.normalized, layout.GetStride(), 
 									(const void*)offset));
-		offset += element.count * VertexBufferElement::getSizeType(element.type);
+		offset += element.getSize();
 
 	}
 	
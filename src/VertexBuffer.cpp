@@ -3,12 +3,15 @@
 #include "Renderer.h"
 
 
-VertexBuffer::VertexBuffer() {
+VertexBuffer::VertexBuffer()
+	: m_Size(0)
+{
 	GLCall(glGenBuffers(1, &m_Render_ID));
 	GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_Render_ID));
 }
 
 VertexBuffer::VertexBuffer(const void* data, unsigned int size)
+	: m_Size(size)
 {
 	GLCall(glGenBuffers(1, &m_Render_ID));
 	GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_Render_ID));
@@ -30,4 +33,18 @@ void VertexBuffer::Unbind() const
 {
 	GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
 
-}
\ No newline at end of file
+}
+
+void VertexBuffer::SetData(const void* data, unsigned int size)
+{
+	m_Size = size;
+	GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_Render_ID));
+	GLCall(glBufferData(GL_ARRAY_BUFFER, size, data, GL_DYNAMIC_DRAW));
+}
+
+void VertexBuffer::UpdateData(const void* data, unsigned int offset, unsigned int size)
+{
+	ASSERT(offset + size <= m_Size);
+	GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_Render_ID));
+	GLCall(glBufferSubData(GL_ARRAY_BUFFER, offset, size, data));
+}
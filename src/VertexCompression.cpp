@@ -0,0 +1,146 @@
+#include "VertexCompression.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+static const unsigned int s_FloatsPerVertex = 6;
+
+static float SignNotZero(float v)
+{
+    return v >= 0.0f ? 1.0f : -1.0f;
+}
+
+static short ToSnorm16(float v)
+{
+    return (short)std::lround(std::max(-1.0f, std::min(1.0f, v)) * 32767.0f);
+}
+
+static unsigned short ToUnorm16(float v)
+{
+    return (unsigned short)std::lround(std::max(0.0f, std::min(1.0f, v)) * 65535.0f);
+}
+
+// Signed 10 bit field for GL_INT_2_10_10_10_REV, normalized as max(v / 511, -1)
+static unsigned int ToSnorm10(float v)
+{
+    int q = (int)std::lround(std::max(-1.0f, std::min(1.0f, v)) * 511.0f);
+    return (unsigned int)q & 0x3FFu;
+}
+
+unsigned int GetVertexFormatStride(VertexFormat format)
+{
+    switch (format)
+    {
+        case VertexFormat::Float: return 6 * sizeof(float);
+        case VertexFormat::Quantized: return 4 * sizeof(unsigned short) + 2 * sizeof(short);
+        case VertexFormat::Packed: return sizeof(unsigned int) + 2 * sizeof(short);
+    }
+    return 0;
+}
+
+glm::vec2 OctahedralEncode(const glm::vec3& normal)
+{
+    float l1 = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (l1 <= 0.0f)
+        return glm::vec2(0.0f, 0.0f);
+
+    glm::vec3 n = normal / l1;
+    glm::vec2 e(n.x, n.y);
+
+    // Fold the lower hemisphere over the diagonals
+    if (n.z < 0.0f)
+    {
+        e = glm::vec2((1.0f - std::abs(n.y)) * SignNotZero(n.x),
+                      (1.0f - std::abs(n.x)) * SignNotZero(n.y));
+    }
+    return e;
+}
+
+glm::vec3 OctahedralDecode(const glm::vec2& encoded)
+{
+    glm::vec3 n(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+    if (n.z < 0.0f)
+    {
+        float x = n.x;
+        n.x = (1.0f - std::abs(n.y)) * SignNotZero(x);
+        n.y = (1.0f - std::abs(x)) * SignNotZero(n.y);
+    }
+    return glm::normalize(n);
+}
+
+CompressedVertexData CompressVertices(const std::vector<float>& vertices, VertexFormat format)
+{
+    CompressedVertexData result;
+    result.PositionOffset = glm::vec3(0.0f);
+    result.PositionScale = glm::vec3(1.0f);
+
+    size_t vertexCount = vertices.size() / s_FloatsPerVertex;
+    if (vertexCount == 0 || format == VertexFormat::Float)
+        return result;
+
+    // Mesh bounds, quantization is relative to them
+    glm::vec3 minBound(vertices[0], vertices[1], vertices[2]);
+    glm::vec3 maxBound = minBound;
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        glm::vec3 p(vertices[i * s_FloatsPerVertex], vertices[i * s_FloatsPerVertex + 1], vertices[i * s_FloatsPerVertex + 2]);
+        minBound = glm::min(minBound, p);
+        maxBound = glm::max(maxBound, p);
+    }
+
+    glm::vec3 extent = maxBound - minBound;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        // Flat along this axis, any non zero scale works
+        if (extent[axis] <= 0.0f)
+            extent[axis] = 1.0f;
+    }
+
+    if (format == VertexFormat::Quantized)
+    {
+        // unorm16 maps [0, 1] onto [min, max]
+        result.PositionOffset = minBound;
+        result.PositionScale = extent;
+        result.Layout.Push<unsigned short>(4);
+        result.Layout.Push<short>(2);
+    }
+    else
+    {
+        // snorm 10 bit maps [-1, 1] onto [min, max]
+        result.PositionOffset = (minBound + maxBound) * 0.5f;
+        result.PositionScale = extent * 0.5f;
+        result.Layout.Push<PackedInt2101010>(4);
+        result.Layout.Push<short>(2);
+    }
+
+    unsigned int stride = GetVertexFormatStride(format);
+    result.Data.resize(vertexCount * stride);
+    unsigned char* out = result.Data.data();
+
+    for (size_t i = 0; i < vertexCount; i++, out += stride)
+    {
+        const float* v = &vertices[i * s_FloatsPerVertex];
+        glm::vec3 position(v[0], v[1], v[2]);
+        glm::vec3 local = (position - result.PositionOffset) / result.PositionScale;
+
+        glm::vec2 oct = OctahedralEncode(glm::vec3(v[3], v[4], v[5]));
+        short normal[2] = { ToSnorm16(oct.x), ToSnorm16(oct.y) };
+
+        if (format == VertexFormat::Quantized)
+        {
+            unsigned short packedPosition[4] = { ToUnorm16(local.x), ToUnorm16(local.y), ToUnorm16(local.z), 65535 };
+            std::memcpy(out, packedPosition, sizeof(packedPosition));
+            std::memcpy(out + sizeof(packedPosition), normal, sizeof(normal));
+        }
+        else
+        {
+            // w = 1 in the top two bits
+            unsigned int packedPosition = ToSnorm10(local.x) | (ToSnorm10(local.y) << 10) | (ToSnorm10(local.z) << 20) | (1u << 30);
+            std::memcpy(out, &packedPosition, sizeof(packedPosition));
+            std::memcpy(out + sizeof(packedPosition), normal, sizeof(normal));
+        }
+    }
+
+    return result;
+}
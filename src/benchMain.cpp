@@ -0,0 +1,983 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "FrustumCuller.h"
+#include "MeshOptimizer.h"
+#include "BezierCurve.h"
+#include "CurveBatch.h"
+#include "CurveFitting.h"
+#include "CurveQueries.h"
+#include "FillTessellator.h"
+#include "PatchEvaluator.h"
+#include "PatchTessellator.h"
+#include "AdaptivePatchTessellator.h"
+#include "ControlPointBVH.h"
+
+// Stand alone entry point for the CPU side benchmarks, build it instead of the demo mains. Everything
+// here goes through the public API of the classes it measures
+
+// Original recursive curve / BezierSurface evaluation, allocates at every level, the reference the
+// table driven evaluators are measured against
+template<typename Point>
+static Point DeCasteljauRecursive(const std::vector<Point>& points, float t)
+{
+    if (points.size() == 1)
+        return points[0];
+
+    std::vector<Point> newPoints;
+    for (size_t i = 0; i < points.size() - 1; i++)
+        newPoints.push_back((1.0f - t) * points[i] + t * points[i + 1]);
+    return DeCasteljauRecursive(newPoints, t);
+}
+
+// A fresh vector per De Casteljau level and per column
+static glm::vec3 CalculatePointRecursive(const std::vector<std::vector<glm::vec3>>& net, float u, float v)
+{
+    std::vector<glm::vec3> tempPoints;
+    for (unsigned int j = 0; j < net[0].size(); j++)
+    {
+        std::vector<glm::vec3> uPoints;
+        for (unsigned int i = 0; i < net.size(); i++)
+            uPoints.push_back(net[i][j]);
+        tempPoints.push_back(DeCasteljauRecursive(uPoints, u));
+    }
+    return DeCasteljauRecursive(tempPoints, v);
+}
+
+// Cull objectCount random objects for a number of frames and print the time per frame
+static void BenchmarkFrustumCulling(unsigned int objectCount, unsigned int frames)
+{
+    // Objects scattered in a 1000 unit cube around the camera
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> size(0.5f, 2.0f);
+
+    FrustumCuller culler;
+    culler.Reserve(objectCount);
+    for (unsigned int i = 0; i < objectCount; i++)
+    {
+        glm::vec3 extents(size(random), size(random), size(random));
+        culler.Add(glm::vec3(position(random), position(random), position(random)), glm::length(extents), extents);
+    }
+
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 1000.0f);
+    std::vector<unsigned int> visible;
+    visible.reserve(objectCount);
+
+    auto run = [&](bool simd)
+    {
+        size_t visibleTotal = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (unsigned int frame = 0; frame < frames; frame++)
+        {
+            // The camera turns around a bit every frame
+            float yaw = glm::radians(360.0f * frame / frames);
+            glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(std::cos(yaw), 0.0f, std::sin(yaw)), glm::vec3(0.0f, 1.0f, 0.0f));
+            Frustum frustum(projection * view);
+
+            if (simd)
+                culler.Cull(frustum, visible);
+            else
+                culler.CullScalar(frustum, visible);
+            visibleTotal += visible.size();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        double milliseconds = std::chrono::duration<double, std::milli>(end - start).count() / frames;
+
+        std::cout << (simd ? "  SIMD  : " : "  Scalar: ") << milliseconds << " ms/frame, "
+            << visibleTotal / frames << " visible on average" << std::endl;
+    };
+
+    std::cout << "Frustum culling " << objectCount << " objects over " << frames << " frames" << std::endl;
+    run(false);
+    run(true);
+}
+
+// Compare the recursive, in place and batched evaluation for degrees 3, 7 and 15
+static void BenchmarkBezierEvaluation(unsigned int resolution, unsigned int iterations)
+{
+    std::cout << "Bezier curve evaluation, " << resolution + 1 << " samples x " << iterations << " curves" << std::endl;
+
+    const unsigned int degrees[] = { 3, 7, 15 };
+    for (unsigned int degree : degrees)
+    {
+        std::vector<glm::vec2> points;
+        for (unsigned int i = 0; i <= degree; i++)
+        {
+            glm::vec2 point(0.0f);
+            point[0] = static_cast<float>(i);
+            point[1] = (i % 2) ? 1.0f : -1.0f;
+            points.push_back(point);
+        }
+
+        std::vector<glm::vec2> output(resolution + 1);
+        float checksum[3] = { 0.0f, 0.0f, 0.0f };
+
+        auto time = [&](int method)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            BernsteinTable table;
+            for (unsigned int iteration = 0; iteration < iterations; iteration++)
+            {
+                // Move a point so the work can't be hoisted out of the loop
+                points[0][1] = static_cast<float>(iteration % 7);
+
+                if (method == 2)
+                {
+                    table.Build(degree, resolution);
+                    EvaluateBezierBatch(points.data(), table, output.data());
+                }
+                else
+                {
+                    for (unsigned int i = 0; i <= resolution; i++)
+                    {
+                        float t = static_cast<float>(i) / static_cast<float>(resolution);
+                        output[i] = method == 0 ? DeCasteljauRecursive(points, t) : EvaluateBezier(points.data(), points.size(), t);
+                    }
+                }
+                checksum[method] += output[resolution / 3][1];
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            return std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+        };
+
+        double recursive = time(0);
+        double inPlace = time(1);
+        double batch = time(2);
+
+        std::cout << "  Degree " << degree << ": recursive " << recursive << " us, in place " << inPlace
+            << " us, batch " << batch << " us per curve (checksums " << checksum[0] << ", " << checksum[1] << ", " << checksum[2] << ")" << std::endl;
+
+        // Points needed for a quarter unit of error, adaptive subdivision against uniform sampling bounded by Wang's formula
+        BezierCurve curve(resolution);
+        for (const glm::vec2& point : points)
+            curve.AddControlPoint(point);
+        curve.SetFlatteningTolerance(0.25f);
+        std::cout << "    Flattening at 0.25: adaptive " << curve.GetPointCount() << " points, uniform (Wang) "
+            << EstimateSegmentCount(points.data(), points.size(), 0.25f) + 1 << " points" << std::endl;
+    }
+}
+
+// Sample a 3D cubic camera path (position + direction) at 1 kHz and print the cost per sample
+static void BenchmarkCameraPath(unsigned int seconds)
+{
+    CubicBezier3D path({ glm::vec3(-8.0f, 1.0f, 8.0f), glm::vec3(-6.0f, 3.0f, -6.0f), glm::vec3(6.0f, -1.0f, -6.0f), glm::vec3(8.0f, 1.0f, 8.0f) });
+
+    const unsigned int sampleRate = 1000;
+    unsigned int samples = seconds * sampleRate;
+
+    glm::vec3 checksum(0.0f);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (unsigned int i = 0; i <= samples; i++)
+    {
+        float t = static_cast<float>(i) / static_cast<float>(samples);
+        glm::vec3 position = path.Evaluate(t);
+        glm::vec3 direction = glm::normalize(path.Derivative(t));
+        checksum += position + direction;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double nanoseconds = std::chrono::duration<double, std::nano>(end - start).count() / (samples + 1);
+
+    std::cout << "Camera path playback, " << seconds << " s at " << sampleRate << " Hz: " << nanoseconds
+        << " ns per sample (checksum " << checksum.x + checksum.y + checksum.z << ")" << std::endl;
+}
+
+// Per object BezierCurve evaluation against the batch, single and multi threaded
+static void BenchmarkCurveBatch(unsigned int curveCount, unsigned int resolution)
+{
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> coordinate(-1000.0f, 1000.0f);
+
+    CubicCurveBatch batch;
+    batch.Reserve(curveCount);
+    std::vector<BezierCurve> curves(curveCount, BezierCurve(resolution));
+    for (unsigned int c = 0; c < curveCount; c++)
+    {
+        glm::vec2 points[4];
+        for (glm::vec2& point : points)
+            point = glm::vec2(coordinate(random), coordinate(random));
+        batch.Add(points[0], points[1], points[2], points[3]);
+        for (const glm::vec2& point : points)
+            curves[c].AddControlPoint(point);
+    }
+
+    std::vector<float> vertices;
+    auto time = [&](int method)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        if (method == 0)
+        {
+            // One object at a time, gathered into the same vertex array
+            vertices.clear();
+            for (BezierCurve& curve : curves)
+            {
+                curve.UpdateCurve();
+                vertices.insert(vertices.end(), curve.GetCurvePoints().begin(), curve.GetCurvePoints().end());
+            }
+        }
+        else if (method == 1)
+            batch.EvaluateScalar(resolution, vertices);
+        else if (method == 2)
+            batch.Evaluate(resolution, vertices, false);
+        else
+            batch.Evaluate(resolution, vertices);
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    };
+
+    std::cout << "Cubic curve batch, " << curveCount << " curves x " << resolution + 1 << " samples" << std::endl;
+    std::cout << "  BezierCurve objects: " << time(0) << " ms" << std::endl;
+    std::cout << "  SoA scalar         : " << time(1) << " ms" << std::endl;
+    std::cout << "  SoA SIMD           : " << time(2) << " ms" << std::endl;
+    std::cout << "  SoA SIMD threaded  : " << time(3) << " ms (" << std::thread::hardware_concurrency() << " threads)" << std::endl;
+}
+
+// Fit a GPS like random walk and print the compression against the raw vertices
+static void BenchmarkCurveFitting(unsigned int pointCount, float tolerance)
+{
+    // Smoothly turning track sampled every meter with a little noise, like a GPS trace
+    std::mt19937 random(3);
+    std::normal_distribution<float> turn(0.0f, 0.02f);
+    std::uniform_real_distribution<float> noise(-0.05f, 0.05f);
+
+    std::vector<glm::vec2> points;
+    points.reserve(pointCount);
+    glm::vec2 position(0.0f);
+    float heading = 0.0f, turnRate = 0.0f;
+    for (unsigned int i = 0; i < pointCount; i++)
+    {
+        turnRate = glm::clamp(turnRate * 0.98f + turn(random) * 0.1f, -0.05f, 0.05f);
+        heading += turnRate;
+        position += glm::vec2(std::cos(heading), std::sin(heading));
+        points.push_back(position + glm::vec2(noise(random), noise(random)));
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<CubicBezier2D> segments = FitCubicBeziers(points, tolerance);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    // Shared end points are stored once, 3 new control points per segment
+    size_t rawBytes = points.size() * sizeof(glm::vec2);
+    size_t fittedBytes = (segments.size() * 3 + 1) * sizeof(glm::vec2);
+
+    std::cout << "Curve fitting, " << pointCount << " samples at tolerance " << tolerance << ": " << segments.size() << " cubics in "
+        << std::chrono::duration<double, std::milli>(end - start).count() << " ms, " << rawBytes << " -> " << fittedBytes << " bytes ("
+        << static_cast<float>(rawBytes) / fittedBytes << "x), max error " << GetFittingError(points, segments) << std::endl;
+}
+
+// Hover queries against curveCount random cubics, prints the time per query
+static void BenchmarkCurveBVH(unsigned int curveCount, unsigned int queryCount)
+{
+    // Short curves scattered over a 1000 x 1000 canvas, like the edges of a large graph
+    std::mt19937 random(11);
+    std::uniform_real_distribution<float> position(0.0f, 1000.0f);
+    std::uniform_real_distribution<float> offset(-5.0f, 5.0f);
+
+    CurveBVH bvh;
+    for (unsigned int c = 0; c < curveCount; c++)
+    {
+        glm::vec2 start(position(random), position(random));
+        bvh.Add(CubicBezier2D({ start, start + glm::vec2(offset(random), offset(random)),
+            start + glm::vec2(offset(random), offset(random)), start + glm::vec2(offset(random), offset(random)) }));
+    }
+
+    auto buildStart = std::chrono::high_resolution_clock::now();
+    bvh.Build();
+    auto buildEnd = std::chrono::high_resolution_clock::now();
+
+    unsigned int hits = 0;
+    auto queryStart = std::chrono::high_resolution_clock::now();
+    for (unsigned int q = 0; q < queryCount; q++)
+    {
+        CurveBVHHit hit;
+        if (bvh.FindClosest(glm::vec2(position(random), position(random)), 3.0f, hit))
+            hits++;
+    }
+    auto queryEnd = std::chrono::high_resolution_clock::now();
+
+    std::cout << "Curve BVH, " << curveCount << " cubics: build " << std::chrono::duration<double, std::milli>(buildEnd - buildStart).count()
+        << " ms, hover query " << std::chrono::duration<double, std::micro>(queryEnd - queryStart).count() / queryCount
+        << " us (" << hits << " of " << queryCount << " queries within 3 units)" << std::endl;
+}
+
+// Retessellates a segmentCount cubic outline with a hole, prints the time and the area error
+static void BenchmarkFillTessellation(unsigned int segmentCount, float tolerance)
+{
+    // Wavy ring of segmentCount cubics around a circular hole, like a large edited shape
+    std::vector<CubicBezier2D> outline;
+    float outerRadius = 1000.0f;
+    float step = glm::two_pi<float>() / segmentCount;
+    auto outerPoint = [&](float angle)
+    {
+        float radius = outerRadius + 20.0f * std::sin(angle * 64.0f);
+        return glm::vec2(std::cos(angle), std::sin(angle)) * radius;
+    };
+    for (unsigned int i = 0; i < segmentCount; i++)
+    {
+        float a0 = i * step;
+        float a1 = (i + 1) * step;
+        glm::vec2 p0 = outerPoint(a0);
+        glm::vec2 p3 = outerPoint(a1);
+        glm::vec2 outward = glm::normalize(outerPoint(a0 + step * 0.5f)) * (i % 2 == 0 ? 1.0f : -1.0f);
+        glm::vec2 points[4] = { p0, glm::mix(p0, p3, 1.0f / 3.0f) + outward, glm::mix(p0, p3, 2.0f / 3.0f) + outward, p3 };
+        outline.push_back(CubicBezier2D(points));
+    }
+
+    FillTessellator tessellator;
+    const unsigned int iterations = 20;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (unsigned int iteration = 0; iteration < iterations; iteration++)
+    {
+        tessellator.Clear();
+        tessellator.BeginContour();
+        for (unsigned int i = 0; i < outline.size(); i++)
+            tessellator.AddCubic(outline[i], tolerance);
+
+        // Hole in the opposite direction
+        tessellator.BeginContour();
+        for (unsigned int i = 0; i < 256; i++)
+        {
+            float angle = -glm::two_pi<float>() * i / 256.0f;
+            tessellator.AddPoint(glm::vec2(std::cos(angle), std::sin(angle)) * 400.0f);
+        }
+        tessellator.Tessellate(FillRule::NonZero);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    // The triangles must cover exactly the ring between the two polygons
+    auto polygonArea = [&](unsigned int first, unsigned int last)
+    {
+        double area = 0.0;
+        for (unsigned int i = first; i < last; i++)
+        {
+            const glm::vec2& a = tessellator.GetContourPoints()[i];
+            const glm::vec2& b = tessellator.GetContourPoints()[i + 1 < last ? i + 1 : first];
+            area += static_cast<double>(a.x) * b.y - static_cast<double>(b.x) * a.y;
+        }
+        return std::abs(area) * 0.5;
+    };
+    unsigned int holeStart = tessellator.GetContourStarts()[1];
+    double expected = polygonArea(0, holeStart) - polygonArea(holeStart, tessellator.GetContourPoints().size());
+
+    double covered = 0.0;
+    const std::vector<float>& vertices = tessellator.GetVertices();
+    const std::vector<unsigned int>& indices = tessellator.GetIndices();
+    for (unsigned int i = 0; i < indices.size(); i += 3)
+    {
+        glm::vec2 a(vertices[indices[i] * 2], vertices[indices[i] * 2 + 1]);
+        glm::vec2 b(vertices[indices[i + 1] * 2], vertices[indices[i + 1] * 2 + 1]);
+        glm::vec2 c(vertices[indices[i + 2] * 2], vertices[indices[i + 2] * 2 + 1]);
+        covered += 0.5 * ((b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x));
+    }
+
+    std::cout << "Fill tessellation, " << segmentCount << " cubics (" << tessellator.GetContourPoints().size() << " points): "
+        << std::chrono::duration<double, std::milli>(end - start).count() / iterations << " ms, "
+        << tessellator.GetTriangleCount() << " triangles, area error " << std::abs(covered - expected) / expected << std::endl;
+}
+
+// The overdraw pass only reorders, its output must hold every input triangle exactly once, also
+// when the leading triangles are no cache restart
+static void CheckOverdrawOrder()
+{
+    // Position + normal grid of gridSize x gridSize quads, cache optimized like OptimizeMesh does
+    const unsigned int gridSize = 32;
+    std::vector<float> vertices;
+    for (unsigned int y = 0; y <= gridSize; y++)
+    {
+        for (unsigned int x = 0; x <= gridSize; x++)
+        {
+            float height = std::sin(x * 0.3f) * std::cos(y * 0.2f);
+            vertices.insert(vertices.end(), { (float)x, (float)y, height, 0.0f, 0.0f, 1.0f });
+        }
+    }
+    std::vector<unsigned int> grid;
+    for (unsigned int y = 0; y < gridSize; y++)
+    {
+        for (unsigned int x = 0; x < gridSize; x++)
+        {
+            unsigned int i = y * (gridSize + 1) + x;
+            grid.insert(grid.end(), { i, i + 1, i + gridSize + 1, i + 1, i + gridSize + 2, i + gridSize + 1 });
+        }
+    }
+    OptimizeVertexCache(grid, vertices.size() / 6);
+
+    struct Case
+    {
+        const char* Name;
+        std::vector<unsigned int> Indices;
+    };
+    std::vector<Case> cases;
+    cases.push_back({ "cache optimized grid", grid });
+    cases.push_back({ "degenerate first triangle", grid });
+    cases.back().Indices.insert(cases.back().Indices.begin(), { 0, 0, 1 });
+    cases.push_back({ "no triangle with 3 misses", { 0, 0, 1, 1, 1, 2, 2, 2, 3, 0, 1, 2 } });
+
+    unsigned int failures = 0;
+    for (const Case& test : cases)
+    {
+        std::vector<unsigned int> indices = test.Indices;
+        OptimizeOverdraw(indices, vertices, 6);
+
+        auto sortedTriangles = [](const std::vector<unsigned int>& source)
+        {
+            std::vector<std::vector<unsigned int>> triangles;
+            for (unsigned int i = 0; i + 2 < source.size(); i += 3)
+                triangles.push_back({ source[i], source[i + 1], source[i + 2] });
+            std::sort(triangles.begin(), triangles.end());
+            return triangles;
+        };
+        if (indices.size() != test.Indices.size() || sortedTriangles(indices) != sortedTriangles(test.Indices))
+        {
+            std::cout << "Overdraw order check failed: " << test.Name << " gives " << indices.size() / 3 << " triangles for "
+                << test.Indices.size() / 3 << ", not a permutation" << std::endl;
+            failures++;
+        }
+    }
+    std::cout << "Overdraw order checks: " << failures << " failures" << std::endl;
+}
+
+// Contours the sweep got wrong before, each must cover exactly the expected area with both rules
+static void CheckFillTessellation()
+{
+    struct Case
+    {
+        const char* Name;
+        std::vector<float> Points;
+        double Area;
+    };
+    // A diagonal walked out and back along part of a longer collinear edge from the same vertex,
+    // the longer edge has to be split at the far end of the shorter one wherever the contour starts
+    const Case cases[] =
+    {
+        { "collinear edges from one vertex", { 4, 4, 0, 0, 5, 0, 5, 5, 0, 0 }, 12.5 },
+        { "collinear edges from one vertex, other start", { 0, 0, 5, 0, 5, 5, 0, 0, 4, 4 }, 12.5 },
+    };
+
+    unsigned int failures = 0;
+    FillTessellator tessellator;
+    for (const Case& test : cases)
+    {
+        for (FillRule rule : { FillRule::NonZero, FillRule::EvenOdd })
+        {
+            tessellator.Clear();
+            tessellator.AddContour(test.Points.data(), test.Points.size() / 2);
+            tessellator.Tessellate(rule);
+
+            double covered = 0.0;
+            const std::vector<float>& vertices = tessellator.GetVertices();
+            const std::vector<unsigned int>& indices = tessellator.GetIndices();
+            for (unsigned int i = 0; i < indices.size(); i += 3)
+            {
+                glm::vec2 a(vertices[indices[i] * 2], vertices[indices[i] * 2 + 1]);
+                glm::vec2 b(vertices[indices[i + 1] * 2], vertices[indices[i + 1] * 2 + 1]);
+                glm::vec2 c(vertices[indices[i + 2] * 2], vertices[indices[i + 2] * 2 + 1]);
+                covered += std::abs(0.5 * ((b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x)));
+            }
+
+            if (std::abs(covered - test.Area) > 1e-4 * test.Area)
+            {
+                std::cout << "Fill tessellation check failed: " << test.Name << (rule == FillRule::NonZero ? " (non zero)" : " (even odd)")
+                    << " covers " << covered << " instead of " << test.Area << std::endl;
+                failures++;
+            }
+        }
+    }
+    std::cout << "Fill tessellation checks: " << failures << " failures" << std::endl;
+}
+
+// Per vertex recursive De Casteljau with finite difference normals against the tables,
+// single and multi threaded, on a resolution x resolution bicubic grid
+static void BenchmarkPatchEvaluation(unsigned int resolution)
+{
+    // Same bicubic net as BezierSurface::CreateDefaultSurface
+    std::vector<std::vector<glm::vec3>> nested(4, std::vector<glm::vec3>(4));
+    std::vector<glm::vec3> net(16);
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        for (unsigned int j = 0; j < 4; j++)
+        {
+            float z = ((i == 0 || i == 3) && (j == 0 || j == 3)) ? 0.5f : (i == 2 && j == 2) ? -0.8f :
+                ((i == 2 && (j == 0 || j == 3)) || (j == 2 && (i == 0 || i == 3))) ? 0.8f : 0.0f;
+            nested[i][j] = glm::vec3((i / 3.0f - 0.5f) * 2.0f, (j / 3.0f - 0.5f) * 2.0f, z);
+            net[i * 4 + j] = nested[i][j];
+        }
+    }
+
+    unsigned int vertexCount = (resolution + 1) * (resolution + 1);
+    std::vector<float> reference(vertexCount * PatchEvaluator::s_VertexStride);
+    std::vector<float> vertices(vertexCount * PatchEvaluator::s_VertexStride);
+
+    // Five recursive evaluations per vertex (point and finite differences), as Generate did
+    auto referenceStart = std::chrono::high_resolution_clock::now();
+    const float delta = 0.01f;
+    for (unsigned int i = 0; i <= resolution; i++)
+    {
+        float u = (float)i / resolution;
+        for (unsigned int j = 0; j <= resolution; j++)
+        {
+            float v = (float)j / resolution;
+            glm::vec3 point = CalculatePointRecursive(nested, u, v);
+            glm::vec3 du = u + delta <= 1.0f ? CalculatePointRecursive(nested, u + delta, v) - point : point - CalculatePointRecursive(nested, u - delta, v);
+            glm::vec3 dv = v + delta <= 1.0f ? CalculatePointRecursive(nested, u, v + delta) - point : point - CalculatePointRecursive(nested, u, v - delta);
+            glm::vec3 normal = glm::normalize(glm::cross(du, dv));
+
+            float* vertex = &reference[(i * (resolution + 1) + j) * PatchEvaluator::s_VertexStride];
+            vertex[0] = point.x; vertex[1] = point.y; vertex[2] = point.z;
+            vertex[3] = normal.x; vertex[4] = normal.y; vertex[5] = normal.z;
+        }
+    }
+    auto referenceEnd = std::chrono::high_resolution_clock::now();
+
+    PatchEvaluator evaluator;
+    auto buildStart = std::chrono::high_resolution_clock::now();
+    evaluator.Build(3, 3, resolution, resolution);
+    auto buildEnd = std::chrono::high_resolution_clock::now();
+
+    const int iterations = 10;
+    auto time = [&](bool parallel)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int iteration = 0; iteration < iterations; iteration++)
+            evaluator.Evaluate(net.data(), vertices.data(), parallel);
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+    };
+    double single = time(false);
+    double threaded = time(true);
+
+    float positionError = 0.0f, normalAngle = 0.0f;
+    for (unsigned int v = 0; v < vertexCount; v++)
+    {
+        const float* a = &reference[v * PatchEvaluator::s_VertexStride];
+        const float* b = &vertices[v * PatchEvaluator::s_VertexStride];
+        positionError = std::max(positionError, glm::length(glm::vec3(a[0], a[1], a[2]) - glm::vec3(b[0], b[1], b[2])));
+        float cosine = glm::clamp(glm::dot(glm::vec3(a[3], a[4], a[5]), glm::vec3(b[3], b[4], b[5])), -1.0f, 1.0f);
+        normalAngle = std::max(normalAngle, glm::degrees(std::acos(cosine)));
+    }
+
+    std::cout << "Bezier patch " << resolution << "x" << resolution << ": recursive " << std::chrono::duration<double, std::milli>(referenceEnd - referenceStart).count()
+        << " ms, tables " << std::chrono::duration<double, std::milli>(buildEnd - buildStart).count() << " ms + " << single << " ms ("
+        << threaded << " ms on " << std::max(1u, std::thread::hardware_concurrency()) << " threads), max position error " << positionError
+        << ", max normal difference to finite differences " << normalAngle << " deg" << std::endl;
+
+    // Single point queries (picking, LOD error), three in place evaluations against one analytic pass
+    auto pointAt = [&](float u, float v)
+    {
+        glm::vec3 column[4], row[4];
+        for (unsigned int b = 0; b < 4; b++)
+        {
+            for (unsigned int a = 0; a < 4; a++)
+                row[a] = net[a * 4 + b];
+            column[b] = DeCasteljauInPlace(row, 4, u);
+        }
+        return DeCasteljauInPlace(column, 4, v);
+    };
+    glm::vec3 sum(0.0f);
+    auto differencesStart = std::chrono::high_resolution_clock::now();
+    for (unsigned int i = 0; i <= resolution; i++)
+    {
+        for (unsigned int j = 0; j <= resolution; j++)
+        {
+            float u = (float)i / resolution, v = (float)j / resolution;
+            glm::vec3 point = pointAt(u, v);
+            glm::vec3 du = u + delta <= 1.0f ? pointAt(u + delta, v) - point : point - pointAt(u - delta, v);
+            glm::vec3 dv = v + delta <= 1.0f ? pointAt(u, v + delta) - point : point - pointAt(u, v - delta);
+            sum += point + glm::normalize(glm::cross(du, dv));
+        }
+    }
+    auto differencesEnd = std::chrono::high_resolution_clock::now();
+    for (unsigned int i = 0; i <= resolution; i++)
+    {
+        for (unsigned int j = 0; j <= resolution; j++)
+        {
+            SurfaceSample sample = PatchEvaluator::EvaluatePoint(net.data(), 4, 4, (float)i / resolution, (float)j / resolution);
+            sum += sample.Point + sample.Normal;
+        }
+    }
+    auto analyticEnd = std::chrono::high_resolution_clock::now();
+
+    std::cout << "Bezier patch point queries: finite differences " << std::chrono::duration<double, std::milli>(differencesEnd - differencesStart).count()
+        << " ms, analytic " << std::chrono::duration<double, std::milli>(analyticEnd - differencesEnd).count() << " ms (checksum " << sum.x + sum.y + sum.z << ")" << std::endl;
+}
+
+// Per move cost of ApplyControlPointDelta against a full rebuild while one point is dragged
+static void BenchmarkPatchDrag(unsigned int resolution, unsigned int moveCount)
+{
+    std::vector<glm::vec3> net(16);
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        for (unsigned int j = 0; j < 4; j++)
+            net[i * 4 + j] = glm::vec3((i / 3.0f - 0.5f) * 2.0f, (j / 3.0f - 0.5f) * 2.0f, (i == 1 && j == 2) ? 0.8f : 0.0f);
+    }
+
+    PatchEvaluator evaluator;
+    evaluator.Build(3, 3, resolution, resolution);
+    std::vector<float> vertices(evaluator.GetVertexCount() * PatchEvaluator::s_VertexStride);
+    std::vector<float> reference(vertices.size());
+    std::vector<float> frame(evaluator.GetFrameSize());
+    std::vector<unsigned int> indices;
+    evaluator.Evaluate(net.data(), vertices.data(), true, frame.data());
+
+    // Dragging P_12 in small circles, once as rank one updates, once the way Generate rebuilds
+    // everything (vertices and indices) for every move
+    double incremental = 0.0, rebuild = 0.0;
+    for (unsigned int move = 0; move < moveCount; move++)
+    {
+        float angle = move * 0.05f;
+        glm::vec3 delta = glm::vec3(std::cos(angle), std::sin(angle), 0.0f) * 0.01f;
+        net[1 * 4 + 2] += delta;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        evaluator.ApplyControlPointDelta(net.data(), 1, 2, delta, frame.data(), vertices.data());
+        auto middle = std::chrono::high_resolution_clock::now();
+
+        evaluator.Evaluate(net.data(), reference.data());
+        indices.clear();
+        for (unsigned int i = 0; i < resolution; i++)
+        {
+            for (unsigned int j = 0; j < resolution; j++)
+            {
+                unsigned int p0 = i * (resolution + 1) + j, p2 = p0 + resolution + 1;
+                indices.insert(indices.end(), { p0, p2, p0 + 1, p0 + 1, p2, p2 + 1 });
+            }
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+
+        incremental += std::chrono::duration<double, std::milli>(middle - start).count();
+        rebuild += std::chrono::duration<double, std::milli>(end - middle).count();
+    }
+
+    float drift = 0.0f;
+    for (size_t v = 0; v < vertices.size(); v++)
+        drift = std::max(drift, std::abs(vertices[v] - reference[v]));
+
+    std::cout << "Bezier patch drag " << resolution << "x" << resolution << ": rank one update " << incremental / moveCount
+        << " ms, full evaluation + indices " << rebuild / moveCount << " ms per move, max difference after " << moveCount
+        << " moves " << drift << std::endl;
+}
+
+// Closed surface of bulging patches, prints the time and the number of open (cracked) edges
+static void BenchmarkPatchTessellation(unsigned int patchesPerSide, float tolerance)
+{
+    // A bumpy rounded cube, 6 faces of patchesPerSide^2 bicubic patches. Control points come from
+    // integer lattice coordinates so patches of neighbouring faces get bit identical edges
+    unsigned int side = patchesPerSide * 3;
+    auto latticePoint = [side](int x, int y, int z)
+    {
+        glm::vec3 cube = glm::vec3(x, y, z) / (float)side * 2.0f - 1.0f;
+        glm::vec3 sphere = glm::normalize(cube);
+        float bump = 0.05f * std::sin(9.0f * sphere.x) * std::sin(7.0f * sphere.y) * (1.0f + sphere.z);
+        return glm::mix(cube, sphere, 0.7f) + sphere * bump;
+    };
+
+    std::vector<glm::vec3> controlPoints;
+    for (unsigned int face = 0; face < 6; face++)
+    {
+        unsigned int axis = face / 2;
+        int level = (face % 2) ? (int)side : 0;
+        for (unsigned int pu = 0; pu < patchesPerSide; pu++)
+        {
+            for (unsigned int pv = 0; pv < patchesPerSide; pv++)
+            {
+                for (unsigned int i = 0; i < 4; i++)
+                {
+                    for (unsigned int j = 0; j < 4; j++)
+                    {
+                        int s = pu * 3 + i, t = pv * 3 + j;
+                        int coordinates[3];
+                        coordinates[axis] = level;
+                        coordinates[(axis + 1) % 3] = (face % 2) ? s : t;
+                        coordinates[(axis + 2) % 3] = (face % 2) ? t : s;
+                        controlPoints.push_back(latticePoint(coordinates[0], coordinates[1], coordinates[2]));
+                    }
+                }
+            }
+        }
+    }
+    unsigned int patchCount = controlPoints.size() / 16; // Bicubic patches
+
+    PatchTessellator tessellator;
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    auto time = [&](bool parallel)
+    {
+        const int iterations = 5;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int iteration = 0; iteration < iterations; iteration++)
+            tessellator.Tessellate(controlPoints.data(), patchCount, tolerance, 64, vertices, indices, parallel);
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+    };
+    double single = time(false);
+    double threaded = time(true);
+
+    // A closed surface without cracks uses every undirected edge in exactly two triangles
+    std::unordered_map<unsigned long long, unsigned int> edgeUses;
+    for (size_t t = 0; t < indices.size(); t += 3)
+    {
+        for (unsigned int k = 0; k < 3; k++)
+        {
+            unsigned long long a = indices[t + k], b = indices[t + (k + 1) % 3];
+            edgeUses[std::min(a, b) << 32 | std::max(a, b)]++;
+        }
+    }
+    unsigned int openEdges = 0;
+    for (const auto& edge : edgeUses)
+        openEdges += edge.second != 2 ? 1 : 0;
+
+    unsigned int minResolution = ~0u, maxResolution = 0;
+    for (unsigned int p = 0; p < patchCount; p++)
+    {
+        minResolution = std::min({ minResolution, tessellator.GetPatchResolutionU(p), tessellator.GetPatchResolutionV(p) });
+        maxResolution = std::max({ maxResolution, tessellator.GetPatchResolutionU(p), tessellator.GetPatchResolutionV(p) });
+    }
+
+    std::cout << "Bezier patch mesh: " << patchCount << " patches -> " << vertices.size() / PatchEvaluator::s_VertexStride << " vertices, "
+        << indices.size() / 3 << " triangles (edge resolutions " << minResolution << " to " << maxResolution << ") in " << single << " ms ("
+        << threaded << " ms on " << std::max(1u, std::thread::hardware_concurrency()) << " threads), open edges " << openEdges << std::endl;
+}
+
+// A half flat, half rippled patch seen from further and further away, prints the triangle count and time
+// against the uniform grid of the finest level and the number of cracked edges inside the patch
+static void BenchmarkAdaptiveTessellation(unsigned int tileCount, float maxPixelError)
+{
+    // Degree 6 patch over [-4, 4]^2, flat on one half and a rippled bump on the other
+    const unsigned int count = 7;
+    std::vector<glm::vec3> net(count * count);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        for (unsigned int j = 0; j < count; j++)
+        {
+            float x = (float)i / (count - 1), y = (float)j / (count - 1);
+            float bump = x > 0.5f ? std::sin(12.0f * x) * std::cos(9.0f * y) : 0.0f;
+            net[i * count + j] = glm::vec3(x * 8.0f - 4.0f, y * 8.0f - 4.0f, bump);
+        }
+    }
+
+    // 1080 pixels high with a 45 degree field of view, looking down from above one corner
+    TessellationView view;
+    view.Model = glm::mat4(1.0f);
+    view.PixelsPerUnit = 1080.0f / (2.0f * std::tan(glm::radians(45.0f) * 0.5f));
+    view.MaxPixelError = maxPixelError;
+
+    AdaptivePatchTessellator tessellator(tileCount);
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    for (float height : { 1.0f, 4.0f, 16.0f, 64.0f })
+    {
+        view.CameraPosition = glm::vec3(-4.0f, -4.0f, height);
+
+        const int iterations = 20;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int iteration = 0; iteration < iterations; iteration++)
+        {
+            tessellator.ChooseLevels(net.data(), count, count, 0.0f, &view);
+            tessellator.Tessellate(vertices, indices);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        double adaptive = std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+
+        // A uniform grid needs the finest level of any tile everywhere
+        unsigned int finestU = 1, finestV = 1;
+        for (unsigned int a = 0; a < tileCount; a++)
+        {
+            for (unsigned int b = 0; b < tileCount; b++)
+            {
+                finestU = std::max(finestU, tessellator.GetTileLevelU(a, b));
+                finestV = std::max(finestV, tessellator.GetTileLevelV(a, b));
+            }
+        }
+        unsigned int uniformTriangles = finestU * finestV * tileCount * tileCount * 2;
+
+        // Inside the patch every undirected edge belongs to two triangles, the border sides to one
+        std::unordered_map<unsigned long long, unsigned int> edgeUses;
+        for (size_t t = 0; t < indices.size(); t += 3)
+        {
+            for (unsigned int k = 0; k < 3; k++)
+            {
+                unsigned long long p = indices[t + k], q = indices[t + (k + 1) % 3];
+                edgeUses[std::min(p, q) << 32 | std::max(p, q)]++;
+            }
+        }
+        // Border sides belong to one tile and keep its levels
+        unsigned int borderEdges = 0;
+        for (unsigned int k = 0; k < tileCount; k++)
+        {
+            borderEdges += tessellator.GetTileLevelV(0, k) + tessellator.GetTileLevelV(tileCount - 1, k);
+            borderEdges += tessellator.GetTileLevelU(k, 0) + tessellator.GetTileLevelU(k, tileCount - 1);
+        }
+        unsigned int openEdges = 0, overusedEdges = 0;
+        for (const auto& edge : edgeUses)
+        {
+            openEdges += edge.second == 1 ? 1 : 0;
+            overusedEdges += edge.second > 2 ? 1 : 0;
+        }
+
+        std::cout << "Adaptive patch tessellation: camera at " << height << " -> " << indices.size() / 3 << " triangles ("
+            << uniformTriangles << " uniform) in " << adaptive << " ms, cracked edges "
+            << (openEdges > borderEdges ? openEdges - borderEdges : borderEdges - openEdges) + overusedEdges << std::endl;
+    }
+}
+
+// Picks and box selections on a pointsPerSide^2 net against linear scans, plus the cost of a move
+static void BenchmarkControlPointPicking(unsigned int pointsPerSide, unsigned int queryCount)
+{
+    // A wavy net over [-1, 1]^2 seen from above, 1080 pixels high with a 45 degree field of view
+    std::vector<glm::vec3> points;
+    for (unsigned int i = 0; i < pointsPerSide; i++)
+    {
+        for (unsigned int j = 0; j < pointsPerSide; j++)
+        {
+            float x = (float)i / (pointsPerSide - 1) * 2.0f - 1.0f;
+            float y = (float)j / (pointsPerSide - 1) * 2.0f - 1.0f;
+            points.push_back(glm::vec3(x, y, 0.2f * std::sin(5.0f * x) * std::cos(4.0f * y)));
+        }
+    }
+    unsigned int pointCount = points.size();
+
+    glm::vec3 eye(0.3f, -0.4f, 3.0f);
+    glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
+    float maxSlope = 5.0f * 2.0f * std::tan(glm::radians(45.0f) * 0.5f) / 1080.0f; // 5 pixels
+
+    ControlPointBVH bvh;
+    auto buildStart = std::chrono::high_resolution_clock::now();
+    bvh.Build(points.data(), pointCount);
+    auto buildEnd = std::chrono::high_resolution_clock::now();
+
+    std::mt19937 random(5);
+    std::uniform_real_distribution<float> target(-1.1f, 1.1f);
+    std::vector<glm::vec3> directions(queryCount);
+    for (glm::vec3& direction : directions)
+        direction = glm::normalize(glm::vec3(target(random), target(random), 0.0f) - eye);
+
+    auto linearPick = [&](const glm::vec3& direction, unsigned int& index)
+    {
+        float bestSlope = maxSlope, bestDistance = std::numeric_limits<float>::max();
+        bool found = false;
+        for (unsigned int p = 0; p < pointCount; p++)
+        {
+            glm::vec3 offset = points[p] - eye;
+            float along = glm::dot(offset, direction);
+            if (along <= 0.0f)
+                continue;
+            float slope = std::sqrt(std::max(glm::dot(offset, offset) - along * along, 0.0f)) / along;
+            if (slope < bestSlope || (slope == bestSlope && along < bestDistance))
+            {
+                bestSlope = slope;
+                bestDistance = along;
+                index = p;
+                found = true;
+            }
+        }
+        return found;
+    };
+
+    // Picks, the tree has to agree with the scan
+    unsigned int hits = 0, mismatches = 0;
+    std::vector<unsigned int> treeResults(queryCount, ~0u), linearResults(queryCount, ~0u);
+    auto pickStart = std::chrono::high_resolution_clock::now();
+    for (unsigned int q = 0; q < queryCount; q++)
+        hits += bvh.FindClosestToRay(eye, directions[q], maxSlope, treeResults[q]) ? 1 : 0;
+    auto pickEnd = std::chrono::high_resolution_clock::now();
+    unsigned int linearQueries = std::min(queryCount, 1000u);
+    auto linearStart = std::chrono::high_resolution_clock::now();
+    for (unsigned int q = 0; q < linearQueries; q++)
+        linearPick(directions[q], linearResults[q]);
+    auto linearEnd = std::chrono::high_resolution_clock::now();
+    for (unsigned int q = 0; q < linearQueries; q++)
+        mismatches += treeResults[q] != linearResults[q] ? 1 : 0;
+
+    // Box selections of up to a fifth of the screen, through the frustum of the rectangle
+    std::uniform_real_distribution<float> corner(-1.0f, 0.6f);
+    std::uniform_real_distribution<float> extent(0.05f, 0.4f);
+    std::vector<Frustum> frustums;
+    for (unsigned int q = 0; q < queryCount / 10; q++)
+    {
+        glm::vec2 low(corner(random), corner(random));
+        glm::vec2 high = low + glm::vec2(extent(random), extent(random));
+        glm::mat4 pick = glm::scale(glm::mat4(1.0f), glm::vec3(2.0f / (high.x - low.x), 2.0f / (high.y - low.y), 1.0f)) *
+            glm::translate(glm::mat4(1.0f), glm::vec3(-(low + high) * 0.5f, 0.0f));
+        frustums.push_back(Frustum(pick * projection * view));
+    }
+
+    std::vector<unsigned int> selected;
+    size_t selectedTotal = 0;
+    std::vector<size_t> treeCounts;
+    auto selectStart = std::chrono::high_resolution_clock::now();
+    for (const Frustum& frustum : frustums)
+    {
+        bvh.FindInFrustum(frustum, selected);
+        selectedTotal += selected.size();
+        treeCounts.push_back(selected.size());
+    }
+    auto selectEnd = std::chrono::high_resolution_clock::now();
+    auto scanStart = std::chrono::high_resolution_clock::now();
+    for (unsigned int f = 0; f < frustums.size(); f++)
+    {
+        size_t count = 0;
+        for (const glm::vec3& point : points)
+            count += frustums[f].IntersectsSphere(point, 0.0f) ? 1 : 0;
+        mismatches += count != treeCounts[f] ? 1 : 0;
+    }
+    auto scanEnd = std::chrono::high_resolution_clock::now();
+
+    // Dragging points around, each move refits a leaf and its ancestors
+    std::uniform_int_distribution<unsigned int> anyPoint(0, pointCount - 1);
+    std::uniform_real_distribution<float> nudge(-0.01f, 0.01f);
+    auto moveStart = std::chrono::high_resolution_clock::now();
+    for (unsigned int m = 0; m < queryCount; m++)
+    {
+        unsigned int p = anyPoint(random);
+        points[p] += glm::vec3(nudge(random), nudge(random), nudge(random));
+        bvh.Update(p, points[p]);
+    }
+    auto moveEnd = std::chrono::high_resolution_clock::now();
+    for (unsigned int q = 0; q < linearQueries; q++)
+    {
+        unsigned int treeIndex = ~0u, linearIndex = ~0u;
+        bvh.FindClosestToRay(eye, directions[q], maxSlope, treeIndex);
+        linearPick(directions[q], linearIndex);
+        mismatches += treeIndex != linearIndex ? 1 : 0;
+    }
+
+    auto micros = [](std::chrono::high_resolution_clock::time_point start, std::chrono::high_resolution_clock::time_point end, size_t count)
+    {
+        return std::chrono::duration<double, std::micro>(end - start).count() / std::max<size_t>(count, 1);
+    };
+    std::cout << "Control point BVH, " << pointCount << " points: build " << std::chrono::duration<double, std::milli>(buildEnd - buildStart).count()
+        << " ms, pick " << micros(pickStart, pickEnd, queryCount) << " us (linear " << micros(linearStart, linearEnd, linearQueries) << " us, "
+        << hits << " of " << queryCount << " within 5 px), box select " << micros(selectStart, selectEnd, frustums.size()) << " us (linear "
+        << micros(scanStart, scanEnd, frustums.size()) << " us, " << selectedTotal / std::max<size_t>(frustums.size(), 1) << " points), move "
+        << micros(moveStart, moveEnd, queryCount) << " us, mismatches " << mismatches << std::endl;
+}
+
+int main()
+{
+    std::cout << "CPU Benchmarks" << std::endl;
+
+    CheckOverdrawOrder();
+    BenchmarkFrustumCulling(1000000, 100);
+    BenchmarkBezierEvaluation(100, 2000);
+    BenchmarkCameraPath(60);
+    BenchmarkCurveBatch(100000, 16);
+    BenchmarkCurveFitting(50000, 0.5f);
+    BenchmarkCurveBVH(100000, 10000);
+    BenchmarkFillTessellation(10000, 0.25f);
+    CheckFillTessellation();
+    BenchmarkPatchEvaluation(512);
+    BenchmarkPatchDrag(256, 600);
+    BenchmarkPatchTessellation(24, 0.0001f);
+    BenchmarkAdaptiveTessellation(8, 1.0f);
+    BenchmarkControlPointPicking(256, 10000);
+
+    return 0;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "PatchEvaluator.h"
+
+// Where a patch is seen from, for screen space tolerances
+struct TessellationView
+{
+    glm::mat4 Model;          // Control point space to world space
+    glm::vec3 CameraPosition; // World space
+    float PixelsPerUnit;      // Pixels covered by one world unit at distance 1, viewportHeight / (2 tan(fov / 2))
+    float MaxPixelError;
+};
+
+/**
+ * Tessellates one Bezier patch with subdivision levels that follow its shape and its size on screen
+ * The (u, v) domain is cut into a fixed grid of tiles. Each tile gets the control net of its part of
+ * the patch (De Casteljau subdivision) and levels along u and v from Wang's formula on that net, with
+ * a tolerance that is the smaller of the given one and the world size of MaxPixelError pixels at the
+ * tile's distance from the camera. A tile side shared by two tiles is sampled once at the larger of
+ * their levels. Tiles whose sides all match their own levels are plain grids, the others keep a grid
+ * inside one step from the border and stitch each side to it with a strip of triangles, so
+ * neighbouring tiles meet at the same vertices and there are no T-junctions.
+ */
+class AdaptivePatchTessellator
+{
+private:
+    struct Tile
+    {
+        unsigned int LevelU;        // From the flatness of the tile net and its distance
+        unsigned int LevelV;
+        unsigned int InnerU;        // Grid inside the tile, at least 2 when stitched
+        unsigned int InnerV;
+        unsigned int FirstInterior; // Vertex id of the first inner sample
+        unsigned int FirstIndex;
+        unsigned int Evaluator;     // In m_Evaluators
+        bool Stitched;              // Some side differs from the levels inside
+    };
+
+    std::vector<glm::vec3> m_Net;
+    unsigned int m_CountU;
+    unsigned int m_CountV;
+    unsigned int m_TileCount; // Per side
+
+    // Control nets of the tiles, tile (a, b) covers u in [a, a + 1] / m_TileCount, v in [b, b + 1] / m_TileCount
+    std::vector<glm::vec3> m_TileNets;
+    std::vector<Tile> m_Tiles;  // a * m_TileCount + b
+
+    // Levels of the tile sides along v (u = a / m_TileCount, index a * m_TileCount + b) and along u
+    // (v = b / m_TileCount, index b * m_TileCount + a), with the vertex id of their first inner sample
+    std::vector<unsigned int> m_LevelsAlongV;
+    std::vector<unsigned int> m_LevelsAlongU;
+    std::vector<unsigned int> m_FirstAlongV;
+    std::vector<unsigned int> m_FirstAlongU;
+
+    // Basis tables of every tile level pair in use
+    std::vector<PatchEvaluator> m_Evaluators;
+
+    unsigned int m_VertexCount;
+    unsigned int m_IndexCount;
+
+    // scratch holds 3 * max(countU, countV) points
+    void ExtractTileNet(unsigned int a, unsigned int b, glm::vec3* tileNet, glm::vec3* scratch) const;
+    void AssignVertices();
+
+    unsigned int GetCornerId(unsigned int a, unsigned int b) const { return a * (m_TileCount + 1) + b; }
+    unsigned int GetAlongVId(unsigned int a, unsigned int b, unsigned int k) const;
+    unsigned int GetAlongUId(unsigned int b, unsigned int a, unsigned int k) const;
+
+    void EvaluateBorders(float* vertices) const;
+    void TessellateTiles(unsigned int first, unsigned int last, float* vertices, unsigned int* indices) const;
+
+public:
+    // Segments along one side of a tile at most
+    static const unsigned int s_MaxLevel = 64;
+
+    AdaptivePatchTessellator(unsigned int tileCount = 8);
+    ~AdaptivePatchTessellator();
+
+    // net holds countU x countV points, row major with u as the row. Levels of every tile for the
+    // tolerance (units of the control points, 0 for none) and the view (nullptr for none), true when
+    // any level differs from the previous call, so the mesh only has to be rebuilt then
+    bool ChooseLevels(const glm::vec3* net, unsigned int countU, unsigned int countV, float tolerance, const TessellationView* view);
+
+    // Mesh of the last ChooseLevels net at its levels, vertices get x, y, z, nx, ny, nz
+    void Tessellate(std::vector<float>& vertices, std::vector<unsigned int>& indices, bool parallel = true);
+
+    unsigned int GetTileCount() const { return m_TileCount; }
+    unsigned int GetTileLevelU(unsigned int a, unsigned int b) const { return m_Tiles[a * m_TileCount + b].LevelU; }
+    unsigned int GetTileLevelV(unsigned int a, unsigned int b) const { return m_Tiles[a * m_TileCount + b].LevelV; }
+};
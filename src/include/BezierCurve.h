@@ -3,36 +3,176 @@
 #include <vector>
 #include <glm/glm.hpp>
 
-class BezierCurve
+#include "BezierEvaluation.h"
+
+/**
+ * How the control points are joined
+ * Bezier is one curve of degree n - 1, BSpline is a chain of uniform cubic B-spline segments
+ * (one per 4 consecutive points) so editing a point only touches the 4 segments around it
+ */
+enum class CurveMode
+{
+    Bezier,
+    BSpline
+};
+
+/**
+ * Runtime degree Bezier / B-spline curve over any glm vector type
+ * BezierCurve (2D) and BezierCurve3D (camera paths) are instantiated in BezierCurve.cpp
+ */
+template<typename Point>
+class BezierCurveT
 {
 private:
-    std::vector<glm::vec2> m_ControlPoints;
-    std::vector<float> m_CurvePoints; // Flattened array of x,y coordinates
-    unsigned int m_Resolution;
+    static const unsigned int s_Dimensions = Point::length();
+
+    std::vector<Point> m_ControlPoints;
+    CurveMode m_Mode;
+    std::vector<float> m_CurvePoints; // Flattened array of coordinates, s_Dimensions per point
+    unsigned int m_Resolution; // Samples of the whole curve, or of each segment in BSpline mode
+
+    // Samples of m_CurvePoints changed since the last ClearDirtyRange, [begin, end) in points
+    unsigned int m_DirtyBegin;
+    unsigned int m_DirtyEnd;
+
+    // Cubic weights shared by all B-spline segments, m_CurvePoints holds resolution samples per
+    // segment only while m_SegmentLayout is set (uniform length / adaptive resampling break it)
+    BernsteinTable m_SegmentTable;
+    bool m_SegmentLayout;
+
+    // Bernstein weights for the uniform samples of UpdateCurve, rebuilt when the degree changes
+    BernsteinTable m_BasisTable;
+
+    // Adaptive flattening, 0 keeps the fixed m_Resolution sampling
+    float m_FlatteningTolerance;
+    std::vector<Point> m_SubdivisionStack;     // Halves waiting to be flattened, reused between updates
+    std::vector<unsigned int> m_SubdivisionDepths;
+
+    // Arc length parameterization, cumulative length at uniform t knots, rebuilt after an edit
+    std::vector<float> m_ArcLengths;
+    std::vector<Point> m_Hodograph; // Control points of the derivative curve
+    bool m_ArcLengthDirty;
 
 public:
-    BezierCurve(unsigned int resolution = 100);
-    ~BezierCurve();
+    BezierCurveT(unsigned int resolution = 100);
+    ~BezierCurveT();
+
+    void AddControlPoint(const Point& point);
 
-    void AddControlPoint(const glm::vec2& point);
+    // Move a point, only the segments using it are resampled in BSpline mode
+    void SetControlPoint(unsigned int index, const Point& point);
 
     void ClearControlPoints();
 
     void UpdateCurve();
 
+    void SetMode(CurveMode mode);
+    CurveMode GetMode() const { return m_Mode; }
+    unsigned int GetSegmentCount() const;
+
+    // Bezier control points (4) of B-spline segment i
+    void GetSegmentPoints(unsigned int segment, Point* points) const;
+
+    // Range of m_CurvePoints to upload since the last clear, e.g. with VertexBuffer::UpdateData
+    // at offset firstPoint * 2 * sizeof(float) (or a full upload when the point count grew)
+    void GetDirtyRange(unsigned int& firstPoint, unsigned int& pointCount) const;
+    void ClearDirtyRange();
+
+    // Max distance between the curve and its polyline, in the units of the control points
+    // (screen units for UI / vector paths), 0 goes back to uniform sampling, Bezier mode only
+    void SetFlatteningTolerance(float tolerance);
+    float GetFlatteningTolerance() const { return m_FlatteningTolerance; }
+    void UpdateCurveAdaptive(float tolerance);
 
     const std::vector<float>& GetCurvePoints() const;
 
     unsigned int GetPointCount() const;
 
-    const std::vector<glm::vec2>& GetControlPoints() const;
+    const std::vector<Point>& GetControlPoints() const;
     
+    // Points spaced segmentLength apart along the curve
     void UpdateCurveUniformLength(float segmentLength);
 
-    float FindNextT(float currentT, const glm::vec2& currentPoint, float targetLength);
+    // Arc length queries, the table is built on first use after the control points change
+    float GetLength();
+    float GetLengthAtParameter(float t);
+    float GetParameterAtLength(float length);
+
+
+private:
+    Point CalculatePoint(float t) const;
+
+    // Resampling of segments [first, last]
+    void UpdateSegments(unsigned int first, unsigned int last);
+    void MarkDirty(unsigned int begin, unsigned int end);
+    void AppendCurvePoint(const Point& point);
+
+    // Distance bound between a curve piece and its chord, from the convex hull of the control points
+    static float ControlPolygonFlatness(const Point* points, unsigned int count);
+
+    void BuildArcLengthTable();
+    float GetSpeed(float t) const;
+    float IntegrateSpeed(float t0, float t1) const; // Gauss-Legendre over [t0, t1]
+};
+
+using BezierCurve = BezierCurveT<glm::vec2>;
+using BezierCurve3D = BezierCurveT<glm::vec3>;
+
+/**
+ * Bezier curve with a compile time degree, for camera paths and animation curves
+ * Evaluation and derivatives unroll completely and stay usable in constant expressions
+ */
+template<typename Point, unsigned int Degree>
+class FixedBezierCurve
+{
+    static_assert(Degree >= 1, "A Bezier curve needs at least two control points");
 
 private:
-    glm::vec2 CalculatePoint(float t);
+    Point m_ControlPoints[Degree + 1];
+
+public:
+    constexpr FixedBezierCurve()
+        : m_ControlPoints()
+    {
+    }
+
+    constexpr FixedBezierCurve(const Point (&points)[Degree + 1])
+        : m_ControlPoints()
+    {
+        for (unsigned int i = 0; i <= Degree; i++)
+            m_ControlPoints[i] = points[i];
+    }
+
+    constexpr void SetControlPoint(unsigned int index, const Point& point) { m_ControlPoints[index] = point; }
+    constexpr const Point& GetControlPoint(unsigned int index) const { return m_ControlPoints[index]; }
+    constexpr const Point* GetControlPoints() const { return m_ControlPoints; }
+    static constexpr unsigned int GetDegree() { return Degree; }
+
+    constexpr Point Evaluate(float t) const
+    {
+        return FixedDeCasteljau<Degree, Point>::Evaluate(m_ControlPoints, t);
+    }
+
+    // Hodograph, degree - 1 curve on Degree * (P_i+1 - P_i)
+    constexpr Point Derivative(float t) const
+    {
+        Point hodograph[Degree] = {};
+        for (unsigned int i = 0; i < Degree; i++)
+            hodograph[i] = static_cast<float>(Degree) * (m_ControlPoints[i + 1] - m_ControlPoints[i]);
+        return FixedDeCasteljau<Degree - 1, Point>::Evaluate(hodograph, t);
+    }
+
+    constexpr Point SecondDerivative(float t) const
+    {
+        if (Degree < 2)
+            return Point(0.0f);
+
+        Point secondHodograph[Degree > 1 ? Degree - 1 : 1] = {};
+        for (unsigned int i = 0; i + 1 < Degree; i++)
+            secondHodograph[i] = static_cast<float>(Degree * (Degree - 1)) * (m_ControlPoints[i + 2] - 2.0f * m_ControlPoints[i + 1] + m_ControlPoints[i]);
+        return FixedDeCasteljau<(Degree > 1 ? Degree - 2 : 0), Point>::Evaluate(secondHodograph, t);
+    }
+};
 
-    glm::vec2 DeCasteljau(const std::vector<glm::vec2>& points, float t);
-};
\ No newline at end of file
+using CubicBezier2D = FixedBezierCurve<glm::vec2, 3>;
+using CubicBezier3D = FixedBezierCurve<glm::vec3, 3>;
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * Allocation free Bezier evaluation
+ * De Casteljau runs in place on a stack copy of the control points, the fixed degree
+ * versions unroll completely for linear, quadratic and cubic curves
+ */
+
+// Largest curve evaluated on the stack, bigger ones fall back to a heap scratch buffer
+const unsigned int s_MaxStackControlPoints = 32;
+
+// Generic fixed degree De Casteljau, the loops have compile time bounds (constexpr with glm 1.0 vectors)
+template<unsigned int Degree, typename Point>
+struct FixedDeCasteljau
+{
+    static constexpr Point Evaluate(const Point* points, float t)
+    {
+        Point work[Degree + 1] = {};
+        for (unsigned int i = 0; i <= Degree; i++)
+            work[i] = points[i];
+
+        for (unsigned int level = Degree; level > 0; level--)
+        {
+            for (unsigned int i = 0; i < level; i++)
+                work[i] = work[i] + t * (work[i + 1] - work[i]);
+        }
+        return work[0];
+    }
+};
+
+template<typename Point>
+struct FixedDeCasteljau<1, Point>
+{
+    static constexpr Point Evaluate(const Point* points, float t)
+    {
+        return points[0] + t * (points[1] - points[0]);
+    }
+};
+
+template<typename Point>
+struct FixedDeCasteljau<2, Point>
+{
+    static constexpr Point Evaluate(const Point* points, float t)
+    {
+        Point a = points[0] + t * (points[1] - points[0]);
+        Point b = points[1] + t * (points[2] - points[1]);
+        return a + t * (b - a);
+    }
+};
+
+template<typename Point>
+struct FixedDeCasteljau<3, Point>
+{
+    static constexpr Point Evaluate(const Point* points, float t)
+    {
+        Point a = points[0] + t * (points[1] - points[0]);
+        Point b = points[1] + t * (points[2] - points[1]);
+        Point c = points[2] + t * (points[3] - points[2]);
+        Point ab = a + t * (b - a);
+        Point bc = b + t * (c - b);
+        return ab + t * (bc - ab);
+    }
+};
+
+// De Casteljau in place on a caller provided buffer of count points (overwritten)
+template<typename Point>
+inline Point DeCasteljauInPlace(Point* work, unsigned int count, float t)
+{
+    for (unsigned int level = count - 1; level > 0; level--)
+    {
+        for (unsigned int i = 0; i < level; i++)
+            work[i] = work[i] + t * (work[i + 1] - work[i]);
+    }
+    return work[0];
+}
+
+// Any degree, dispatches to the unrolled versions when possible
+template<typename Point>
+inline Point EvaluateBezier(const Point* points, unsigned int count, float t)
+{
+    switch (count)
+    {
+    case 0: return Point(0.0f);
+    case 1: return points[0];
+    case 2: return FixedDeCasteljau<1, Point>::Evaluate(points, t);
+    case 3: return FixedDeCasteljau<2, Point>::Evaluate(points, t);
+    case 4: return FixedDeCasteljau<3, Point>::Evaluate(points, t);
+    default: break;
+    }
+
+    if (count <= s_MaxStackControlPoints)
+    {
+        Point work[s_MaxStackControlPoints];
+        for (unsigned int i = 0; i < count; i++)
+            work[i] = points[i];
+        return DeCasteljauInPlace(work, count, t);
+    }
+
+    std::vector<Point> work(points, points + count);
+    return DeCasteljauInPlace(work.data(), count, t);
+}
+
+// Point, first and second derivative at t in one De Casteljau pass on a caller provided buffer of
+// count points (overwritten), the differences of the last levels are the hodograph (and its
+// hodograph) evaluated at t
+template<typename Point>
+inline void EvaluateBezierDerivativesInPlace(Point* work, unsigned int count, float t, Point& value, Point& first, Point& second)
+{
+    if (count < 2)
+    {
+        value = count == 1 ? work[0] : Point(0.0f);
+        first = Point(0.0f);
+        second = Point(0.0f);
+        return;
+    }
+
+    // Down to the last three points
+    for (unsigned int level = count - 1; level > 2; level--)
+    {
+        for (unsigned int i = 0; i < level; i++)
+            work[i] = work[i] + t * (work[i + 1] - work[i]);
+    }
+
+    // Locals so the outputs may point into work
+    float degree = static_cast<float>(count - 1);
+    Point p0 = work[0], p1 = work[1], curvature(0.0f);
+    if (count > 2)
+    {
+        Point p2 = work[2];
+        curvature = degree * (degree - 1.0f) * (p2 - 2.0f * p1 + p0);
+        p0 = p0 + t * (p1 - p0);
+        p1 = p1 + t * (p2 - p1);
+    }
+    value = p0 + t * (p1 - p0);
+    first = degree * (p1 - p0);
+    second = curvature;
+}
+
+template<typename Point>
+inline void EvaluateBezierDerivatives(const Point* points, unsigned int count, float t, Point& value, Point& first, Point& second)
+{
+    if (count <= s_MaxStackControlPoints)
+    {
+        Point work[s_MaxStackControlPoints];
+        for (unsigned int i = 0; i < count; i++)
+            work[i] = points[i];
+        EvaluateBezierDerivativesInPlace(work, count, t, value, first, second);
+        return;
+    }
+
+    std::vector<Point> work(points, points + count);
+    EvaluateBezierDerivativesInPlace(work.data(), count, t, value, first, second);
+}
+
+// Split a curve at t, left and right receive count points each (may not alias points)
+template<typename Point>
+inline void SplitBezier(const Point* points, unsigned int count, float t, Point* left, Point* right)
+{
+    // right doubles as the De Casteljau work row, row k leaves its last point in right[count - 1 - k]
+    for (unsigned int i = 0; i < count; i++)
+        right[i] = points[i];
+
+    for (unsigned int level = 0; level < count; level++)
+    {
+        left[level] = right[0];
+        for (unsigned int i = 0; i + level + 1 < count; i++)
+            right[i] = right[i] + t * (right[i + 1] - right[i]);
+    }
+}
+
+// Wang's formula, number of uniform segments keeping a chord within tolerance of the curve
+template<typename Point>
+inline unsigned int EstimateSegmentCount(const Point* points, unsigned int count, float tolerance)
+{
+    if (count < 3)
+        return 1;
+
+    float maxSecondDifference = 0.0f;
+    for (unsigned int i = 0; i + 2 < count; i++)
+        maxSecondDifference = glm::max(maxSecondDifference, glm::length(points[i] - 2.0f * points[i + 1] + points[i + 2]));
+
+    float degree = static_cast<float>(count - 1);
+    float segments = glm::sqrt(degree * (degree - 1.0f) * maxSecondDifference / (8.0f * tolerance));
+    return glm::max(1u, static_cast<unsigned int>(glm::ceil(segments)));
+}
+
+/**
+ * Bernstein weights of a given degree sampled at resolution + 1 uniform parameters
+ * Evaluating a sample is then a weighted sum of the control points
+ */
+class BernsteinTable
+{
+private:
+    std::vector<float> m_Weights;     // (resolution + 1) rows of (degree + 1) weights
+    std::vector<float> m_Derivatives; // Same layout, d/dt of each weight
+    unsigned int m_Degree;
+    unsigned int m_Resolution;
+
+public:
+    BernsteinTable();
+
+    // Only recomputes when the degree or the resolution changed
+    void Build(unsigned int degree, unsigned int resolution);
+
+    unsigned int GetDegree() const { return m_Degree; }
+    unsigned int GetResolution() const { return m_Resolution; }
+    const float* GetWeights(unsigned int sample) const { return &m_Weights[sample * (m_Degree + 1)]; }
+    const float* GetDerivativeWeights(unsigned int sample) const { return &m_Derivatives[sample * (m_Degree + 1)]; }
+    bool IsEmpty() const { return m_Weights.empty(); }
+};
+
+// Evaluate every sample of the table, output holds (resolution + 1) points
+template<typename Point>
+inline void EvaluateBezierBatch(const Point* points, const BernsteinTable& table, Point* output)
+{
+    unsigned int count = table.GetDegree() + 1;
+    for (unsigned int s = 0; s <= table.GetResolution(); s++)
+    {
+        const float* weights = table.GetWeights(s);
+        Point point = weights[0] * points[0];
+        for (unsigned int i = 1; i < count; i++)
+            point += weights[i] * points[i];
+        output[s] = point;
+    }
+}
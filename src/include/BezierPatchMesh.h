@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Shape.h"
+#include "PatchTessellator.h"
+#include <vector>
+#include <string>
+
+/**
+ * Surface made of many bicubic Bezier patches (Utah teapot style models)
+ * All control points live in one block, 16 per patch, row major with u as the row. Shared
+ * edges are tessellated once (see PatchTessellator) so the single mesh has no cracks
+ */
+class BezierPatchMesh : public Shape
+{
+private:
+    std::vector<glm::vec3> m_ControlPoints;
+    float m_Tolerance;            // Largest distance between the surface and its triangles
+    unsigned int m_MaxResolution; // Segments along one patch edge
+
+    PatchTessellator m_Tessellator;
+
+public:
+    BezierPatchMesh(float tolerance = 0.002f, unsigned int maxResolution = 32);
+    ~BezierPatchMesh() override;
+
+    // Inherited from Shape
+    void Generate() override;
+    void Update() override;
+    // The tolerance grows 4x per level, which halves the resolutions
+    void GenerateLODs(unsigned int levelCount) override;
+
+    // controlPoints holds 16 points per patch, regenerates the mesh
+    void SetPatches(const std::vector<glm::vec3>& controlPoints);
+
+    // Newell's teapot format: the patch count, 16 one based vertex indices per patch, the vertex
+    // count and x, y, z per vertex, separated by commas and / or whitespace
+    bool LoadPatches(const std::string& filePath);
+
+    void SetTolerance(float tolerance);
+
+    // Getters
+    const std::vector<glm::vec3>& GetControlPoints() const { return m_ControlPoints; }
+    unsigned int GetPatchCount() const { return m_ControlPoints.size() / 16; }
+    float GetTolerance() const { return m_Tolerance; }
+};
@@ -1,17 +1,61 @@
 #pragma once
 
 #include "Shape.h"
+#include "PatchEvaluator.h"
+#include "AdaptivePatchTessellator.h"
+#include "ControlPointBVH.h"
+#include "Ray.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
 #include <vector>
+#include <memory>
 
 class BezierSurface : public Shape
 {
 private:
-    std::vector<std::vector<glm::vec3>> m_ControlPoints;
+    // Control net in one row major block, point (i, j) at i * m_NumControlPointsV + j (u is the row)
+    std::vector<glm::vec3> m_ControlPoints;
     unsigned int m_ResolutionU;
     unsigned int m_ResolutionV;
     unsigned int m_NumControlPointsU;
     unsigned int m_NumControlPointsV;
 
+    // Basis tables for the current degree / resolution
+    PatchEvaluator m_Evaluator;
+
+    // Positions and tangents of the current mesh (see PatchEvaluator::ApplyControlPointDelta) and
+    // the vertices rewritten from them after a control point moved
+    std::vector<float> m_Frame;
+    std::vector<float> m_StagingVertices;
+    unsigned int m_IncrementalUpdates; // Since the frame was last evaluated in full
+
+    // View dependent tiles in place of the uniform grid and the LOD chain, see UpdateTessellation
+    AdaptivePatchTessellator m_AdaptiveTessellator;
+    bool m_AdaptiveTessellation;
+    float m_AdaptiveTolerance;
+    TessellationView m_View;
+    bool m_HasView; // m_View was set by UpdateTessellation
+
+    // Control points drawn as a GL_PATCHES patch and tessellated on the GPU, see DrawTessellated
+    bool m_GPUTessellation;
+
+    // Segment list of the control grid, rebuilt on the next request after a control point changed
+    mutable std::vector<float> m_GridLines;
+    mutable bool m_GridLinesDirty;
+
+    // Control net on the GPU, the points themselves plus line indices for the grid. Points are
+    // patched in place after edits, the indices only change with the net dimensions
+    mutable std::unique_ptr<VertexArray> m_ControlNetVAO;
+    mutable std::unique_ptr<VertexBuffer> m_ControlNetVBO;
+    mutable std::unique_ptr<IndexBuffer> m_GridLineIBO;
+    mutable bool m_ControlNetDirty;
+
+    // Control points for picking, built on the first query after the net was replaced and refitted
+    // by single point moves from then on
+    mutable ControlPointBVH m_ControlPointIndex;
+    mutable bool m_ControlPointIndexDirty;
+
 public:
     BezierSurface(unsigned int resolutionU = 20, unsigned int resolutionV = 20);
     ~BezierSurface() override;
@@ -19,22 +63,75 @@ public:
     // Inherited from Shape
     void Generate() override;
     void Update() override;
+    void GenerateLODs(unsigned int levelCount) override;
 
     // BezierSurface-specific methods
     void CreateDefaultSurface();
-    std::vector<float> GetFlattenedControlPoints() const;
-    std::vector<float> GetControlPointGridLines() const;
+
+    // points holds countU x countV points, row major with u as the row, regenerates the mesh
+    void SetControlPoints(const std::vector<glm::vec3>& points, unsigned int countU, unsigned int countV);
+    // Moves the mesh vertices by the rank one change of this point and patches the vertex buffer in
+    // place, falls back to Update() for LOD chains, adaptive, GPU tessellated, compressed or optimized meshes
+    void SetControlPoint(unsigned int i, unsigned int j, const glm::vec3& point);
+
+    // Levels that follow the flatness of the net and, after UpdateTessellation, its size on screen.
+    // tolerance bounds the surface error in control point units, 0 leaves it to the view
+    void SetAdaptiveTessellation(bool enabled, float tolerance = 0.001f);
+    bool IsAdaptiveTessellation() const { return m_AdaptiveTessellation; }
+
+    // Levels for maxPixelError pixels under the camera, the mesh is only rebuilt (and true returned)
+    // when one of them changed
+    bool UpdateTessellation(const Camera& camera, float viewportHeight, float maxPixelError = 1.0f);
+
+    // Only the control points are uploaded and res/shaders/BezierPatch.shader evaluates the surface,
+    // the CPU mesh shrinks to the control net (bounds and culling). Bicubic nets on GL 4.0+ only,
+    // others keep the CPU grid
+    void SetGPUTessellation(bool enabled);
+    bool IsGPUTessellation() const { return m_GPUTessellation && SupportsGPUTessellation(); }
+    bool SupportsGPUTessellation() const;
+
+    // The net as one 16 point patch, tessellation levels from the distance of each edge to the camera
+    // so that a segment covers about segmentPixels pixels
+    void DrawTessellated(Shader& shader, const glm::mat4& view, const glm::mat4& projection, const Camera& camera,
+        float viewportHeight, float segmentPixels = 8.0f) const;
+
+    // Grid lines as pairs of x, y, z points, cached between control point changes
+    const std::vector<float>& GetControlPointGridLines() const;
+
+    // Control grid (GL_LINES) and points (GL_POINTS) with a position only shader using u_Color
+    void DrawControlNet(Shader& shader, const glm::mat4& view, const glm::mat4& projection) const;
+
+    // Control point closest to the ray by angle, within maxSlope (distance from the ray over distance
+    // along it). The ray is world space, angles are measured in model space and match the screen for
+    // uniform scales only
+    bool PickControlPoint(const Ray& ray, float maxSlope, unsigned int& i, unsigned int& j) const;
+
+    // Indices (i * GetNumControlPointsV() + j) of the control points inside the clip volume of
+    // viewProjection, a pick matrix times projection * view selects a screen rectangle
+    void SelectControlPoints(const glm::mat4& viewProjection, std::vector<unsigned int>& selected) const;
 
     // Getters
-    const std::vector<std::vector<glm::vec3>>& GetControlPoints() const { return m_ControlPoints; }
+    const std::vector<glm::vec3>& GetControlPoints() const { return m_ControlPoints; }
+    const glm::vec3& GetControlPoint(unsigned int i, unsigned int j) const { return m_ControlPoints[i * m_NumControlPointsV + j]; }
+    unsigned int GetNumControlPointsU() const { return m_NumControlPointsU; }
+    unsigned int GetNumControlPointsV() const { return m_NumControlPointsV; }
+
+    // The net as packed x, y, z floats, for VertexBuffer / glBufferSubData without a copy
+    const float* GetControlPointData() const { return &m_ControlPoints[0].x; }
+    unsigned int GetControlPointDataSize() const { return m_ControlPoints.size() * sizeof(glm::vec3); }
 
 private:
-    // De Casteljau algorithm for a 1D Bezier curve
-    glm::vec3 DeCasteljau(const std::vector<glm::vec3>& points, float t) const;
+    void MarkControlNetDirty();
+    bool CanUpdateIncrementally() const;
+    void UpdateControlNetBuffers() const;
+    const ControlPointBVH& GetControlPointIndex() const;
 
     // Calculate point on the surface at parameters u, v
     glm::vec3 CalculatePoint(float u, float v) const;
 
-    // Calculate surface normal at a point
+    // Unit normal from the analytic derivatives (second derivatives at degenerate points)
     glm::vec3 CalculateNormal(float u, float v) const;
-};
\ No newline at end of file
+
+    // Largest distance between the surface and its triangles at a given resolution
+    float EstimateTessellationError(unsigned int resolutionU, unsigned int resolutionV) const;
+};
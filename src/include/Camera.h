@@ -43,6 +43,9 @@ public:
     void ProcessMouseMovement(float xoffset, float yoffset, bool constrainPitch = true);
     void ProcessMouseScroll(float yoffset);
 
+    // Place the camera and turn it to face direction, used for path playback
+    void LookAlong(const glm::vec3& position, const glm::vec3& direction);
+
     // Getters
     inline float GetZoom() const { return m_Zoom; }
     inline glm::vec3 GetPosition() const { return m_Position; }
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Frustum.h"
+
+/**
+ * Bounding box hierarchy over the control points of a surface for picking and box selection
+ * Built top down by splitting the longest axis at the median, like CurveBVH. A moved point only
+ * refits its leaf and the boxes above it, the tree is rebuilt once as many refits as points piled up
+ */
+class ControlPointBVH
+{
+private:
+    struct Node
+    {
+        glm::vec3 Min;
+        glm::vec3 Max;
+        unsigned int First;  // Leaf: first point in m_Order, inner: index of the left child
+        unsigned int Count;  // Points in a leaf, 0 for inner nodes (right child is First + 1)
+        unsigned int Parent; // ~0u for the root
+    };
+
+    std::vector<glm::vec3> m_Points;
+    std::vector<unsigned int> m_Order;
+    std::vector<unsigned int> m_Leaves; // Leaf node of each point
+    std::vector<Node> m_Nodes;
+    unsigned int m_Refits;
+
+    void BuildNode(unsigned int nodeIndex, unsigned int parent, unsigned int first, unsigned int count);
+
+public:
+    ControlPointBVH();
+    ~ControlPointBVH();
+
+    void Build(const glm::vec3* points, unsigned int count);
+    void Clear();
+    unsigned int GetPointCount() const { return m_Points.size(); }
+
+    // Point index moved to point
+    void Update(unsigned int index, const glm::vec3& point);
+
+    // Point with the smallest angle to the ray (distance from the ray over distance along it, the
+    // screen distance up to a constant), only points in front with an angle up to maxSlope count.
+    // direction must be unit length, false when no point is close enough
+    bool FindClosestToRay(const glm::vec3& origin, const glm::vec3& direction, float maxSlope, unsigned int& index) const;
+
+    // Indices of the points inside the frustum, subtrees entirely inside are taken without testing
+    // their points
+    void FindInFrustum(const Frustum& frustum, std::vector<unsigned int>& indices) const;
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * Many independent 2D cubic Bezier curves (map / glyph outlines, graph edges) evaluated together
+ * Control points are stored as structure of arrays so 8 curves (AVX, 4 with SSE) are evaluated
+ * per instruction at the same t, large batches are split across threads
+ */
+class CubicCurveBatch
+{
+private:
+    // m_X[i][c] is the x coordinate of control point i of curve c
+    std::vector<float> m_X[4];
+    std::vector<float> m_Y[4];
+
+    // Curves [first, last) into output, which points at the first vertex of curve first
+    void EvaluateRange(unsigned int first, unsigned int last, unsigned int resolution, float* output) const;
+
+public:
+    CubicCurveBatch();
+    ~CubicCurveBatch();
+
+    void Clear();
+    void Reserve(unsigned int count);
+
+    unsigned int Add(const glm::vec2& p0, const glm::vec2& p1, const glm::vec2& p2, const glm::vec2& p3);
+    void SetCurve(unsigned int index, const glm::vec2& p0, const glm::vec2& p1, const glm::vec2& p2, const glm::vec2& p3);
+    unsigned int GetCount() const { return m_X[0].size(); }
+
+    // Sample every curve at resolution + 1 uniform t values into one (x, y) vertex array,
+    // curve c owns vertices [c * (resolution + 1), (c + 1) * (resolution + 1)), large batches are
+    // split across threads unless parallel is false. A resolution of 0 is taken as 1
+    void Evaluate(unsigned int resolution, std::vector<float>& vertices, bool parallel = true) const;
+    void EvaluateScalar(unsigned int resolution, std::vector<float>& vertices) const;
+
+    // First vertex / vertex count of each curve for a single glMultiDrawArrays(GL_LINE_STRIP, ...)
+    void GetDrawRanges(unsigned int resolution, std::vector<int>& firsts, std::vector<int>& counts) const;
+};
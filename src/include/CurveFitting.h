@@ -0,0 +1,18 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "BezierCurve.h"
+
+/**
+ * Fit a chain of cubic Bezier segments to dense point samples (Schneider, Graphics Gems 1990)
+ * Corners sharper than cornerAngle (degrees) split the input first, each piece is then fitted by
+ * least squares with Newton reparameterization and split at the worst point until every sample
+ * is within tolerance. Consecutive segments share their end points, and the tangents inside a
+ * piece are continuous.
+ */
+std::vector<CubicBezier2D> FitCubicBeziers(const std::vector<glm::vec2>& points, float tolerance, float cornerAngle = 60.0f);
+
+// Largest distance from the samples to the fitted chain (closest point on a dense flattening), 0 without segments
+float GetFittingError(const std::vector<glm::vec2>& points, const std::vector<CubicBezier2D>& segments);
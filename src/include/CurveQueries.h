@@ -0,0 +1,85 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "BezierCurve.h"
+
+/**
+ * Geometric queries on Bezier control points
+ * Pieces are subdivided with De Casteljau and pruned by the bounding box of their control hull
+ * (the curve never leaves it), the surviving parameters are polished with Newton steps
+ */
+
+struct CurveHit
+{
+    float T = 0.0f;          // Curve parameter (global parameter for BezierCurve in BSpline mode)
+    glm::vec2 Point = glm::vec2(0.0f);
+    float Distance = 0.0f;   // To the query point, 0 for intersections
+};
+
+struct CurveIntersection
+{
+    float T0 = 0.0f; // Parameter on the first curve
+    float T1 = 0.0f; // Parameter on the second curve
+    glm::vec2 Point = glm::vec2(0.0f);
+};
+
+// Control point level queries, count points per curve, tolerance in curve units
+CurveHit FindClosestPoint(const glm::vec2* points, unsigned int count, const glm::vec2& query, float tolerance = 1e-4f);
+void IntersectCurves(const glm::vec2* first, unsigned int firstCount, const glm::vec2* second, unsigned int secondCount,
+    std::vector<CurveIntersection>& intersections, float tolerance = 1e-4f);
+// Intersections with the segment [lineStart, lineEnd], a curve lying on it gives the ends of the overlap
+void IntersectLine(const glm::vec2* points, unsigned int count, const glm::vec2& lineStart, const glm::vec2& lineEnd,
+    std::vector<CurveHit>& hits, float tolerance = 1e-5f);
+
+// Same queries on a whole BezierCurve, in either mode
+CurveHit FindClosestPoint(const BezierCurve& curve, const glm::vec2& query, float tolerance = 1e-4f);
+std::vector<CurveIntersection> IntersectCurves(const BezierCurve& first, const BezierCurve& second, float tolerance = 1e-4f);
+std::vector<CurveHit> IntersectLine(const BezierCurve& curve, const glm::vec2& lineStart, const glm::vec2& lineEnd);
+
+struct CurveBVHHit
+{
+    unsigned int Curve = 0; // Index in the order the curves were added
+    CurveHit Hit;
+};
+
+/**
+ * Bounding box hierarchy over many cubic segments for hover / pick queries
+ * Built top down by splitting the longest axis at the median of the box centers
+ */
+class CurveBVH
+{
+private:
+    struct Node
+    {
+        glm::vec2 Min;
+        glm::vec2 Max;
+        unsigned int First;  // Leaf: first curve in m_Order, inner: index of the left child
+        unsigned int Count;  // Curves in a leaf, 0 for inner nodes (right child is First + 1)
+    };
+
+    std::vector<CubicBezier2D> m_Curves;
+    std::vector<glm::vec2> m_CurveMin;
+    std::vector<glm::vec2> m_CurveMax;
+    std::vector<unsigned int> m_Order;
+    std::vector<Node> m_Nodes;
+
+    void BuildNode(unsigned int nodeIndex, unsigned int first, unsigned int count);
+
+public:
+    CurveBVH();
+    ~CurveBVH();
+
+    void Clear();
+    unsigned int Add(const CubicBezier2D& curve);
+    // B-spline segments or a cubic Bezier, other degrees are skipped
+    void AddCurve(const BezierCurve& curve);
+    unsigned int GetCurveCount() const { return m_Curves.size(); }
+    const CubicBezier2D& GetCurve(unsigned int index) const { return m_Curves[index]; }
+
+    void Build();
+
+    // Closest curve within maxDistance of the point, false when none
+    bool FindClosest(const glm::vec2& query, float maxDistance, CurveBVHHit& hit) const;
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "BezierCurve.h"
+
+enum class FillRule
+{
+    EvenOdd,
+    NonZero
+};
+
+/**
+ * Triangulates closed outlines made of Bezier curves (vector shapes, glyphs) for one
+ * glDrawElements(GL_TRIANGLES), see Renderer::Draw
+ * Contours are flattened, crossing edges are split at their intersections, then a single sweep
+ * from top to bottom decomposes the filled regions into y-monotone polygons which are
+ * triangulated while the sweep runs. Holes are just more contours, the winding of each region
+ * and the fill rule decide what is inside
+ */
+class FillTessellator
+{
+private:
+    struct Edge
+    {
+        unsigned int Top;    // Vertex ids, Top comes first in sweep order
+        unsigned int Bottom;
+        int Winding;         // +1 when the contour runs from Top to Bottom, -1 otherwise
+    };
+
+    // Area between an active edge and the next one to its right
+    struct Region
+    {
+        int Winding;
+        int LeftPoly;  // -1 outside, different polys while a merge vertex waits for its diagonal
+        int RightPoly;
+    };
+
+    // y-monotone polygon being triangulated, Stack is the reflex chain of the classic algorithm
+    struct MonotonePoly
+    {
+        std::vector<unsigned int> Stack;
+        int StackSide;
+        unsigned int LastVertex; // Lowest vertex so far, the helper of a split vertex
+        int LastSide;
+    };
+
+    struct Split
+    {
+        unsigned int Edge;
+        float T;
+        unsigned int Vertex;
+    };
+
+    // Input contours
+    std::vector<glm::vec2> m_ContourPoints;
+    std::vector<unsigned int> m_ContourStarts;
+
+    // Output, x, y per vertex (Bezier.shader layout) and triangle indices
+    std::vector<float> m_Vertices;
+    std::vector<unsigned int> m_Indices;
+
+    // Scratch reused between tessellations
+    std::vector<glm::vec2> m_Points;          // Points before sorting, contour points or old vertices and intersections
+    std::vector<unsigned int> m_Order;
+    std::vector<unsigned int> m_VertexIds;    // Index in m_Points to vertex id
+    std::vector<glm::vec2> m_SweepPoints;     // Vertex positions by id, in sweep order (y, then x)
+    std::vector<Edge> m_Edges;                // Sorted by top vertex, left to right below it
+    std::vector<Edge> m_Pieces;
+    std::vector<unsigned int> m_EdgeStarts;   // First edge below each vertex
+    std::vector<Split> m_Splits;
+    std::vector<unsigned int> m_Snapped;      // Intersection to the intersection it was merged with
+    std::vector<unsigned int> m_Active;       // Edges crossing the sweep line, left to right
+    std::vector<Region> m_Regions;            // Region right of each edge, by edge index
+    std::vector<MonotonePoly> m_Polys;
+    std::vector<int> m_FreePolys;
+
+    void SortVertices();
+    void BuildEdges();
+    // from -> to is the direction of the contour, indices in m_Points
+    void AddEdge(std::vector<Edge>& edges, unsigned int from, unsigned int to, int direction) const;
+    bool SplitIntersections();
+    void Sweep(FillRule rule);
+
+    bool IsInside(int winding, FillRule rule) const;
+    float GetEdgeX(const Edge& edge, float y) const;
+
+    int NewPoly(unsigned int top);
+    void AddPolyVertex(int poly, unsigned int vertex, int side);
+    void FinishPoly(int poly, unsigned int vertex);
+    void EmitTriangle(unsigned int a, unsigned int b, unsigned int c);
+
+public:
+    FillTessellator();
+    ~FillTessellator();
+
+    // Drops the contours and the output
+    void Clear();
+
+    // Contours close themselves, the last point connects back to the first
+    void BeginContour();
+    void AddPoint(const glm::vec2& point);
+    // Flattened to tolerance (units of the control points) and appended to the current contour
+    void AddCurve(const BezierCurve& curve, float tolerance);
+    void AddCubic(const CubicBezier2D& curve, float tolerance);
+    // Whole contour from pointCount (x, y) pairs
+    void AddContour(const float* points, unsigned int pointCount);
+
+    void Tessellate(FillRule rule = FillRule::NonZero);
+
+    const std::vector<float>& GetVertices() const { return m_Vertices; }
+    const std::vector<unsigned int>& GetIndices() const { return m_Indices; }
+    unsigned int GetVertexCount() const { return m_Vertices.size() / 2; }
+    unsigned int GetTriangleCount() const { return m_Indices.size() / 3; }
+
+    // Flattened input, contour c starts at point GetContourStarts()[c]
+    const std::vector<glm::vec2>& GetContourPoints() const { return m_ContourPoints; }
+    const std::vector<unsigned int>& GetContourStarts() const { return m_ContourStarts; }
+};
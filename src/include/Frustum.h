@@ -0,0 +1,26 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+/**
+ * The six clipping planes of a view frustum, extracted from a projection * view matrix
+ * Planes are normalized and point inside: dot(normal, p) + d >= 0 for points inside
+ */
+class Frustum
+{
+public:
+    enum Plane { LEFT_PLANE = 0, RIGHT_PLANE, BOTTOM_PLANE, TOP_PLANE, NEAR_PLANE, FAR_PLANE, PLANE_COUNT };
+
+private:
+    glm::vec4 m_Planes[PLANE_COUNT]; // xyz = normal, w = d
+
+public:
+    Frustum(const glm::mat4& viewProjection);
+
+    const glm::vec4& GetPlane(int plane) const { return m_Planes[plane]; }
+
+    bool IntersectsSphere(const glm::vec3& center, float radius) const;
+    bool IntersectsAABB(const glm::vec3& center, const glm::vec3& extents) const;
+    // Whole box on the inner side of every plane
+    bool ContainsAABB(const glm::vec3& center, const glm::vec3& extents) const;
+};
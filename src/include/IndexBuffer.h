@@ -6,13 +6,16 @@ class IndexBuffer
 private:
 	unsigned int m_Render_ID;
 	unsigned int m_Count;
+	unsigned int m_Type; // GL_UNSIGNED_INT or GL_UNSIGNED_SHORT
 public:
 	IndexBuffer();
 	IndexBuffer(const unsigned int* data, unsigned int count);
+	IndexBuffer(const unsigned short* data, unsigned int count);
 	~IndexBuffer();
 
 	void Bind() const;
 	void Unbind() const;
 
 	inline unsigned int GetCount() const  { return m_Count; }
+	inline unsigned int GetType() const { return m_Type; }
 };
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <glm/glm.hpp>
+
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "VertexBufferLayout.h"
+#include "IndexBuffer.h"
+#include "VertexCompression.h"
+
+/**
+ * Indexed triangle mesh with its CPU copy and GPU buffers
+ * Vertices are interleaved position + normal (6 floats), the GPU copy may be compressed
+ * Meshes are immutable once created so they can be shared between shapes (see MeshCache), except
+ * through UpdateVertices by the single shape that owns one
+ */
+class Mesh
+{
+private:
+    std::vector<float> m_Vertices;
+    std::vector<unsigned int> m_Indices;
+
+    std::unique_ptr<VertexArray> m_VAO;
+    std::unique_ptr<VertexBuffer> m_VBO;
+    std::unique_ptr<IndexBuffer> m_IBO;
+
+    // Positions are dequantized in the shader as offset + attribute * scale
+    VertexFormat m_VertexFormat;
+    glm::vec3 m_PositionOffset;
+    glm::vec3 m_PositionScale;
+    unsigned int m_GPUBufferSize;
+
+    // Mesh space bounds of the positions
+    glm::vec3 m_BoundsMin;
+    glm::vec3 m_BoundsMax;
+    float m_BoundingRadius; // around the bounds center
+
+    void ComputeBounds();
+    void Upload();
+
+public:
+    Mesh(std::vector<float> vertices, std::vector<unsigned int> indices, VertexFormat format = VertexFormat::Float);
+    ~Mesh();
+
+    void Bind() const;
+    void Unbind() const;
+
+    // Overwrites vertexCount vertices from firstVertex in the CPU copy and in place on the GPU
+    // (glBufferSubData, no new GL objects). Float format only, the bounds are recomputed
+    void UpdateVertices(const float* vertices, unsigned int firstVertex, unsigned int vertexCount);
+
+    const std::vector<float>& GetVertices() const { return m_Vertices; }
+    const std::vector<unsigned int>& GetIndices() const { return m_Indices; }
+    unsigned int GetVertexCount() const { return m_Vertices.size() / 6; }
+    unsigned int GetIndexCount() const { return m_Indices.size(); }
+    unsigned int GetIndexType() const { return m_IBO->GetType(); }
+
+    VertexFormat GetVertexFormat() const { return m_VertexFormat; }
+    glm::vec3 GetPositionOffset() const { return m_PositionOffset; }
+    glm::vec3 GetPositionScale() const { return m_PositionScale; }
+    unsigned int GetGPUBufferSize() const { return m_GPUBufferSize; }
+
+    glm::vec3 GetBoundsMin() const { return m_BoundsMin; }
+    glm::vec3 GetBoundsMax() const { return m_BoundsMax; }
+    glm::vec3 GetBoundsCenter() const { return (m_BoundsMin + m_BoundsMax) * 0.5f; }
+    float GetBoundingRadius() const { return m_BoundingRadius; }
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <unordered_map>
+
+#include "Mesh.h"
+
+/**
+ * Flyweight cache of generated meshes keyed by their generator parameters
+ * The cache only holds weak references: a mesh lives as long as one shape uses it,
+ * so memory scales with the number of distinct meshes rather than the number of shapes
+ */
+class MeshCache
+{
+private:
+    std::unordered_map<std::string, std::weak_ptr<Mesh>> m_Meshes;
+
+    MeshCache() {}
+
+public:
+    static MeshCache& Get();
+
+    // Returns the live mesh for this key or nullptr
+    std::shared_ptr<Mesh> Find(const std::string& key);
+    void Insert(const std::string& key, const std::shared_ptr<Mesh>& mesh);
+
+    // Number of meshes still referenced by at least one shape
+    unsigned int GetLiveMeshCount();
+};
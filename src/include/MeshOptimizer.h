@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+
+/**
+ * Post-transform vertex cache statistics of an index buffer
+ * ACMR: average cache misses per triangle (0.5 is the ideal for large regular grids, 3.0 is no reuse)
+ * ATVR: average transformed vertices per vertex (1.0 is the ideal)
+ */
+struct VertexCacheStatistics
+{
+    unsigned int CacheMisses;
+    float ACMR;
+    float ATVR;
+};
+
+/**
+ * Summary of a full MeshOptimize pass
+ */
+struct MeshOptimizationReport
+{
+    unsigned int VerticesBefore;
+    unsigned int VerticesAfter;
+    VertexCacheStatistics Before;
+    VertexCacheStatistics After;
+};
+
+// Simulate a FIFO post-transform cache over the index buffer
+VertexCacheStatistics AnalyzeVertexCache(const std::vector<unsigned int>& indices, unsigned int vertexCount, unsigned int cacheSize = 16);
+
+// Merge vertices whose attributes are all within epsilon, returns the new vertex count
+unsigned int WeldVertices(std::vector<float>& vertices, std::vector<unsigned int>& indices, unsigned int floatsPerVertex, float epsilon = 0.0f);
+
+// Reorder triangles for post-transform cache reuse (Forsyth's linear-speed algorithm)
+void OptimizeVertexCache(std::vector<unsigned int>& indices, unsigned int vertexCount);
+
+// Split the cache-ordered triangles into clusters and draw outward facing clusters first (Tipsify style)
+// threshold is how much ACMR may be lost to the extra cluster boundaries (1.05 = 5%)
+void OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<float>& vertices, unsigned int floatsPerVertex, float threshold = 1.05f);
+
+// Reorder vertices in order of first use by the index buffer and drop unreferenced ones
+void OptimizeVertexFetch(std::vector<float>& vertices, std::vector<unsigned int>& indices, unsigned int floatsPerVertex);
+
+// Weld + vertex cache + overdraw + vertex fetch, in that order
+MeshOptimizationReport OptimizeMesh(std::vector<float>& vertices, std::vector<unsigned int>& indices, unsigned int floatsPerVertex, float weldEpsilon = 1e-5f);
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "BezierEvaluation.h"
+
+// Exact surface quantities at one (u, v)
+struct SurfaceSample
+{
+    glm::vec3 Point;
+    glm::vec3 TangentU; // dS/du
+    glm::vec3 TangentV; // dS/dv
+    glm::vec3 Normal;   // Unit
+};
+
+/**
+ * Tensor product Bezier patch sampled on a uniform (u, v) grid in matrix form
+ * Bernstein values and derivatives of both directions are tabulated once per degree / resolution,
+ * a row of the grid is then one contraction of the control net with the u weights followed by
+ * 8 (AVX, 4 with SSE) v samples at a time against the transposed v table. Rows are split across
+ * threads for large grids.
+ */
+class PatchEvaluator
+{
+private:
+    BernsteinTable m_BasisU;
+    BernsteinTable m_BasisV;
+
+    // v tables transposed, (degreeV + 1) rows of m_PaddedSamplesV samples (zero padded to the SIMD width)
+    std::vector<float> m_WeightsV;
+    std::vector<float> m_DerivativesV;
+    unsigned int m_PaddedSamplesV;
+
+    // output and frame start at row first
+    void EvaluateRows(const glm::vec3* net, unsigned int first, unsigned int last, float* output, float* frame) const;
+    void ApplyDeltaRows(const glm::vec3* net, unsigned int i, unsigned int j, const glm::vec3& delta, unsigned int first, unsigned int last, float* frame, float* output) const;
+
+    // Vertices from positions / tangents, lanes holds x, y, z, nx, ny, nz of s_SimdWidth samples
+    void WriteLanes(const glm::vec3* net, unsigned int sampleU, unsigned int firstV, const float (*lanes)[8], unsigned int validLanes, float* rowOutput) const;
+    void WriteVertex(const glm::vec3* net, unsigned int sampleU, unsigned int sampleV, const glm::vec3& point, const glm::vec3& tangentU, const glm::vec3& tangentV, float* vertex) const;
+    void SetDegenerateNormal(const glm::vec3* net, unsigned int sampleU, unsigned int sampleV, float* vertex) const;
+
+public:
+    // Interleaved position + normal, the Mesh layout
+    static const unsigned int s_VertexStride = 6;
+    // Frame planes per grid row: position x, y, z, dS/du x, y, z, dS/dv x, y, z
+    static const unsigned int s_FramePlanes = 9;
+
+    PatchEvaluator();
+    ~PatchEvaluator();
+
+    // Only rebuilds the tables when something changed
+    void Build(unsigned int degreeU, unsigned int degreeV, unsigned int resolutionU, unsigned int resolutionV);
+
+    unsigned int GetResolutionU() const { return m_BasisU.GetResolution(); }
+    unsigned int GetResolutionV() const { return m_BasisV.GetResolution(); }
+    unsigned int GetVertexCount() const { return (GetResolutionU() + 1) * (GetResolutionV() + 1); }
+    // Floats of a frame, s_FramePlanes planes of m_PaddedSamplesV samples per row
+    unsigned int GetFrameSize() const { return (GetResolutionU() + 1) * s_FramePlanes * m_PaddedSamplesV; }
+    const BernsteinTable& GetBasisU() const { return m_BasisU; }
+    const BernsteinTable& GetBasisV() const { return m_BasisV; }
+
+    // net holds (degreeU + 1) x (degreeV + 1) points, row major with u as the row, output gets
+    // GetVertexCount() vertices, row i (u = i / resolutionU) first. frame (GetFrameSize() floats)
+    // optionally keeps the unnormalized positions and tangents for ApplyControlPointDelta
+    void Evaluate(const glm::vec3* net, float* output, bool parallel = true, float* frame = nullptr) const;
+
+    // Moving control point (i, j) by delta moves every sample by delta * B_i(u) * B_j(v) and its
+    // tangents by the same product with one factor differentiated, so the frame is patched with
+    // that rank one term instead of contracting the whole net again. net already holds the moved
+    // point, output is rewritten from the frame. Rounding builds up over many edits, an Evaluate
+    // now and then resets it
+    void ApplyControlPointDelta(const glm::vec3* net, unsigned int i, unsigned int j, const glm::vec3& delta, float* frame, float* output, bool parallel = true) const;
+
+    // Point, derivatives and normal from one pass over the net, see EvaluateBezierDerivatives.
+    // Where dS/du x dS/dv vanishes (collapsed edges, cusps) the normal is the limit taken from the
+    // second derivatives, moving towards the inside of the patch
+    static SurfaceSample EvaluatePoint(const glm::vec3* net, unsigned int countU, unsigned int countV, float u, float v);
+};
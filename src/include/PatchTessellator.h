@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "PatchEvaluator.h"
+
+/**
+ * Tessellates lists of bicubic Bezier patches into one shared indexed triangle buffer
+ * Every patch holds 16 control points, row major with u as the row (the BezierSurface layout),
+ * all patches back to back. Edges are matched between patches by their control points: a shared
+ * edge is sampled once, at a resolution every patch touching it agrees on, and its samples and
+ * corners are single vertices of the output so neighbouring patches can't crack apart.
+ * Resolutions come from Wang's formula on the control net. A resolution along u holds for both
+ * u edges of a patch, so it is the largest wanted by any patch of the strip linked through those
+ * edges. Patches are then evaluated in parallel, each writing its own ranges of the buffers
+ */
+class PatchTessellator
+{
+private:
+    struct EdgeRecord
+    {
+        float Key[12];       // The 4 control points of the edge in canonical order
+        unsigned int Edge;   // patch * 4 + side
+        bool Reversed;       // Canonical order runs against the patch parameter
+    };
+
+    struct CornerRecord
+    {
+        glm::vec3 Position;
+        unsigned int Corner; // patch * 4 + corner
+    };
+
+    // Per patch side: 0 is u = 0, 1 is u = 1 (both along v), 2 is v = 0, 3 is v = 1 (along u)
+    struct PatchEdge
+    {
+        unsigned int Edge;  // Shared edge id
+        bool Reversed;
+    };
+
+    struct PatchLayout
+    {
+        unsigned int ResolutionU;
+        unsigned int ResolutionV;
+        unsigned int Corners[4];     // Vertex ids at (0, 0), (0, 1), (1, 0), (1, 1)
+        PatchEdge Edges[4];
+        unsigned int FirstInterior;  // Vertex id of the first inner sample
+        unsigned int FirstIndex;
+        unsigned int Evaluator;      // In m_Evaluators
+    };
+
+    std::vector<PatchLayout> m_Patches;
+
+    // Basis tables of every resolution pair in use, shared by the worker threads
+    std::vector<PatchEvaluator> m_Evaluators;
+
+    // Shared edges and corners, the first patch referencing one evaluates it
+    std::vector<unsigned int> m_EdgeResolutions;
+    std::vector<unsigned int> m_EdgeFirstVertex;
+    std::vector<unsigned int> m_EdgeOwners;
+    std::vector<unsigned int> m_CornerOwners;
+    unsigned int m_VertexCount;
+    unsigned int m_IndexCount;
+
+    // Scratch
+    std::vector<EdgeRecord> m_EdgeRecords;
+    std::vector<CornerRecord> m_CornerRecords;
+    std::vector<unsigned int> m_Parents;
+
+    void BuildTopology(const glm::vec3* controlPoints, unsigned int patchCount);
+    void ChooseResolutions(const glm::vec3* controlPoints, unsigned int patchCount, float tolerance, unsigned int maxResolution);
+    void AssignVertices();
+
+    unsigned int FindRoot(unsigned int edge);
+    unsigned int GetVertexId(const PatchLayout& patch, unsigned int a, unsigned int b) const;
+    bool OwnsVertex(unsigned int patchIndex, unsigned int a, unsigned int b) const;
+    void TessellatePatches(const glm::vec3* controlPoints, unsigned int first, unsigned int last, float* vertices, unsigned int* indices) const;
+
+public:
+    PatchTessellator();
+    ~PatchTessellator();
+
+    // tolerance bounds the distance between the surface and its triangles (units of the control
+    // points), maxResolution caps the segments along any patch edge. vertices get x, y, z, nx, ny, nz
+    void Tessellate(const glm::vec3* controlPoints, unsigned int patchCount, float tolerance, unsigned int maxResolution,
+        std::vector<float>& vertices, std::vector<unsigned int>& indices, bool parallel = true);
+
+    unsigned int GetPatchCount() const { return m_Patches.size(); }
+    unsigned int GetEdgeCount() const { return m_EdgeResolutions.size(); }
+    unsigned int GetPatchResolutionU(unsigned int patch) const { return m_Patches[patch].ResolutionU; }
+    unsigned int GetPatchResolutionV(unsigned int patch) const { return m_Patches[patch].ResolutionV; }
+};
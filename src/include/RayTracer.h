@@ -10,6 +10,8 @@
 #include <vector>
 #include <memory>
 
+class BezierSurface;
+
 class RayTracer
 {
 private:
@@ -51,6 +53,15 @@ public:
     // Set current ray for visualization
     void SetCurrentRay(const Ray& ray);
 
+    // Control point of the surface drawn closest to the screen position, within radiusPixels
+    bool PickControlPoint(const BezierSurface& surface, float screenX, float screenY, int screenWidth, int screenHeight,
+        float radiusPixels, unsigned int& i, unsigned int& j);
+
+    // Control points of the surface drawn inside the screen rectangle between two corners, as
+    // i * GetNumControlPointsV() + j, in one query. projection is the one the surface is drawn with
+    void SelectControlPoints(const BezierSurface& surface, const glm::mat4& projection, const glm::vec2& corner0,
+        const glm::vec2& corner1, int screenWidth, int screenHeight, std::vector<unsigned int>& selected);
+
     // Test ray intersection with all shapes
     bool Intersect(const Ray& ray, float& t, int& shapeIndex);
 
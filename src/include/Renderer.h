@@ -24,6 +24,8 @@ public:
     void Clear() const;
     void SetClearColor(float r, float g, float b, float a) const; // Added this method
     void Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const;
+    // Triangle strips separated by the max index of the index type (StrokeTessellator output)
+    void DrawStrips(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const;
 
 
 };
\ No newline at end of file
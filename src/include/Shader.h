@@ -6,6 +6,8 @@
 
 
 #include <string>
+#include <map>
+#include <memory>
 #include <unordered_map>
 
 /**
@@ -17,19 +19,32 @@
 struct ShaderProgramSource {
 	std::string VertexSource;
 	std::string FragmentSource;
+	// Optional, GL 4.0 tessellation stages (#shader tess_control / #shader tess_evaluation)
+	std::string TessControlSource;
+	std::string TessEvaluationSource;
 };
 
+// Name -> value, written as #define lines after the #version of every stage (an empty value defines 1)
+typedef std::map<std::string, std::string> ShaderDefines;
+
 
 class Shader
 {
 private:
 	std::string m_FilePath;
+	ShaderDefines m_Defines;
 	unsigned int m_RendererID;
 	std::unordered_map<std::string, int> m_UniformLocationCache;
 public:
-	Shader(const std::string& filename);
+	Shader(const std::string& filename, const ShaderDefines& defines = ShaderDefines());
 	~Shader();
 
+	// The program of filename specialized for defines, shared by every caller asking for the same set
+	// while one of them holds it (like MeshCache). Branches on defined constants are compiled out
+	static std::shared_ptr<Shader> GetVariant(const std::string& filename, const ShaderDefines& defines);
+
+	const ShaderDefines& GetDefines() const { return m_Defines; }
+
 	void Bind() const;
 	void Unbind() const;
 
@@ -46,7 +61,7 @@ public:
 
 private:
 	unsigned int CompileShader(unsigned int type, std::string& source);
-	int CreateShader(std::string& vetrexShader, std::string fragementShader);
+	int CreateShader(ShaderProgramSource& source);
 	ShaderProgramSource parseShader(const std::string& filePath);
 	unsigned int GetUniformLocation(const std::string& name);
 
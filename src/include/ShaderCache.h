@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Shader.h"
+
+/**
+ * Linked shader programs saved with glGetProgramBinary and loaded back with glProgramBinary
+ * A program is keyed by its sources, its defines and the driver (vendor, renderer, version), so any
+ * change to one of them is a miss. Each key has one file in the cache directory holding the key
+ * itself next to the binary, a hash collision is a miss too. Binaries the driver refuses (after an
+ * update that kept the version string, for instance) are deleted and the program compiled from source
+ */
+class ShaderCache
+{
+private:
+    struct Entry
+    {
+        std::string FilePath;
+        bool Hit;
+        double Milliseconds;
+    };
+
+    std::string m_Directory;
+    std::string m_Driver; // Queried on first use, needs a current context
+    std::vector<Entry> m_Entries;
+    unsigned int m_Rejected;
+    bool m_Enabled;
+
+    ShaderCache();
+
+    std::string GetCachePath(const std::string& key) const;
+
+public:
+    static ShaderCache& Get();
+
+    // Needs GL 4.1 (or ARB_get_program_binary) and at least one binary format
+    bool IsSupported() const;
+
+    // Directory for the binaries, "shader_cache" next to the working directory by default
+    void SetDirectory(const std::string& directory) { m_Directory = directory; }
+    void SetEnabled(bool enabled) { m_Enabled = enabled; }
+
+    std::string MakeKey(const ShaderProgramSource& source, const std::string& defines);
+
+    // Linked program for this key or 0
+    unsigned int Load(const std::string& key);
+    // Saves a linked program, which should have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+    void Store(const std::string& key, unsigned int program);
+
+    // One Shader constructor, for the report
+    void Record(const std::string& filePath, bool hit, double milliseconds);
+    // Hits and misses of every program created so far with their times
+    void PrintReport() const;
+};
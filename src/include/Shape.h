@@ -5,11 +5,13 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-#include "VertexArray.h"
-#include "VertexBuffer.h"
-#include "VertexBufferLayout.h"
-#include "IndexBuffer.h"
+#include <string>
+
+#include "Mesh.h"
 #include "Shader.h"
+#include "Camera.h"
+#include "VertexCompression.h"
+#include "MeshOptimizer.h"
 
 /**
  * Abstract base class for all 3D shapes
@@ -18,26 +20,55 @@
 class Shape
 {
 protected:
-    // Mesh data
+    // Mesh data being generated, moved into m_Mesh by SetupMesh
     std::vector<float> m_Vertices;       // Positions, normals, etc.
     std::vector<unsigned int> m_Indices; // Indices for drawing
 
-    // Rendering resources
-    std::unique_ptr<VertexArray> m_VAO;
-    std::unique_ptr<VertexBuffer> m_VBO;
-    std::unique_ptr<IndexBuffer> m_IBO;
+    // Uploaded mesh, possibly shared with other shapes through the MeshCache
+    std::shared_ptr<Mesh> m_Mesh;
 
     // Transformation properties
     glm::vec3 m_Position;
     glm::vec3 m_Rotation;
     glm::vec3 m_Scale;
 
+    // Scale baked into the model matrix so parametric shapes can share a unit mesh
+    glm::vec3 m_MeshScale;
+
     // Rendering settings
     bool m_WireframeMode;
 
+    // GPU vertex format, positions are dequantized in the shader for compressed formats
+    VertexFormat m_VertexFormat;
+
+    // Vertex cache / overdraw / fetch optimization before upload
+    bool m_OptimizeMesh;
+    MeshOptimizationReport m_OptimizationReport;
+
+    // Level of detail chain, finest first, m_Mesh points at the selected level
+    std::vector<std::shared_ptr<Mesh>> m_LODMeshes;
+    std::vector<float> m_LODErrors; // Mesh space geometric error of each level
+    unsigned int m_LODLevelCount;   // Requested levels, kept to rebuild the chain on Update
+    unsigned int m_CurrentLOD;
+
+    // World space bounds cached for culling, rebuilt when the transform or mesh changes
+    mutable glm::vec3 m_WorldCenter;
+    mutable glm::vec3 m_WorldExtents;
+    mutable float m_WorldRadius;
+    mutable bool m_WorldBoundsDirty;
+    mutable const Mesh* m_WorldBoundsMesh;
+
+    void UpdateWorldBounds() const;
+    void SetMeshScale(const glm::vec3& meshScale);
+
     // Setup OpenGL resources after updating vertices/indices
     void SetupMesh();
 
+    // Shared mesh lookup for generators whose output only depends on their parameters,
+    // the vertex format and optimization setting are added to the key
+    bool UseCachedMesh(const std::string& key);
+    void SetupCachedMesh(const std::string& key);
+
 public:
     // Constructor with default values
     Shape();
@@ -49,23 +80,51 @@ public:
     virtual void Generate() = 0;         // Generate mesh data
     virtual void Update() = 0;           // Update mesh after parameter changes
 
+    // Build a chain of coarser meshes, shapes without a resolution keep a single level
+    virtual void GenerateLODs(unsigned int levelCount);
+    void ClearLODs();
+
+    // Pick the coarsest level whose projected error stays under maxPixelError,
+    // returns true when the level changed
+    bool SelectLOD(const Camera& camera, float viewportHeight, float maxPixelError = 1.0f);
+    unsigned int GetLODCount() const { return m_LODMeshes.size(); }
+    unsigned int GetCurrentLOD() const { return m_CurrentLOD; }
+
     // Transformation methods
     void SetPosition(const glm::vec3& position);
     void SetRotation(const glm::vec3& rotation);
     void SetScale(const glm::vec3& scale);
     glm::mat4 GetModelMatrix() const;
 
+    // World space bounding box (center / half extents) and sphere of the current mesh
+    glm::vec3 GetWorldBoundsCenter() const;
+    glm::vec3 GetWorldBoundsExtents() const;
+    glm::vec3 GetWorldBoundsMin() const { return GetWorldBoundsCenter() - GetWorldBoundsExtents(); }
+    glm::vec3 GetWorldBoundsMax() const { return GetWorldBoundsCenter() + GetWorldBoundsExtents(); }
+    float GetWorldBoundingRadius() const;
+
     // Rendering settings
     void ToggleWireframe();
     bool IsWireframe() const;
 
-    // Get mesh data for rendering
+    // Compressed formats need a shader that decodes them (res/shaders/Compressed3D.shader)
+    void SetVertexFormat(VertexFormat format);
+    VertexFormat GetVertexFormat() const { return m_VertexFormat; }
+    unsigned int GetGPUBufferSize() const;
+
+    // Run the MeshOptimizer passes on m_Vertices/m_Indices every time the mesh is uploaded
+    void SetMeshOptimization(bool enabled);
+    bool IsMeshOptimized() const { return m_OptimizeMesh; }
+    const MeshOptimizationReport& GetOptimizationReport() const { return m_OptimizationReport; }
+
+    // Get mesh data for rendering (in mesh space, before m_MeshScale)
     const std::vector<float>& GetVertices() const;
     const std::vector<unsigned int>& GetIndices() const;
     unsigned int GetVertexCount() const;
     unsigned int GetIndexCount() const;
     
     glm::vec3 GetPosition() const { return m_Position; }
+    std::shared_ptr<Mesh> GetMesh() const { return m_Mesh; }
     // Bind for rendering
     void Bind() const;
     void Unbind() const;
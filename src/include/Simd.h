@@ -0,0 +1,16 @@
+#pragma once
+
+// SIMD instruction sets available at compile time
+// MSVC only defines __AVX__ (with /arch:AVX or higher, OpenGL.vcxproj sets /arch:AVX2) and never __SSE2__, so x64 / _M_IX86_FP
+// are checked too
+#if defined(__AVX__)
+#define SIMD_AVX 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SSE 1
+#endif
+
+#if defined(SIMD_AVX) || defined(SIMD_SSE)
+#include <immintrin.h>
+#endif
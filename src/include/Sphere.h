@@ -10,6 +10,14 @@ private:
     unsigned int m_Stacks;     // Latitude divisions
     bool m_FlatShading;        // Flat or smooth shading
 
+    // MeshCache key of the generator parameters (radius is a scale, not part of it)
+    std::string GetMeshKey(unsigned int sectors, unsigned int stacks, bool flatShading) const;
+
+    // Generate (or share) the unit sphere mesh for a resolution
+    std::shared_ptr<Mesh> GenerateMesh(unsigned int sectors, unsigned int stacks, bool flatShading);
+    void BuildSmoothSphere(unsigned int sectors, unsigned int stacks);
+    void BuildFlatShadedSphere(unsigned int sectors, unsigned int stacks);
+
 public:
     Sphere(float radius = 1.0f, unsigned int sectors = 36, unsigned int stacks = 18);
     ~Sphere() override;
@@ -17,6 +25,7 @@ public:
     // Inherited from Shape
     void Generate() override;
     void Update() override;
+    void GenerateLODs(unsigned int levelCount) override;
 
     // Sphere-specific methods
     void SetRadius(float radius);
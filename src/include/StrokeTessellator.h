@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "BezierCurve.h"
+
+enum class LineJoin
+{
+    Miter,
+    Bevel,
+    Round
+};
+
+enum class LineCap
+{
+    Butt,
+    Square,
+    Round
+};
+
+struct StrokeStyle
+{
+    float Width = 1.0f;
+    LineJoin Join = LineJoin::Miter;
+    LineCap Cap = LineCap::Butt;
+    float MiterLimit = 4.0f;  // Miter length / half width above which a miter becomes a bevel
+    float RoundTolerance = 0.25f; // Max distance between round joins / caps and their true arc
+};
+
+/**
+ * Expands flattened curves into thick triangle strips with joins and caps
+ * Every polyline becomes one strip, strips are separated by s_RestartIndex so the whole
+ * buffer draws with one glDrawElements(GL_TRIANGLE_STRIP) (see Renderer::DrawStrips)
+ */
+class StrokeTessellator
+{
+private:
+    std::vector<float> m_Vertices;       // x, y per vertex, ready for Bezier.shader
+    std::vector<unsigned int> m_Indices; // Strip indices with restart markers
+
+    // Scratch for the polyline being stroked
+    std::vector<glm::vec2> m_Points;
+    std::vector<glm::vec2> m_Normals; // Unit left normal of each segment
+
+    void ComputeNormals();
+    void EmitPair(const glm::vec2& left, const glm::vec2& right);
+    void EmitCap(const glm::vec2& point, const glm::vec2& direction, const glm::vec2& normal, const StrokeStyle& style, bool start);
+    void EmitJoin(unsigned int index, const StrokeStyle& style);
+    unsigned int GetArcSegments(float angle, float halfWidth, const StrokeStyle& style) const;
+
+public:
+    static const unsigned int s_RestartIndex = 0xFFFFFFFF;
+
+    StrokeTessellator();
+    ~StrokeTessellator();
+
+    void Clear();
+
+    // points holds pointCount (x, y) pairs, e.g. BezierCurve::GetCurvePoints
+    void AddPolyline(const float* points, unsigned int pointCount, const StrokeStyle& style);
+    void AddCurve(const BezierCurve& curve, const StrokeStyle& style);
+
+    // Curve major vertices of CubicCurveBatch::Evaluate, pointsPerCurve = resolution + 1
+    void AddPolylines(const std::vector<float>& points, unsigned int pointsPerCurve, const StrokeStyle& style);
+
+    const std::vector<float>& GetVertices() const { return m_Vertices; }
+    const std::vector<unsigned int>& GetIndices() const { return m_Indices; }
+    unsigned int GetVertexCount() const { return m_Vertices.size() / 2; }
+};
@@ -5,6 +5,7 @@ class VertexBuffer
 {
 private:
 	unsigned int m_Render_ID;
+	unsigned int m_Size;
 
 public:
 	VertexBuffer();
@@ -13,4 +14,10 @@ public:
 
 	void Bind() const;
 	void Unbind() const;
+
+	// Reallocate the whole buffer for data that keeps changing
+	void SetData(const void* data, unsigned int size);
+	// Patch [offset, offset + size) in place, the range must fit in the current buffer
+	void UpdateData(const void* data, unsigned int offset, unsigned int size);
+	unsigned int GetSize() const { return m_Size; }
 };
@@ -14,13 +14,27 @@ struct VertexBufferElement {
         {
             case GL_FLOAT: return 4;
             case GL_UNSIGNED_INT: return 4;
+            case GL_SHORT: return 2;
+            case GL_UNSIGNED_SHORT: return 2;
             case GL_BYTE: return 1;
+            case GL_UNSIGNED_BYTE: return 1;
+            case GL_INT_2_10_10_10_REV: return 4;
         }
         ASSERT(false);
         return 0;
     }
+
+    // Size of the whole attribute, packed types hold every component in a single word
+    unsigned int getSize() const {
+        if (type == GL_INT_2_10_10_10_REV)
+            return getSizeType(type);
+        return count * getSizeType(type);
+    }
 };
 
+// Tag type for a signed normalized 2_10_10_10 attribute (x, y, z in 10 bits, w in 2 bits)
+struct PackedInt2101010 {};
+
 class VertexBufferLayout
 {
 private:
@@ -59,6 +73,25 @@ public:
 
     }
 
+    template<>
+    void Push<short>(unsigned int count) {
+        m_Elements.push_back({ GL_SHORT, (unsigned int)count, GL_TRUE });
+        m_Stride += count * VertexBufferElement::getSizeType(GL_SHORT);
+    }
+
+    template<>
+    void Push<unsigned short>(unsigned int count) {
+        m_Elements.push_back({ GL_UNSIGNED_SHORT, (unsigned int)count, GL_TRUE });
+        m_Stride += count * VertexBufferElement::getSizeType(GL_UNSIGNED_SHORT);
+    }
+
+    template<>
+    void Push<PackedInt2101010>(unsigned int count) {
+        ASSERT(count == 4);
+        m_Elements.push_back({ GL_INT_2_10_10_10_REV, (unsigned int)count, GL_TRUE });
+        m_Stride += VertexBufferElement::getSizeType(GL_INT_2_10_10_10_REV);
+    }
+
     inline const std::vector<VertexBufferElement> GetElements() const { return m_Elements; }
     inline unsigned int GetStride() const { return m_Stride; }
 
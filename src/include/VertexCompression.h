@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "VertexBufferLayout.h"
+
+/**
+ * Vertex formats a Shape can upload its position + normal data with
+ * The CPU copy always stays as 6 floats per vertex, only the GPU buffer changes
+ */
+enum class VertexFormat
+{
+    Float,      // 3 x float position, 3 x float normal            (24 bytes)
+    Quantized,  // 4 x unorm16 position, 2 x snorm16 octahedral normal (12 bytes)
+    Packed      // 2_10_10_10 snorm position, 2 x snorm16 octahedral normal (8 bytes)
+};
+
+/**
+ * GPU ready vertex data in one of the compressed formats
+ * Positions are quantized to the mesh bounds and are decoded in the vertex shader as
+ * position = PositionOffset + attribute * PositionScale
+ */
+struct CompressedVertexData
+{
+    std::vector<unsigned char> Data;
+    VertexBufferLayout Layout;
+    glm::vec3 PositionOffset;
+    glm::vec3 PositionScale;
+};
+
+// Size in bytes of one vertex in the given format
+unsigned int GetVertexFormatStride(VertexFormat format);
+
+// Compress interleaved (x, y, z, nx, ny, nz) float vertices
+CompressedVertexData CompressVertices(const std::vector<float>& vertices, VertexFormat format);
+
+// Octahedral mapping of a unit vector to the [-1, 1] square and back
+glm::vec2 OctahedralEncode(const glm::vec3& normal);
+glm::vec3 OctahedralDecode(const glm::vec2& encoded);